@@ -10,9 +10,14 @@
 #include "mcp_server.h"
 #include "assets.h"
 #include "settings.h"
+#include "http_pool.h"
+#include "server_message.h"
 
 #include <cstring>
+#include <array>
+#include <algorithm>
 #include <esp_log.h>
+#include <esp_random.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
 #include <arpa/inet.h>
@@ -74,9 +79,16 @@ void Application::Initialize() {
     audio_service_.Initialize(codec);
     audio_service_.Start();
 
+    // Uplink audio is sent from a dedicated task, so UI work in the main loop does not delay it
+    xTaskCreate([](void* arg) {
+        Application* app = (Application*)arg;
+        app->AudioSenderTask();
+        vTaskDelete(NULL);
+    }, "audio_sender", 4096, this, 11, &audio_sender_task_handle_);
+
     AudioServiceCallbacks callbacks;
     callbacks.on_send_queue_available = [this]() {
-        xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+        xTaskNotifyGive(audio_sender_task_handle_);
     };
     callbacks.on_wake_word_detected = [this](const std::string& wake_word) {
         ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
@@ -85,6 +97,13 @@ void Application::Initialize() {
     callbacks.on_vad_change = [this](bool speaking) {
         xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
     };
+    callbacks.on_uplink_gate_change = [this](bool open) {
+        Schedule([this, open]() {
+            if (protocol_ && protocol_->IsAudioChannelOpened()) {
+                protocol_->SendVoiceActivity(open);
+            }
+        });
+    };
     audio_service_.SetCallbacks(callbacks);
 
     // Add state change listeners
@@ -170,7 +189,6 @@ void Application::Run() {
 
     const EventBits_t ALL_EVENTS = 
         MAIN_EVENT_SCHEDULE |
-        MAIN_EVENT_SEND_AUDIO |
         MAIN_EVENT_WAKE_WORD_DETECTED |
         MAIN_EVENT_VAD_CHANGE |
         MAIN_EVENT_CLOCK_TICK |
@@ -219,14 +237,6 @@ void Application::Run() {
             HandleStopListeningEvent();
         }
 
-        if (bits & MAIN_EVENT_SEND_AUDIO) {
-            while (auto packet = audio_service_.PopPacketFromSendQueue()) {
-                if (protocol_ && !protocol_->SendAudio(std::move(packet))) {
-                    break;
-                }
-            }
-        }
-
         if (bits & MAIN_EVENT_WAKE_WORD_DETECTED) {
             HandleWakeWordDetectedEvent();
         }
@@ -240,11 +250,16 @@ void Application::Run() {
 
         if (bits & MAIN_EVENT_SCHEDULE) {
             std::unique_lock<std::mutex> lock(mutex_);
-            auto tasks = std::move(main_tasks_);
+            running_tasks_.swap(main_tasks_);
             lock.unlock();
-            for (auto& task : tasks) {
-                task();
+            for (auto& task : running_tasks_) {
+                if (task) {
+                    task();
+                } else {
+                    HandleNextServerEvent();
+                }
             }
+            running_tasks_.clear();
         }
 
         if (bits & MAIN_EVENT_CLOCK_TICK) {
@@ -255,11 +270,45 @@ void Application::Run() {
             // Print debug info every 10 seconds
             if (clock_ticks_ % 10 == 0) {
                 SystemInfo::PrintHeapStats();
+
+                auto statistics = audio_service_.GetSendQueueStatistics(true);
+                if (statistics.sent_packets > 0 || statistics.dropped_packets > 0) {
+                    uint32_t count = statistics.sent_packets + statistics.dropped_packets;
+                    ESP_LOGI(TAG, "Audio sender: sent %lu, dropped %lu, queue latency avg %lu us, max %lu us",
+                        statistics.sent_packets, statistics.dropped_packets,
+                        (uint32_t)(statistics.total_latency_us / count), statistics.max_latency_us);
+                }
             }
         }
     }
 }
 
+void Application::AudioSenderTask() {
+    std::vector<std::unique_ptr<AudioStreamPacket>> packets;
+    packets.reserve(MAX_SEND_PACKETS_IN_QUEUE);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (audio_service_.PopPacketsFromSendQueue(packets) == 0) {
+            continue;
+        }
+
+        size_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(protocol_mutex_);
+            for (auto& packet : packets) {
+                // Once a send fails the channel is gone, the rest of the batch is dropped
+                if (dropped > 0 || !protocol_ || !protocol_->SendAudio(std::move(packet))) {
+                    dropped++;
+                }
+            }
+        }
+        packets.clear();
+        if (dropped > 0) {
+            audio_service_.CountSendQueueDrops(dropped);
+        }
+    }
+}
+
 void Application::HandleNetworkConnectedEvent() {
     ESP_LOGI(TAG, "Network connected");
     auto state = GetDeviceState();
@@ -288,7 +337,9 @@ void Application::HandleNetworkConnectedEvent() {
 void Application::HandleNetworkDisconnectedEvent() {
     // Close current conversation when network disconnected
     auto state = GetDeviceState();
-    if (state == kDeviceStateConnecting || state == kDeviceStateListening || state == kDeviceStateSpeaking) {
+    if (state == kDeviceStateConnecting) {
+        CancelSession();
+    } else if (state == kDeviceStateListening || state == kDeviceStateSpeaking) {
         ESP_LOGI(TAG, "Closing audio channel due to network disconnection");
         protocol_->CloseAudioChannel();
     }
@@ -304,6 +355,12 @@ void Application::HandleActivationDoneEvent() {
     SystemInfo::PrintHeapStats();
     SetDeviceState(kDeviceStateIdle);
 
+    if (activation_bound_time_ > 0) {
+        ESP_LOGI(TAG, "Ready %d ms after binding", int((esp_timer_get_time() - activation_bound_time_) / 1000));
+        activation_bound_time_ = 0;
+    }
+    ESP_LOGI(TAG, "Activation requests: %d check version, %d activate",
+        ota_->GetCheckVersionCount(), ota_->GetActivateCount());
     has_server_time_ = ota_->HasServerTime();
 
     auto display = Board::GetInstance().GetDisplay();
@@ -330,6 +387,9 @@ void Application::ActivationTask() {
     // Check for new firmware version
     CheckNewVersion();
 
+    // The protocol may need the socket held by an idle OTA connection
+    HttpPool::GetInstance().Clear();
+
     // Initialize the protocol
     InitializeProtocol();
 
@@ -399,6 +459,8 @@ void Application::CheckNewVersion() {
     const int MAX_RETRY = 10;
     int retry_count = 0;
     int retry_delay = 10; // Initial retry delay in seconds
+    int backoff_ms = ACTIVATION_BACKOFF_MIN_MS;
+    bool activating = false;
 
     auto& board = Board::GetInstance();
     while (true) {
@@ -433,7 +495,8 @@ void Application::CheckNewVersion() {
         retry_delay = 10; // Reset retry delay
 
         if (ota_->HasNewVersion()) {
-            if (UpgradeFirmware(ota_->GetFirmwareUrl(), ota_->GetFirmwareVersion())) {
+            if (UpgradeFirmware(ota_->GetFirmwareUrl(), ota_->GetFirmwareVersion(), ota_->GetFirmwareSha256(),
+                    ota_->GetDeltaUrl(), ota_->GetDeltaSha256())) {
                 return; // This line will never be reached after reboot
             }
             // If upgrade failed, continue to normal operation
@@ -442,9 +505,13 @@ void Application::CheckNewVersion() {
         // No new version, mark the current version as valid
         ota_->MarkCurrentVersionValid();
         if (!ota_->HasActivationCode() && !ota_->HasActivationChallenge()) {
+            if (activating && activation_bound_time_ == 0) {
+                activation_bound_time_ = esp_timer_get_time();
+            }
             // Exit the loop if done checking new version
             break;
         }
+        activating = true;
 
         display->SetStatus(Lang::Strings::ACTIVATION);
         // Activation code is shown to the user and waiting for the user to input
@@ -456,23 +523,58 @@ void Application::CheckNewVersion() {
             ShowActivationCode(ota_->GetActivationCode(), ota_->GetActivationMessage());
         }
 
-        // This will block the loop until the activation is done or timeout
+        // Without a challenge only the version check can tell that binding is complete
+        if (!ota_->HasActivationChallenge()) {
+            if (WaitActivationRetry(backoff_ms)) {
+                backoff_ms = std::min(backoff_ms * 2, ACTIVATION_BACKOFF_MAX_MS);
+            } else {
+                backoff_ms = ACTIVATION_BACKOFF_MIN_MS;
+            }
+            continue;
+        }
+
+        // Activate is a long poll, so a request the server held for its full timeout is
+        // repeated at once. Errors and early answers back off, spreading out a batch of
+        // devices that were powered on together.
         for (int i = 0; i < 10; ++i) {
             ESP_LOGI(TAG, "Activating... %d/%d", i + 1, 10);
+            auto start_time = esp_timer_get_time();
             esp_err_t err = ota_->Activate();
             if (err == ESP_OK) {
+                activation_bound_time_ = esp_timer_get_time();
                 PlaySound(Lang::Sounds::OGG_WELCOME);        
                 break;
-            } else if (err == ESP_ERR_TIMEOUT) {
-                vTaskDelay(pdMS_TO_TICKS(1000));
-            } else {
-                vTaskDelay(pdMS_TO_TICKS(10000));
             }
-            if (GetDeviceState() == kDeviceStateIdle) {
+            int elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
+            if (err == ESP_ERR_TIMEOUT && elapsed_ms >= ota_->GetActivationTimeoutMs() / 2) {
+                backoff_ms = ACTIVATION_BACKOFF_MIN_MS;
+                continue;
+            }
+            if (!WaitActivationRetry(backoff_ms)) {
+                // Restart from the version check
+                backoff_ms = ACTIVATION_BACKOFF_MIN_MS;
                 break;
             }
+            backoff_ms = std::min(backoff_ms * 2, ACTIVATION_BACKOFF_MAX_MS);
+        }
+    }
+}
+
+// Waits with up to 25% random jitter, returns false if cut short to restart the activation check
+bool Application::WaitActivationRetry(int delay_ms) {
+    delay_ms += esp_random() % (delay_ms / 4 + 1);
+    ESP_LOGI(TAG, "Retry activation in %d ms", delay_ms);
+    // Only a change to idle during this wait counts, otherwise an idle device would poll every second
+    bool was_idle = GetDeviceState() == kDeviceStateIdle;
+    while (delay_ms > 0) {
+        int step = std::min(delay_ms, 1000);
+        vTaskDelay(pdMS_TO_TICKS(step));
+        delay_ms -= step;
+        if (!was_idle && GetDeviceState() == kDeviceStateIdle) {
+            return false;
         }
     }
+    return true;
 }
 
 void Application::InitializeProtocol() {
@@ -482,23 +584,25 @@ void Application::InitializeProtocol() {
 
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
 
-    if (ota_->HasMqttConfig()) {
-        protocol_ = std::make_unique<MqttProtocol>();
-    #ifdef MQTT_SIP_PROTOCOL_ENABLED
-        protocol_ = std::make_unique<SipMqttProtocol>();
-    #else
-        protocol_ = std::make_unique<MqttProtocol>();
-    #endif         
-    } else if (ota_->HasWebsocketConfig()) {
-        protocol_ = std::make_unique<WebsocketProtocol>();
-    } else {
-        ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
-    #ifdef MQTT_SIP_PROTOCOL_ENABLED
-        protocol_ = std::make_unique<SipMqttProtocol>();
-    #else
-        protocol_ = std::make_unique<MqttProtocol>();
-    #endif    
-        
+    {
+        // The audio sender task reads protocol_ under this lock
+        std::lock_guard<std::mutex> lock(protocol_mutex_);
+        if (ota_->HasMqttConfig()) {
+        #ifdef MQTT_SIP_PROTOCOL_ENABLED
+            protocol_ = std::make_unique<SipMqttProtocol>();
+        #else
+            protocol_ = std::make_unique<MqttProtocol>();
+        #endif         
+        } else if (ota_->HasWebsocketConfig()) {
+            protocol_ = std::make_unique<WebsocketProtocol>();
+        } else {
+            ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
+        #ifdef MQTT_SIP_PROTOCOL_ENABLED
+            protocol_ = std::make_unique<SipMqttProtocol>();
+        #else
+            protocol_ = std::make_unique<MqttProtocol>();
+        #endif    
+        }
     }
 
     protocol_->OnConnected([this]() {
@@ -509,6 +613,10 @@ void Application::InitializeProtocol() {
         last_error_message_ = message;
         xEventGroupSetBits(event_group_, MAIN_EVENT_ERROR);
     });
+
+    protocol_->OnSessionOriginated([this](bool success) {
+        HandleSessionOriginated(success);
+    });
     
     protocol_->OnIncomingAudio([this](std::unique_ptr<AudioStreamPacket> packet) {
         if (GetDeviceState() == kDeviceStateSpeaking) {
@@ -538,53 +646,52 @@ void Application::InitializeProtocol() {
     protocol_->OnIncomingJson([this, display](const cJSON* root) {
         // Parse JSON data
         auto type = cJSON_GetObjectItem(root, "type");
-        if (strcmp(type->valuestring, "tts") == 0) {
+        if (!cJSON_IsString(type)) {
+            ESP_LOGW(TAG, "Missing message type");
+            return;
+        }
+        switch (LookupServerMessage(type->valuestring)) {
+        case kServerMessageTts: {
             auto state = cJSON_GetObjectItem(root, "state");
+            if (!cJSON_IsString(state)) {
+                break;
+            }
             if (strcmp(state->valuestring, "start") == 0) {
-                Schedule([this]() {
-                    aborted_ = false;
-                    SetDeviceState(kDeviceStateSpeaking);
-                });
+                PostServerEvent(kServerEventTtsStart);
             } else if (strcmp(state->valuestring, "stop") == 0) {
-                Schedule([this]() {
-                    if (GetDeviceState() == kDeviceStateSpeaking) {
-                        if (listening_mode_ == kListeningModeManualStop) {
-                            SetDeviceState(kDeviceStateIdle);
-                        } else {
-                            SetDeviceState(kDeviceStateListening);
-                        }
-                    }
-                });
+                PostServerEvent(kServerEventTtsStop);
             } else if (strcmp(state->valuestring, "sentence_start") == 0) {
                 auto text = cJSON_GetObjectItem(root, "text");
                 if (cJSON_IsString(text)) {
                     ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
-                    });
+                    PostServerEvent(kServerEventAssistantText, text->valuestring);
                 }
             }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
+            break;
+        }
+        case kServerMessageStt: {
             auto text = cJSON_GetObjectItem(root, "text");
             if (cJSON_IsString(text)) {
                 ESP_LOGI(TAG, ">> %s", text->valuestring);
-                Schedule([display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str());
-                });
+                PostServerEvent(kServerEventUserText, text->valuestring);
             }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
+            break;
+        }
+        case kServerMessageLlm: {
             auto emotion = cJSON_GetObjectItem(root, "emotion");
             if (cJSON_IsString(emotion)) {
-                Schedule([display, emotion_str = std::string(emotion->valuestring)]() {
-                    display->SetEmotion(emotion_str.c_str());
-                });
+                PostServerEvent(kServerEventEmotion, emotion->valuestring);
             }
-        } else if (strcmp(type->valuestring, "mcp") == 0) {
+            break;
+        }
+        case kServerMessageMcp: {
             auto payload = cJSON_GetObjectItem(root, "payload");
             if (cJSON_IsObject(payload)) {
                 McpServer::GetInstance().ParseMessage(payload);
             }
-        } else if (strcmp(type->valuestring, "system") == 0) {
+            break;
+        }
+        case kServerMessageSystem: {
             auto command = cJSON_GetObjectItem(root, "command");
             if (cJSON_IsString(command)) {
                 ESP_LOGI(TAG, "System command: %s", command->valuestring);
@@ -597,7 +704,9 @@ void Application::InitializeProtocol() {
                     ESP_LOGW(TAG, "Unknown system command: %s", command->valuestring);
                 }
             }
-        } else if (strcmp(type->valuestring, "alert") == 0) {
+            break;
+        }
+        case kServerMessageAlert: {
             auto status = cJSON_GetObjectItem(root, "status");
             auto message = cJSON_GetObjectItem(root, "message");
             auto emotion = cJSON_GetObjectItem(root, "emotion");
@@ -606,8 +715,10 @@ void Application::InitializeProtocol() {
             } else {
                 ESP_LOGW(TAG, "Alert command requires status, message and emotion");
             }
+            break;
+        }
 #if CONFIG_RECEIVE_CUSTOM_MESSAGE
-        } else if (strcmp(type->valuestring, "custom") == 0) {
+        case kServerMessageCustom: {
             auto payload = cJSON_GetObjectItem(root, "payload");
             ESP_LOGI(TAG, "Received custom message: %s", cJSON_PrintUnformatted(root));
             if (cJSON_IsObject(payload)) {
@@ -617,9 +728,12 @@ void Application::InitializeProtocol() {
             } else {
                 ESP_LOGW(TAG, "Invalid custom message format: missing payload");
             }
+            break;
+        }
 #endif
-        } else {
+        default:
             ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
+            break;
         }
     });
     
@@ -710,14 +824,11 @@ void Application::HandleToggleChatEvent() {
     }
 
     if (state == kDeviceStateIdle) {
-        if (!protocol_->IsAudioChannelOpened()) {
-            SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OriginateSession()) {
-                return;
-            }
-        }
-
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+        StartSession("", [this]() {
+            SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+        });
+    } else if (state == kDeviceStateConnecting) {
+        CancelSession();
     } else if (state == kDeviceStateSpeaking) {
         AbortSpeaking(kAbortReasonNone);
     } else if (state == kDeviceStateListening) {
@@ -743,14 +854,9 @@ void Application::HandleStartListeningEvent() {
     }
     
     if (state == kDeviceStateIdle) {
-        if (!protocol_->IsAudioChannelOpened()) {
-            SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OriginateSession()) {
-                return;
-            }
-        }
-
-        SetListeningMode(kListeningModeManualStop);
+        StartSession("", [this]() {
+            SetListeningMode(kListeningModeManualStop);
+        });
     } else if (state == kDeviceStateSpeaking) {
         AbortSpeaking(kAbortReasonNone);
         SetListeningMode(kListeningModeManualStop);
@@ -764,6 +870,9 @@ void Application::HandleStopListeningEvent() {
         audio_service_.EnableAudioTesting(false);
         SetDeviceState(kDeviceStateWifiConfiguring);
         return;
+    } else if (state == kDeviceStateConnecting) {
+        // Released before the session was ready
+        CancelSession();
     } else if (state == kDeviceStateListening) {
         if (protocol_) {
             protocol_->SendStopListening();
@@ -782,28 +891,23 @@ void Application::HandleWakeWordDetectedEvent() {
     if (state == kDeviceStateIdle) {
         audio_service_.EncodeWakeWord();
         auto wake_word = audio_service_.GetLastWakeWord();
-        if (!protocol_->IsAudioChannelOpened()) {
-            SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OriginateSession(wake_word)) {
-                audio_service_.EnableWakeWordDetection(true);
-                return;
-            }
-        }
-        ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
+        StartSession(wake_word, [this, wake_word]() {
+            ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
 #if CONFIG_SEND_WAKE_WORD_DATA
-        // Encode and send the wake word data to the server
-        while (auto packet = audio_service_.PopWakeWordPacket()) {
-            protocol_->SendAudio(std::move(packet));
-        }
-        // Set the chat state to wake word detected
-        protocol_->SendWakeWordDetected(wake_word);
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+            // Encode and send the wake word data to the server
+            while (auto packet = audio_service_.PopWakeWordPacket()) {
+                protocol_->SendAudio(std::move(packet));
+            }
+            // Set the chat state to wake word detected
+            protocol_->SendWakeWordDetected(wake_word);
+            SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
 #else
-        // Set flag to play popup sound after state changes to listening
-        // (PlaySound here would be cleared by ResetDecoder in EnableVoiceProcessing)
-        play_popup_on_listening_ = true;
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+            // Set flag to play popup sound after state changes to listening
+            // (PlaySound here would be cleared by ResetDecoder in EnableVoiceProcessing)
+            play_popup_on_listening_ = true;
+            SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
 #endif
+        });
     } else if (state == kDeviceStateSpeaking) {
         AbortSpeaking(kAbortReasonWakeWordDetected);
     } else if (state == kDeviceStateActivating) {
@@ -837,6 +941,10 @@ void Application::HandleStateChangedEvent() {
         case kDeviceStateListening:
             display->SetStatus(Lang::Strings::LISTENING);
             display->SetEmotion("neutral");
+            if (session_start_time_ != 0) {
+                ESP_LOGI(TAG, "Time to listening: %d ms", (int)((esp_timer_get_time() - session_start_time_) / 1000));
+                session_start_time_ = 0;
+            }
 
             // Make sure the audio processor is running
             if (!audio_service_.IsAudioProcessorRunning()) {
@@ -851,6 +959,9 @@ void Application::HandleStateChangedEvent() {
                 audio_service_.EnableVoiceProcessing(true);
                 audio_service_.EnableWakeWordDetection(false);
             }
+            // In auto mode the server VAD needs the silence to end the turn, so the gate is only used in
+            // realtime and manual modes
+            audio_service_.EnableUplinkGate(listening_mode_ != kListeningModeAutoStop);
 
             // Play popup sound after ResetDecoder (in EnableVoiceProcessing) has been called
             if (play_popup_on_listening_) {
@@ -886,6 +997,95 @@ void Application::Schedule(std::function<void()>&& callback) {
     xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
 }
 
+void Application::PostServerEvent(ServerEventType type, const char* text) {
+    size_t len = text != nullptr ? strlen(text) : 0;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (server_event_count_ < server_events_.size()) {
+            auto& event = server_events_[(server_event_head_ + server_event_count_) % server_events_.size()];
+            if (len >= sizeof(event.text)) {
+                // Do not cut a multi-byte character in half
+                len = sizeof(event.text) - 1;
+                while (len > 0 && ((uint8_t)text[len] & 0xC0) == 0x80) {
+                    len--;
+                }
+            }
+            event.type = type;
+            memcpy(event.text, text != nullptr ? text : "", len);
+            event.text[len] = '\0';
+            server_event_count_++;
+            // The marker keeps the event in order with the tasks scheduled around it
+            main_tasks_.emplace_back();
+            queued = true;
+        }
+    }
+    if (queued) {
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+        return;
+    }
+
+    // The main task is far behind, fall back to a scheduled task instead of dropping the event,
+    // it still runs after everything posted before it
+    ESP_LOGW(TAG, "Server event queue full, scheduling event %d", type);
+    Schedule([this, type, message = std::string(text != nullptr ? text : "")]() {
+        HandleServerEvent(type, message.c_str());
+    });
+}
+
+void Application::HandleNextServerEvent() {
+    const ServerEvent* event;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (server_event_count_ == 0) {
+            return;
+        }
+        event = &server_events_[server_event_head_];
+    }
+    HandleServerEvent(event->type, event->text);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        server_event_head_ = (server_event_head_ + 1) % server_events_.size();
+        server_event_count_--;
+    }
+}
+
+void Application::HandleServerEvent(ServerEventType type, const char* text) {
+    auto display = Board::GetInstance().GetDisplay();
+    switch (type) {
+    case kServerEventTtsStart:
+        aborted_ = false;
+        SetDeviceState(kDeviceStateSpeaking);
+        break;
+    case kServerEventTtsStartFromIdle: {
+        aborted_ = false;
+        auto state = GetDeviceState();
+        if (state == kDeviceStateIdle || state == kDeviceStateListening) {
+            SetDeviceState(kDeviceStateSpeaking);
+        }
+        break;
+    }
+    case kServerEventTtsStop:
+        if (GetDeviceState() == kDeviceStateSpeaking) {
+            if (listening_mode_ == kListeningModeManualStop) {
+                SetDeviceState(kDeviceStateIdle);
+            } else {
+                SetDeviceState(kDeviceStateListening);
+            }
+        }
+        break;
+    case kServerEventAssistantText:
+        display->SetChatMessage("assistant", text);
+        break;
+    case kServerEventUserText:
+        display->SetChatMessage("user", text);
+        break;
+    case kServerEventEmotion:
+        display->SetEmotion(text);
+        break;
+    }
+}
+
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     aborted_ = true;
@@ -899,20 +1099,67 @@ void Application::SetListeningMode(ListeningMode mode) {
     SetDeviceState(kDeviceStateListening);
 }
 
+void Application::StartSession(const std::string& wake_word, std::function<void()>&& on_ready) {
+    session_start_time_ = esp_timer_get_time();
+    if (protocol_->IsAudioChannelOpened()) {
+        on_ready();
+        return;
+    }
+
+    SetDeviceState(kDeviceStateConnecting);
+    // The protocol reports the result through OnSessionOriginated, the main loop keeps running meanwhile
+    on_session_ready_ = std::move(on_ready);
+    if (!protocol_->OriginateSession(wake_word)) {
+        on_session_ready_ = nullptr;
+        session_start_time_ = 0;
+        SetDeviceState(kDeviceStateIdle);
+    }
+}
+
+void Application::HandleSessionOriginated(bool success) {
+    auto on_ready = std::move(on_session_ready_);
+    on_session_ready_ = nullptr;
+    if (GetDeviceState() != kDeviceStateConnecting || on_ready == nullptr) {
+        ESP_LOGW(TAG, "Session originated but no longer connecting, ignored");
+        return;
+    }
+
+    if (!success) {
+        session_start_time_ = 0;
+        SetDeviceState(kDeviceStateIdle);
+        return;
+    }
+    on_ready();
+}
+
+void Application::CancelSession() {
+    ESP_LOGI(TAG, "Cancel session setup");
+    on_session_ready_ = nullptr;
+    session_start_time_ = 0;
+    if (protocol_) {
+        protocol_->CancelSession();
+    }
+    SetDeviceState(kDeviceStateIdle);
+}
+
 void Application::Reboot() {
     ESP_LOGI(TAG, "Rebooting...");
     // Disconnect the audio channel
     if (protocol_ && protocol_->IsAudioChannelOpened()) {
         protocol_->CloseAudioChannel();
     }
-    protocol_.reset();
+    {
+        std::lock_guard<std::mutex> lock(protocol_mutex_);
+        protocol_.reset();
+    }
     audio_service_.Stop();
 
     vTaskDelay(pdMS_TO_TICKS(1000));
     esp_restart();
 }
 
-bool Application::UpgradeFirmware(const std::string& url, const std::string& version) {
+bool Application::UpgradeFirmware(const std::string& url, const std::string& version, const std::string& sha256,
+    const std::string& delta_url, const std::string& delta_sha256) {
     auto& board = Board::GetInstance();
     auto display = board.GetDisplay();
 
@@ -944,7 +1191,7 @@ bool Application::UpgradeFirmware(const std::string& url, const std::string& ver
             snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress, speed / 1024);
             display->SetChatMessage("system", buffer);
         }).detach();
-    });
+    }, sha256, delta_url, delta_sha256);
 
     if (!upgrade_success) {
         // Upgrade failed, restart audio service and continue running
@@ -974,29 +1221,23 @@ void Application::WakeWordInvoke(const std::string& wake_word) {
     if (state == kDeviceStateIdle) {
         audio_service_.EncodeWakeWord();
 
-        if (!protocol_->IsAudioChannelOpened()) {
-            SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OriginateSession(wake_word)) {
-                audio_service_.EnableWakeWordDetection(true);
-                return;
-            }
-        }
-
-        ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
+        StartSession(wake_word, [this, wake_word]() {
+            ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
 #if CONFIG_USE_AFE_WAKE_WORD || CONFIG_USE_CUSTOM_WAKE_WORD
-        // Encode and send the wake word data to the server
-        while (auto packet = audio_service_.PopWakeWordPacket()) {
-            protocol_->SendAudio(std::move(packet));
-        }
-        // Set the chat state to wake word detected
-        protocol_->SendWakeWordDetected(wake_word);
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+            // Encode and send the wake word data to the server
+            while (auto packet = audio_service_.PopWakeWordPacket()) {
+                protocol_->SendAudio(std::move(packet));
+            }
+            // Set the chat state to wake word detected
+            protocol_->SendWakeWordDetected(wake_word);
+            SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
 #else
-        // Set flag to play popup sound after state changes to listening
-        // (PlaySound here would be cleared by ResetDecoder in EnableVoiceProcessing)
-        play_popup_on_listening_ = true;
-        SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
+            // Set flag to play popup sound after state changes to listening
+            // (PlaySound here would be cleared by ResetDecoder in EnableVoiceProcessing)
+            play_popup_on_listening_ = true;
+            SetListeningMode(aec_mode_ == kAecOff ? kListeningModeAutoStop : kListeningModeRealtime);
 #endif
+        });
     } else if (state == kDeviceStateSpeaking) {
         Schedule([this]() {
             AbortSpeaking(kAbortReasonNone);
@@ -1074,71 +1315,35 @@ void Application::ResetProtocol() {
             protocol_->CloseAudioChannel();
         }
         // Reset protocol
+        std::lock_guard<std::mutex> lock(protocol_mutex_);
         protocol_.reset();
     });
 }
 
 void Application::StartSpeaking(const std::string& message) {
-
-    auto& board = Board::GetInstance();
-    auto display = board.GetDisplay();
-
-    Schedule([this]() {
-        aborted_ = false;
-        auto state = GetDeviceState();
-        if (state == kDeviceStateIdle || state == kDeviceStateListening) {
-            SetDeviceState(kDeviceStateSpeaking);
-        }
-    });
-
-    if (message.empty()) {
-        return;
+    PostServerEvent(kServerEventTtsStartFromIdle);
+    if (!message.empty()) {
+        PostServerEvent(kServerEventAssistantText, message.c_str());
     }
-
-    Schedule([this, display, message]() {
-        display->SetChatMessage("assistant", message.c_str());
-    });
 }
 
 void Application::StopSpeaking() {
-    Schedule([this]() {
-        auto state = GetDeviceState();
-        if (state == kDeviceStateSpeaking) {
-            if (listening_mode_ == kListeningModeManualStop) {
-                SetDeviceState(kDeviceStateIdle);
-            } else {
-                ESP_LOGI(TAG, "*****Receive tts stop Auto-restart listening after speaking");
-                SetDeviceState(kDeviceStateListening);
-            }
-        }
-    });
+    ESP_LOGI(TAG, "*****Receive tts stop");
+    PostServerEvent(kServerEventTtsStop);
 }
 
 void Application::ShowServerAckText(const std::string& message) {
-    auto& board = Board::GetInstance();
-    auto display = board.GetDisplay();
     ESP_LOGI(TAG, "Show server ack text: %s", message.c_str());
-    Schedule([this, display, message]() {
-        display->SetChatMessage("assistant", message.c_str());
-    });
+    PostServerEvent(kServerEventAssistantText, message.c_str());
 }
 
 void Application::ShowUserText(const std::string& message) {
-    auto& board = Board::GetInstance();
-    auto display = board.GetDisplay();
     ESP_LOGI(TAG, "Show user text: %s", message.c_str());
-    Schedule([this, display, message]() {
-        display->SetChatMessage("user", message.c_str());
-    });
+    PostServerEvent(kServerEventUserText, message.c_str());
 }
 
 void Application::ShowEmotion(const std::string& emotion) {
-    auto& board = Board::GetInstance();
-    auto display = board.GetDisplay();
-
-    Schedule([this, display, emotion]() {
-        display->SetEmotion(emotion.c_str());
-    });
+    PostServerEvent(kServerEventEmotion, emotion.c_str());
 }
 
 void Application::ProcMcpMessage(const std::string& message) {
@@ -9,6 +9,7 @@
 #include <string>
 #include <mutex>
 #include <deque>
+#include <array>
 #include <memory>
 
 #include "protocol.h"
@@ -20,7 +21,6 @@
 
 // Main event bits
 #define MAIN_EVENT_SCHEDULE             (1 << 0)
-#define MAIN_EVENT_SEND_AUDIO           (1 << 1)
 #define MAIN_EVENT_WAKE_WORD_DETECTED   (1 << 2)
 #define MAIN_EVENT_VAD_CHANGE           (1 << 3)
 #define MAIN_EVENT_ERROR                (1 << 4)
@@ -33,6 +33,28 @@
 #define MAIN_EVENT_STOP_LISTENING       (1 << 11)
 #define MAIN_EVENT_STATE_CHANGED        (1 << 12)
 
+// Preallocated chat events from the server, longer texts are cut at a UTF-8 boundary
+#define SERVER_EVENT_QUEUE_SIZE         8
+#define SERVER_EVENT_TEXT_SIZE          384
+
+// 激活失败或服务端未保持长轮询时的退避区间
+#define ACTIVATION_BACKOFF_MIN_MS       5000
+#define ACTIVATION_BACKOFF_MAX_MS       60000
+
+enum ServerEventType : uint8_t {
+    kServerEventTtsStart,           // JSON "tts start", always enters speaking
+    kServerEventTtsStartFromIdle,   // SIP adapter, enters speaking only from idle or listening
+    kServerEventTtsStop,
+    kServerEventAssistantText,
+    kServerEventUserText,
+    kServerEventEmotion,
+};
+
+struct ServerEvent {
+    ServerEventType type;
+    char text[SERVER_EVENT_TEXT_SIZE];
+};
+
 
 enum AecMode {
     kAecOff,
@@ -106,7 +128,8 @@ public:
 
     void Reboot();
     void WakeWordInvoke(const std::string& wake_word);
-    bool UpgradeFirmware(const std::string& url, const std::string& version = "");
+    bool UpgradeFirmware(const std::string& url, const std::string& version = "", const std::string& sha256 = "",
+        const std::string& delta_url = "", const std::string& delta_sha256 = "");
     bool CanEnterSleepMode();
     void SendMcpMessage(const std::string& payload);
     void SetAecMode(AecMode mode);
@@ -135,7 +158,15 @@ private:
     ~Application();
 
     std::mutex mutex_;
+    // Scheduled tasks and server events in arrival order, an empty entry stands for the slot at
+    // the head of server_events_. Run() swaps it with running_tasks_, which keeps its storage
     std::deque<std::function<void()>> main_tasks_;
+    std::deque<std::function<void()>> running_tasks_;
+    // Ring of server events, protected by mutex_. The main task reads the slot at the head in
+    // place and frees it afterwards, so a producer never overwrites it meanwhile
+    std::array<ServerEvent, SERVER_EVENT_QUEUE_SIZE> server_events_;
+    size_t server_event_head_ = 0;
+    size_t server_event_count_ = 0;
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
@@ -152,6 +183,11 @@ private:
     bool play_popup_on_listening_ = false;  // Flag to play popup sound after state changes to listening
     int clock_ticks_ = 0;
     TaskHandle_t activation_task_handle_ = nullptr;
+    TaskHandle_t audio_sender_task_handle_ = nullptr;
+    std::mutex protocol_mutex_;  // Guards protocol_ against reset while the audio sender is using it
+    std::function<void()> on_session_ready_;  // Runs in the main task once the session is established
+    int64_t session_start_time_ = 0;
+    int64_t activation_bound_time_ = 0;  // When the server confirmed the binding
 
 
     // Event handlers
@@ -163,16 +199,28 @@ private:
     void HandleNetworkDisconnectedEvent();
     void HandleActivationDoneEvent();
     void HandleWakeWordDetectedEvent();
+    void HandleSessionOriginated(bool success);
+    void HandleNextServerEvent();
+    void HandleServerEvent(ServerEventType type, const char* text);
+
+    // Posts a server event to the main task without allocating
+    void PostServerEvent(ServerEventType type, const char* text = nullptr);
 
     // Activation task (runs in background)
     void ActivationTask();
 
+    // Uplink audio sender task, woken by the audio service when encoded packets are ready
+    void AudioSenderTask();
+
     // Helper methods
     void CheckAssetsVersion();
     void CheckNewVersion();
+    bool WaitActivationRetry(int delay_ms);
     void InitializeProtocol();
     void ShowActivationCode(const std::string& code, const std::string& message);
     void SetListeningMode(ListeningMode mode);
+    void StartSession(const std::string& wake_word, std::function<void()>&& on_ready);
+    void CancelSession();
     
     // State change handler called by state machine
     void OnStateChanged(DeviceState old_state, DeviceState new_state);
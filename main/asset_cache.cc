@@ -0,0 +1,135 @@
+#include "asset_cache.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+#include <cstring>
+
+#define TAG "AssetCache"
+
+
+AssetCache::~AssetCache() {
+    Clear();
+}
+
+bool AssetCache::Lz4Decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size) {
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_size;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                literal_length += b;
+            } while (b == 255);
+        }
+        if (literal_length > (size_t)(iend - ip) || literal_length > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence carries literals only
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+
+        size_t match_length = token & 0x0F;
+        if (match_length == 15) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return false;
+                }
+                b = *ip++;
+                match_length += b;
+            } while (b == 255);
+        }
+        match_length += 4;
+        if (match_length > (size_t)(oend - op)) {
+            return false;
+        }
+
+        // Matches may overlap the bytes being produced, copy forward byte by byte
+        const uint8_t* match = op - offset;
+        if (offset >= match_length) {
+            memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            for (size_t i = 0; i < match_length; i++) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return op == oend;
+}
+
+bool AssetCache::Get(const std::string& name, const uint8_t* data, size_t length, void*& ptr, size_t& size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (entry.name == name) {
+            ptr = entry.data;
+            size = entry.size;
+            return true;
+        }
+    }
+
+    if (length < 4) {
+        ESP_LOGE(TAG, "The compressed asset %s is truncated", name.c_str());
+        return false;
+    }
+    size_t original_size = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+
+    auto buffer = (uint8_t*)heap_caps_malloc(original_size, MALLOC_CAP_SPIRAM);
+    if (buffer == nullptr) {
+        buffer = (uint8_t*)heap_caps_malloc(original_size, MALLOC_CAP_8BIT);
+    }
+    if (buffer == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for asset %s", original_size, name.c_str());
+        return false;
+    }
+
+    auto start_time = esp_timer_get_time();
+    if (!Lz4Decompress(data + 4, length - 4, buffer, original_size)) {
+        ESP_LOGE(TAG, "The compressed asset %s is corrupted", name.c_str());
+        heap_caps_free(buffer);
+        return false;
+    }
+    entries_.push_back(Entry{name, buffer, original_size});
+    total_size_ += original_size;
+    ESP_LOGI(TAG, "Decoded %s: %u -> %u bytes in %d us, %u bytes cached", name.c_str(), length - 4, original_size,
+        int(esp_timer_get_time() - start_time), total_size_);
+
+    ptr = buffer;
+    size = original_size;
+    return true;
+}
+
+void AssetCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        heap_caps_free(entry.data);
+    }
+    entries_.clear();
+    total_size_ = 0;
+}
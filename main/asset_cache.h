@@ -0,0 +1,41 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+
+/**
+ * Decodes LZ4-compressed asset entries on first use and keeps them in PSRAM
+ * until the pack is unmapped. A compressed entry in the pack is "ZL" +
+ * original size (u32 LE) + LZ4 block.
+ * Nothing is evicted: fonts, themes and emoji collections hold the returned
+ * pointers for as long as the pack is mapped, so the cache grows to the
+ * decoded size of every entry used. That is why the packer only compresses
+ * for targets with PSRAM.
+ */
+class AssetCache {
+public:
+    ~AssetCache();
+
+    // data points after the "ZL" prefix
+    bool Get(const std::string& name, const uint8_t* data, size_t length, void*& ptr, size_t& size);
+    void Clear();
+
+    static bool Lz4Decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
+
+private:
+    struct Entry {
+        std::string name;
+        uint8_t* data;
+        size_t size;
+    };
+
+    std::list<Entry> entries_;
+    size_t total_size_ = 0;
+    std::mutex mutex_;
+};
+
+#endif // ASSET_CACHE_H
@@ -1,5 +1,8 @@
 #include "assets.h"
+#include "assets_table.h"
 #include "board.h"
+#include "settings.h"
+#include "download_pipeline.h"
 #include "display.h"
 #include "application.h"
 #include "lvgl_theme.h"
@@ -13,18 +16,16 @@
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <cbin_font.h>
+#include <algorithm>
+#include <cstring>
 
 
 #define TAG "Assets"
 #define PARTITION_LABEL "assets"
-
-struct mmap_assets_table {
-    char asset_name[32];          /*!< Name of the asset */
-    uint32_t asset_size;          /*!< Size of the asset */
-    uint32_t asset_offset;        /*!< Offset of the asset */
-    uint16_t asset_width;         /*!< Width of the asset */
-    uint16_t asset_height;        /*!< Height of the asset */
-};
+// 可选的第二个资源分区，存在时新资源写入非活动分区，下载期间界面资源保持可用
+#define PARTITION_LABEL_B "assets_b"
+// 按 64KB 块提前擦除，比写入前逐个擦除 4KB 扇区快得多
+#define ERASE_AHEAD_SIZE (64 * 1024)
 
 Assets::Assets() {
 #if HAVE_LVGL
@@ -41,7 +42,15 @@ Assets::~Assets() {
 }
 
 bool Assets::FindPartition(Assets* assets) {
-    assets->partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+    const esp_partition_t* partition = nullptr;
+    Settings settings("assets", false);
+    if (settings.GetInt("slot") == 1) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL_B);
+    }
+    if (partition == nullptr) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+    }
+    assets->partition_ = partition;
     if (assets->partition_ == nullptr) {
         ESP_LOGI(TAG, "No assets partition found");
         return false;
@@ -49,6 +58,41 @@ bool Assets::FindPartition(Assets* assets) {
     return true;
 }
 
+/**
+ * 下载或首次启动时完整校验过的分区，在 NVS 中记录分区名、头部校验和与长度。
+ * 每次开始写分区都会递增 generation 并清除记录，写入中断后下次启动会重新完整校验
+ */
+bool Assets::IsPartitionVerified(const esp_partition_t* partition, uint32_t checksum, uint32_t length) {
+    Settings settings("assets", false);
+    return settings.GetInt("verified_gen", -1) == settings.GetInt("generation") &&
+        settings.GetString("verified_part") == partition->label &&
+        (uint32_t)settings.GetInt("verified_sum") == checksum &&
+        (uint32_t)settings.GetInt("verified_len") == length;
+}
+
+void Assets::MarkPartitionVerified(const esp_partition_t* partition, uint32_t checksum, uint32_t length) {
+    Settings settings("assets", true);
+    settings.SetString("verified_part", partition->label);
+    settings.SetInt("verified_sum", checksum);
+    settings.SetInt("verified_len", length);
+    settings.SetInt("verified_gen", settings.GetInt("generation"));
+}
+
+void Assets::ClearPartitionVerified() {
+    Settings settings("assets", true);
+    settings.SetInt("generation", settings.GetInt("generation") + 1);
+    settings.EraseKey("verified_gen");
+}
+
+const esp_partition_t* Assets::GetInactivePartition() {
+    auto partition_a = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+    auto partition_b = esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL_B);
+    if (partition_a == nullptr || partition_b == nullptr) {
+        return nullptr;
+    }
+    return partition_ == partition_b ? partition_a : partition_b;
+}
+
 bool Assets::Apply() {
     return strategy_ ? strategy_->Apply(this) : false;
 }
@@ -128,7 +172,8 @@ uint32_t Assets::LvglStrategy::CalculateChecksum(const char* data, uint32_t leng
 
 bool Assets::LvglStrategy::InitializePartition(Assets* assets) {
     assets->partition_valid_ = false;
-    assets_.clear();
+    table_ = nullptr;
+    table_count_ = 0;
 
     if (!Assets::FindPartition(assets)) {
         return false;
@@ -160,29 +205,43 @@ bool Assets::LvglStrategy::InitializePartition(Assets* assets) {
         return false;
     }
 
-    auto start_time = esp_timer_get_time();
-    uint32_t calculated_checksum = CalculateChecksum(mmap_root_ + 12, stored_len);
-    auto end_time = esp_timer_get_time();
-    ESP_LOGI(TAG, "The checksum calculation time is %d ms", int((end_time - start_time) / 1000));
+    if (Assets::IsPartitionVerified(assets->partition_, stored_chksum, stored_len)) {
+        ESP_LOGI(TAG, "The assets partition %s is already verified, skip checksum", assets->partition_->label);
+    } else {
+        auto start_time = esp_timer_get_time();
+        uint32_t calculated_checksum = CalculateChecksum(mmap_root_ + 12, stored_len);
+        auto end_time = esp_timer_get_time();
+        ESP_LOGI(TAG, "The checksum calculation time is %d ms", int((end_time - start_time) / 1000));
+
+        if (calculated_checksum != stored_chksum) {
+            ESP_LOGE(TAG, "The calculated checksum (0x%lx) does not match the stored checksum (0x%lx)", calculated_checksum, stored_chksum);
+            return false;
+        }
+        Assets::MarkPartitionVerified(assets->partition_, stored_chksum, stored_len);
+    }
 
-    if (calculated_checksum != stored_chksum) {
-        ESP_LOGE(TAG, "The calculated checksum (0x%lx) does not match the stored checksum (0x%lx)", calculated_checksum, stored_chksum);
+    if (stored_files > stored_len / sizeof(mmap_assets_table)) {
+        ESP_LOGE(TAG, "The stored_files (%lu) does not fit in the stored_len (0x%lx)", stored_files, stored_len);
         return false;
     }
 
     checksum_valid_ = true;
 
-    for (uint32_t i = 0; i < stored_files; i++) {
-        auto item = (const mmap_assets_table*)(mmap_root_ + 12 + i * sizeof(mmap_assets_table));
-        auto asset = Asset{
-            .size = static_cast<size_t>(item->asset_size),
-            .offset = static_cast<size_t>(12 + sizeof(mmap_assets_table) * stored_files + item->asset_offset)
-        };
-        assets_[item->asset_name] = asset;
-    }
+    // 直接在映射的文件表上查找，不再复制到 std::map；新的打包脚本按名称排序，旧资源包退回顺序查找
+    table_ = (const mmap_assets_table*)(mmap_root_ + 12);
+    table_count_ = stored_files;
+    table_sorted_ = IsAssetTableSorted(table_, table_count_);
+    ESP_LOGI(TAG, "The assets table has %lu files, %s", stored_files, table_sorted_ ? "sorted" : "unsorted");
     return checksum_valid_;
 }
 
+const mmap_assets_table* Assets::LvglStrategy::FindAsset(const std::string& name) const {
+    if (table_ == nullptr) {
+        return nullptr;
+    }
+    return FindAssetInTable(table_, table_count_, table_sorted_, name);
+}
+
 void Assets::LvglStrategy::UnApplyPartition(Assets* assets) {
     if (mmap_handle_ != 0) {
         esp_partition_munmap(mmap_handle_);
@@ -190,23 +249,29 @@ void Assets::LvglStrategy::UnApplyPartition(Assets* assets) {
         mmap_root_ = nullptr;
     }
     checksum_valid_ = false;
-    assets_.clear();
+    table_ = nullptr;
+    table_count_ = 0;
+    cache_.Clear();
     (void)assets; // Unused parameter
 }
 
 bool Assets::LvglStrategy::GetAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) {
-    auto asset = assets_.find(name);
-    if (asset == assets_.end()) {
+    auto item = FindAsset(name);
+    if (item == nullptr) {
         return false;
     }
-    auto data = (const char*)(mmap_root_ + asset->second.offset);
+    auto data = (const char*)(mmap_root_ + 12 + sizeof(mmap_assets_table) * table_count_ + item->asset_offset);
+    if (data[0] == 'Z' && data[1] == 'L') {
+        // 压缩条目在首次访问时解压，返回的指针会被字体和主题长期持有，直到分区取消映射
+        return cache_.Get(name, (const uint8_t*)(data + 2), item->asset_size, ptr, size);
+    }
     if (data[0] != 'Z' || data[1] != 'Z') {
         ESP_LOGE(TAG, "The asset %s is not valid with magic %02x%02x", name.c_str(), data[0], data[1]);
         return false;
     }
 
     ptr = static_cast<void*>(const_cast<char*>(data + 2));
-    size = asset->second.size;
+    size = item->asset_size;
     return true;
 }
 
@@ -224,9 +289,10 @@ bool Assets::LvglStrategy::Apply(Assets* assets) {
         return false;
     }
 
+    // version 2 的资源包可能包含压缩条目
     cJSON* version = cJSON_GetObjectItem(root, "version");
     if (cJSON_IsNumber(version)) {
-        if (version->valuedouble > 1) {
+        if (version->valuedouble > 2) {
             ESP_LOGE(TAG, "The assets version %d is not supported, please upgrade the firmware", version->valueint);
             return false;
         }
@@ -369,7 +435,7 @@ bool Assets::EmoteStrategy::InitializePartition(Assets* assets) {
         const emote_data_t data = {
             .type = EMOTE_SOURCE_PARTITION,
             .source = {
-                .partition_label = PARTITION_LABEL,
+                .partition_label = assets->partition_->label,
             },
             .flags = {
                 .mmap_enable = true, //must be true here!!!
@@ -425,120 +491,93 @@ bool Assets::EmoteStrategy::Apply(Assets* assets) {
 bool Assets::Download(std::string url, std::function<void(int progress, size_t speed)> progress_callback) {
     ESP_LOGI(TAG, "Downloading new version of assets from %s", url.c_str());
 
-    // 取消当前资源分区的内存映射
-    UnApplyPartition();
-
-    // 下载新的资源文件
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(0);
-    
-    if (!http->Open("GET", url)) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection");
-        return false;
-    }
-
-    if (http->GetStatusCode() != 200) {
-        ESP_LOGE(TAG, "Failed to get assets, status code: %d", http->GetStatusCode());
-        return false;
-    }
-
-    size_t content_length = http->GetBodyLength();
-    if (content_length == 0) {
-        ESP_LOGE(TAG, "Failed to get content length");
-        return false;
+    // 有第二个资源分区时写入非活动分区，否则只能取消映射后原地覆盖
+    auto target = GetInactivePartition();
+    bool in_place = target == nullptr;
+    if (in_place) {
+        UnApplyPartition();
+        target = partition_;
+        ClearPartitionVerified();
+    } else {
+        ESP_LOGI(TAG, "Writing to inactive assets partition %s", target->label);
     }
-
-    if (content_length > partition_->size) {
-        ESP_LOGE(TAG, "Assets file size (%u) is larger than partition size (%lu)", content_length, partition_->size);
+    if (target == nullptr) {
+        ESP_LOGE(TAG, "No assets partition to write");
         return false;
     }
 
-    // 定义扇区大小为4KB（ESP32的标准扇区大小）
-    const size_t SECTOR_SIZE = esp_partition_get_main_flash_sector_size();
-    
-    // 计算需要擦除的扇区数量
-    size_t sectors_to_erase = (content_length + SECTOR_SIZE - 1) / SECTOR_SIZE; // 向上取整
-    size_t total_erase_size = sectors_to_erase * SECTOR_SIZE;
-    
-    ESP_LOGI(TAG, "Sector size: %u, content length: %u, sectors to erase: %u, total erase size: %u", 
-             SECTOR_SIZE, content_length, sectors_to_erase, total_erase_size);
-    
-    // 写入新的资源文件到分区，一边erase一边写入
-    char buffer[512];
-    size_t total_written = 0;
-    size_t recent_written = 0;
-    size_t current_sector = 0;
-    auto last_calc_time = esp_timer_get_time();
-    
-    while (true) {
-        int ret = http->Read(buffer, sizeof(buffer));
-        if (ret < 0) {
-            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
+    // 头部: 文件数(4) + 校验和(4) + 数据长度(4)，校验和随写入同步累加，不再回读整个分区
+    uint8_t header[12] = {};
+    uint32_t checksum = 0;
+    size_t erased_size = 0;
+
+    // 下载与擦写在两个任务中并行，断线后用 Range 从已收到的位置续传
+    DownloadPipeline pipeline;
+    bool success = pipeline.Run(url, [&](const uint8_t* data, size_t length, size_t offset) {
+        // 总长度在第一块数据到达前已知，超出分区时在任何擦除之前拒绝，原地更新时不会毁掉当前资源
+        if (pipeline.GetTotalSize() > target->size) {
+            ESP_LOGE(TAG, "Assets file size (%u) is larger than partition size (%lu)", pipeline.GetTotalSize(), target->size);
             return false;
         }
 
-        if (ret == 0) {
-            break;
-        }
-
-        // 检查是否需要擦除新的扇区
-        size_t write_end_offset = total_written + ret;
-        size_t needed_sectors = (write_end_offset + SECTOR_SIZE - 1) / SECTOR_SIZE;
-        
-        // 擦除需要的新扇区
-        while (current_sector < needed_sectors) {
-            size_t sector_start = current_sector * SECTOR_SIZE;
-            size_t sector_end = (current_sector + 1) * SECTOR_SIZE;
-            
-            // 确保擦除范围不超过分区大小
-            if (sector_end > partition_->size) {
-                ESP_LOGE(TAG, "Sector end (%u) exceeds partition size (%lu)", sector_end, partition_->size);
-                return false;
-            }
-            
-            ESP_LOGD(TAG, "Erasing sector %u (offset: %u, size: %u)", current_sector, sector_start, SECTOR_SIZE);
-            esp_err_t err = esp_partition_erase_range(partition_, sector_start, SECTOR_SIZE);
+        if (offset + length > erased_size) {
+            size_t erase_end = std::min<size_t>((offset + length + ERASE_AHEAD_SIZE - 1) / ERASE_AHEAD_SIZE * ERASE_AHEAD_SIZE, target->size);
+            esp_err_t err = esp_partition_erase_range(target, erased_size, erase_end - erased_size);
             if (err != ESP_OK) {
-                ESP_LOGE(TAG, "Failed to erase sector %u at offset %u: %s", current_sector, sector_start, esp_err_to_name(err));
+                ESP_LOGE(TAG, "Failed to erase assets partition at offset %u: %s", erased_size, esp_err_to_name(err));
                 return false;
             }
-            
-            current_sector++;
+            erased_size = erase_end;
         }
 
-        // 写入数据到分区
-        esp_err_t err = esp_partition_write(partition_, total_written, buffer, ret);
+        esp_err_t err = esp_partition_write(target, offset, data, length);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write to assets partition at offset %u: %s", total_written, esp_err_to_name(err));
+            ESP_LOGE(TAG, "Failed to write to assets partition at offset %u: %s", offset, esp_err_to_name(err));
             return false;
         }
 
-        total_written += ret;
-        recent_written += ret;
-
-        // 计算进度和速度
-        if (esp_timer_get_time() - last_calc_time >= 1000000 || total_written == content_length || ret == 0) {
-            size_t progress = total_written * 100 / content_length;
-            size_t speed = recent_written; // 每秒的字节数
-            ESP_LOGI(TAG, "Progress: %u%% (%u/%u), Speed: %u B/s, Sectors erased: %u", 
-                     progress, total_written, content_length, speed, current_sector);
-            if (progress_callback) {
-                progress_callback(progress, speed);
+        if (offset == 0) {
+            if (length < sizeof(header)) {
+                ESP_LOGE(TAG, "Assets file is too small");
+                return false;
             }
-            last_calc_time = esp_timer_get_time();
-            recent_written = 0; // 重置最近写入的字节数
+            memcpy(header, data, sizeof(header));
+        }
+        // 与 CalculateChecksum 相同的累加方式
+        uint32_t stored_len = *(uint32_t*)(header + 8);
+        size_t begin = std::max<size_t>(offset, sizeof(header));
+        size_t end = std::min<size_t>(offset + length, sizeof(header) + (size_t)stored_len);
+        auto bytes = (const char*)data;
+        for (size_t i = begin; i < end; i++) {
+            checksum += bytes[i - offset];
         }
+        return true;
+    }, progress_callback);
+
+    if (!success) {
+        // 原地更新还没有擦除任何数据时，重新映射原来的资源
+        if (in_place && erased_size == 0) {
+            InitializePartition();
+        }
+        return false;
     }
-    
-    http->Close();
 
-    if (total_written != content_length) {
-        ESP_LOGE(TAG, "Downloaded size (%u) does not match expected size (%u)", total_written, content_length);
+    uint32_t stored_checksum = *(uint32_t*)(header + 4);
+    if ((checksum & 0xFFFF) != stored_checksum) {
+        ESP_LOGE(TAG, "The downloaded checksum (0x%lx) does not match the stored checksum (0x%lx)", checksum & 0xFFFF, stored_checksum);
         return false;
     }
 
-    ESP_LOGI(TAG, "Assets download completed, total written: %u bytes, total sectors erased: %u", 
-             total_written, current_sector);
+    ESP_LOGI(TAG, "Assets download completed, total written: %u bytes, erased: %u bytes",
+             pipeline.GetTotalSize(), erased_size);
+    MarkPartitionVerified(target, stored_checksum, *(uint32_t*)(header + 8));
+
+    if (!in_place) {
+        // 切换到新分区，旧分区保留到下次下载
+        UnApplyPartition();
+        Settings settings("assets", true);
+        settings.SetInt("slot", strcmp(target->label, PARTITION_LABEL_B) == 0 ? 1 : 0);
+    }
 
     // 重新初始化资源分区
     if (!InitializePartition()) {
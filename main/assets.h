@@ -8,17 +8,14 @@
 #include <cJSON.h>
 #include <esp_partition.h>
 #include <model_path.h>
-#include <map>
-#include <string>
+
+#include "asset_cache.h"
 
 #if HAVE_LVGL
 #include <spi_flash_mmap.h>
 #endif
 
-struct Asset {
-    size_t size;
-    size_t offset;
-};
+struct mmap_assets_table;
 
 class Assets {
 public:
@@ -43,6 +40,10 @@ private:
     bool InitializePartition();
     void UnApplyPartition();
     static bool FindPartition(Assets* assets);
+    const esp_partition_t* GetInactivePartition();
+    static bool IsPartitionVerified(const esp_partition_t* partition, uint32_t checksum, uint32_t length);
+    static void MarkPartitionVerified(const esp_partition_t* partition, uint32_t checksum, uint32_t length);
+    static void ClearPartitionVerified();
     static bool LoadSrmodelsFromIndex(Assets* assets, cJSON* root = nullptr);
   
     class AssetStrategy {
@@ -62,7 +63,11 @@ private:
         bool GetAssetData(Assets* assets, const std::string& name, void*& ptr, size_t& size) override;
     private:
         static uint32_t CalculateChecksum(const char* data, uint32_t length);
-        std::map<std::string, Asset> assets_;
+        const mmap_assets_table* FindAsset(const std::string& name) const;
+        const mmap_assets_table* table_ = nullptr;
+        uint32_t table_count_ = 0;
+        bool table_sorted_ = false;
+        AssetCache cache_;
         esp_partition_mmap_handle_t mmap_handle_ = 0;
         const char* mmap_root_ = nullptr;
         bool checksum_valid_ = false;
@@ -0,0 +1,57 @@
+#ifndef ASSETS_TABLE_H
+#define ASSETS_TABLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// File table of an assets pack, searched in place on the mapped partition
+struct mmap_assets_table {
+    char asset_name[32];          /*!< Name of the asset */
+    uint32_t asset_size;          /*!< Size of the asset */
+    uint32_t asset_offset;        /*!< Offset of the asset */
+    uint16_t asset_width;         /*!< Width of the asset */
+    uint16_t asset_height;        /*!< Height of the asset */
+};
+
+// Newer packers sort the table by the NUL-padded name, older packs are in file order
+inline bool IsAssetTableSorted(const mmap_assets_table* table, uint32_t count) {
+    for (uint32_t i = 1; i < count; i++) {
+        if (strncmp(table[i - 1].asset_name, table[i].asset_name, sizeof(table[i].asset_name)) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Binary search on a sorted table, linear scan otherwise
+inline const mmap_assets_table* FindAssetInTable(const mmap_assets_table* table, uint32_t count, bool sorted,
+    const std::string& name) {
+    if (name.size() > sizeof(table->asset_name)) {
+        return nullptr;
+    }
+    if (sorted) {
+        uint32_t low = 0, high = count;
+        while (low < high) {
+            uint32_t mid = (low + high) / 2;
+            int cmp = strncmp(name.c_str(), table[mid].asset_name, sizeof(table[mid].asset_name));
+            if (cmp == 0) {
+                return &table[mid];
+            }
+            if (cmp < 0) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (strncmp(name.c_str(), table[i].asset_name, sizeof(table[i].asset_name)) == 0) {
+            return &table[i];
+        }
+    }
+    return nullptr;
+}
+
+#endif // ASSETS_TABLE_H
@@ -374,6 +374,7 @@ void AudioService::OpusCodecTask() {
                 std::unique_lock<std::mutex> decoder_lock(decoder_mutex_);
                 auto ret = esp_opus_dec_decode(opus_decoder_, &raw, &out_frame, &dec_info);
                 decoder_lock.unlock();
+                AudioPacketPool::Release(std::move(packet));
                 if (ret == ESP_AUDIO_ERR_OK) {
                     task->pcm.resize(out_frame.decoded_size / sizeof(int16_t));
                     if (decoder_sample_rate_ != codec_->output_sample_rate() && output_resampler_ != nullptr) {
@@ -407,34 +408,29 @@ void AudioService::OpusCodecTask() {
             audio_queue_cv_.notify_all();
             lock.unlock();
 
-            auto packet = std::make_unique<AudioStreamPacket>();
+            auto packet = AudioPacketPool::Acquire();
             packet->frame_duration = OPUS_FRAME_DURATION_MS;
             packet->sample_rate = 16000;
             packet->timestamp = task->timestamp;
 
             if (opus_encoder_ != nullptr && task->pcm.size() == encoder_frame_size_) {
-                std::vector<uint8_t> buf(encoder_outbuf_size_);
+                /* Encode directly into the packet payload, the pooled buffer keeps its capacity */
+                packet->payload.resize(encoder_outbuf_size_);
                 esp_audio_enc_in_frame_t in = {
                     .buffer = (uint8_t *)(task->pcm.data()),
                     .len = (uint32_t)(encoder_frame_size_ * sizeof(int16_t)),
                 };
                 esp_audio_enc_out_frame_t out = {
-                    .buffer = buf.data(),
+                    .buffer = packet->payload.data(),
                     .len = (uint32_t)encoder_outbuf_size_,
                     .encoded_bytes = 0,
                 };
                 auto ret = esp_opus_enc_process(opus_encoder_, &in, &out);
                 if (ret == ESP_AUDIO_ERR_OK) {
-                    packet->payload.assign(buf.data(), buf.data() + out.encoded_bytes);
+                    packet->payload.resize(out.encoded_bytes);
 
                     if (task->type == kAudioTaskTypeEncodeToSendQueue) {
-                        {
-                            std::lock_guard<std::mutex> lock2(audio_queue_mutex_);
-                            audio_send_queue_.push_back(std::move(packet));
-                        }
-                        if (callbacks_.on_send_queue_available) {
-                            callbacks_.on_send_queue_available();
-                        }
+                        PushPacketToSendQueue(std::move(packet));
                     } else if (task->type == kAudioTaskTypeEncodeToTestingQueue) {
                         std::lock_guard<std::mutex> lock2(audio_queue_mutex_);
                         audio_testing_queue_.push_back(std::move(packet));
@@ -512,6 +508,66 @@ void AudioService::PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t
     audio_queue_cv_.notify_all();
 }
 
+void AudioService::PushPacketToSendQueue(std::unique_ptr<AudioStreamPacket> packet) {
+    std::unique_lock<std::mutex> lock(audio_queue_mutex_);
+    bool gate_changed = false;
+    if (uplink_gate_enabled_) {
+        if (voice_detected_) {
+            uplink_gate_hangover_ = UPLINK_GATE_HANGOVER_FRAMES;
+        } else if (uplink_gate_hangover_ > 0) {
+            uplink_gate_hangover_--;
+        }
+
+        if (uplink_gate_hangover_ == 0) {
+            /* Keep the latest frames as pre-roll, so the beginning of the next utterance is not lost */
+            uplink_gate_statistics_.suppressed_frames++;
+            uplink_gate_statistics_.suppressed_bytes += packet->payload.size();
+            uplink_preroll_queue_.push_back(std::move(packet));
+            if (uplink_preroll_queue_.size() > UPLINK_GATE_PREROLL_FRAMES) {
+                uplink_preroll_queue_.pop_front();
+            }
+            if (uplink_gate_open_) {
+                uplink_gate_open_ = false;
+                ESP_LOGI(TAG, "Uplink gate closed, sent %lu frames (%lu bytes), suppressed %lu frames (%lu bytes)",
+                    uplink_gate_statistics_.sent_frames, uplink_gate_statistics_.sent_bytes,
+                    uplink_gate_statistics_.suppressed_frames, uplink_gate_statistics_.suppressed_bytes);
+                lock.unlock();
+                if (callbacks_.on_uplink_gate_change) {
+                    callbacks_.on_uplink_gate_change(false);
+                }
+            }
+            return;
+        }
+
+        if (!uplink_gate_open_) {
+            uplink_gate_open_ = true;
+            gate_changed = true;
+        }
+        /* Flush the pre-roll frames before the current one, they are not suppressed anymore */
+        for (auto& preroll : uplink_preroll_queue_) {
+            uplink_gate_statistics_.suppressed_frames--;
+            uplink_gate_statistics_.suppressed_bytes -= preroll->payload.size();
+            uplink_gate_statistics_.sent_frames++;
+            uplink_gate_statistics_.sent_bytes += preroll->payload.size();
+            audio_send_queue_.push_back(std::move(preroll));
+            audio_send_queue_times_.push_back(esp_timer_get_time());
+        }
+        uplink_preroll_queue_.clear();
+    }
+    uplink_gate_statistics_.sent_frames++;
+    uplink_gate_statistics_.sent_bytes += packet->payload.size();
+    audio_send_queue_.push_back(std::move(packet));
+    audio_send_queue_times_.push_back(esp_timer_get_time());
+    lock.unlock();
+
+    if (gate_changed && callbacks_.on_uplink_gate_change) {
+        callbacks_.on_uplink_gate_change(true);
+    }
+    if (callbacks_.on_send_queue_available) {
+        callbacks_.on_send_queue_available();
+    }
+}
+
 bool AudioService::PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> packet, bool wait) {
     std::unique_lock<std::mutex> lock(audio_queue_mutex_);
     if (audio_decode_queue_.size() >= MAX_DECODE_PACKETS_IN_QUEUE) {
@@ -533,10 +589,50 @@ std::unique_ptr<AudioStreamPacket> AudioService::PopPacketFromSendQueue() {
     }
     auto packet = std::move(audio_send_queue_.front());
     audio_send_queue_.pop_front();
+    audio_send_queue_times_.pop_front();
     audio_queue_cv_.notify_all();
     return packet;
 }
 
+size_t AudioService::PopPacketsFromSendQueue(std::vector<std::unique_ptr<AudioStreamPacket>>& packets) {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    size_t count = audio_send_queue_.size();
+    if (count == 0) {
+        return 0;
+    }
+
+    /* Take the whole queue at once, so the sender only locks once per batch */
+    auto now = esp_timer_get_time();
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t latency = (uint32_t)(now - audio_send_queue_times_[i]);
+        send_queue_statistics_.total_latency_us += latency;
+        if (latency > send_queue_statistics_.max_latency_us) {
+            send_queue_statistics_.max_latency_us = latency;
+        }
+        packets.push_back(std::move(audio_send_queue_[i]));
+    }
+    send_queue_statistics_.sent_packets += count;
+    audio_send_queue_.clear();
+    audio_send_queue_times_.clear();
+    audio_queue_cv_.notify_all();
+    return count;
+}
+
+void AudioService::CountSendQueueDrops(size_t count) {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    send_queue_statistics_.sent_packets -= count;
+    send_queue_statistics_.dropped_packets += count;
+}
+
+SendQueueStatistics AudioService::GetSendQueueStatistics(bool reset) {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    auto statistics = send_queue_statistics_;
+    if (reset) {
+        send_queue_statistics_ = SendQueueStatistics();
+    }
+    return statistics;
+}
+
 void AudioService::EncodeWakeWord() {
     if (wake_word_) {
         wake_word_->EncodeWakeWordData();
@@ -609,6 +705,7 @@ void AudioService::EnableVoiceProcessing(bool enable) {
     } else {
         audio_processor_->Stop();
         xEventGroupClearBits(event_group_, AS_EVENT_AUDIO_PROCESSOR_RUNNING);
+        EnableUplinkGate(false);
     }
 }
 
@@ -635,6 +732,26 @@ void AudioService::EnableDeviceAec(bool enable) {
     audio_processor_->EnableDeviceAec(enable);
 }
 
+void AudioService::EnableUplinkGate(bool enable) {
+#if CONFIG_USE_UPLINK_VAD_GATE
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    if (uplink_gate_enabled_ == enable) {
+        return;
+    }
+    ESP_LOGI(TAG, "%s uplink gate", enable ? "Enabling" : "Disabling");
+    uplink_gate_enabled_ = enable;
+    /* The gate starts open, the hangover covers the delay before the first VAD decision */
+    uplink_gate_open_ = true;
+    uplink_gate_hangover_ = UPLINK_GATE_HANGOVER_FRAMES;
+    uplink_preroll_queue_.clear();
+#endif
+}
+
+UplinkGateStatistics AudioService::GetUplinkGateStatistics() {
+    std::lock_guard<std::mutex> lock(audio_queue_mutex_);
+    return uplink_gate_statistics_;
+}
+
 void AudioService::SetCallbacks(AudioServiceCallbacks& callbacks) {
     callbacks_ = callbacks;
 }
@@ -47,6 +47,10 @@
 #define AUDIO_POWER_TIMEOUT_MS 15000
 #define AUDIO_POWER_CHECK_INTERVAL_MS 1000
 
+// 上行 VAD 门限：静音持续 hangover 后停止发送，语音恢复时补发 pre-roll 帧
+#define UPLINK_GATE_HANGOVER_FRAMES (600 / OPUS_FRAME_DURATION_MS)
+#define UPLINK_GATE_PREROLL_FRAMES (360 / OPUS_FRAME_DURATION_MS)
+
 #define AS_EVENT_AUDIO_TESTING_RUNNING      (1 << 0)
 #define AS_EVENT_WAKE_WORD_RUNNING          (1 << 1)
 #define AS_EVENT_AUDIO_PROCESSOR_RUNNING    (1 << 2)
@@ -80,6 +84,7 @@ struct AudioServiceCallbacks {
     std::function<void(const std::string&)> on_wake_word_detected;
     std::function<void(bool)> on_vad_change;
     std::function<void(void)> on_audio_testing_queue_full;
+    std::function<void(bool)> on_uplink_gate_change;
 };
 
 
@@ -102,6 +107,20 @@ struct DebugStatistics {
     uint32_t playback_count = 0;
 };
 
+struct SendQueueStatistics {
+    uint32_t sent_packets = 0;
+    uint32_t dropped_packets = 0;
+    uint32_t max_latency_us = 0;
+    uint64_t total_latency_us = 0;
+};
+
+struct UplinkGateStatistics {
+    uint32_t sent_frames = 0;
+    uint32_t sent_bytes = 0;
+    uint32_t suppressed_frames = 0;
+    uint32_t suppressed_bytes = 0;
+};
+
 class AudioService {
 public:
     AudioService();
@@ -124,11 +143,16 @@ public:
     void EnableVoiceProcessing(bool enable);
     void EnableAudioTesting(bool enable);
     void EnableDeviceAec(bool enable);
+    void EnableUplinkGate(bool enable);
+    UplinkGateStatistics GetUplinkGateStatistics();
 
     void SetCallbacks(AudioServiceCallbacks& callbacks);
 
     bool PushPacketToDecodeQueue(std::unique_ptr<AudioStreamPacket> packet, bool wait = false);
     std::unique_ptr<AudioStreamPacket> PopPacketFromSendQueue();
+    size_t PopPacketsFromSendQueue(std::vector<std::unique_ptr<AudioStreamPacket>>& packets);
+    void CountSendQueueDrops(size_t count);
+    SendQueueStatistics GetSendQueueStatistics(bool reset = false);
     void PlaySound(const std::string_view& sound);
     bool ReadAudioData(std::vector<int16_t>& data, int sample_rate, int samples);
     void ResetDecoder();
@@ -168,11 +192,19 @@ private:
     std::condition_variable audio_queue_cv_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_decode_queue_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_send_queue_;
+    std::deque<int64_t> audio_send_queue_times_;  // Enqueue time of each packet in audio_send_queue_
+    SendQueueStatistics send_queue_statistics_;
     std::deque<std::unique_ptr<AudioStreamPacket>> audio_testing_queue_;
     std::deque<std::unique_ptr<AudioTask>> audio_encode_queue_;
     std::deque<std::unique_ptr<AudioTask>> audio_playback_queue_;
     // For server AEC
     std::deque<uint32_t> timestamp_queue_;
+    // For uplink VAD gate, protected by audio_queue_mutex_
+    std::deque<std::unique_ptr<AudioStreamPacket>> uplink_preroll_queue_;
+    UplinkGateStatistics uplink_gate_statistics_;
+    bool uplink_gate_enabled_ = false;
+    bool uplink_gate_open_ = true;
+    int uplink_gate_hangover_ = 0;
 
     bool wake_word_initialized_ = false;
     bool audio_processor_initialized_ = false;
@@ -188,6 +220,7 @@ private:
     void AudioOutputTask();
     void OpusCodecTask();
     void PushTaskToEncodeQueue(AudioTaskType type, std::vector<int16_t>&& pcm);
+    void PushPacketToSendQueue(std::unique_ptr<AudioStreamPacket> packet);
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
     void CheckAndUpdateAudioPowerState();
 };
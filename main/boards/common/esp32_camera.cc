@@ -12,6 +12,7 @@
 #include "lvgl_display.h"
 #include "mcp_server.h"
 #include "system_info.h"
+#include "http_pool.h"
 #include "jpg/image_to_jpeg.h"
 #include "esp_timer.h"
 
@@ -199,18 +200,20 @@ std::string Esp32Camera::Explain(const std::string &question) {
         ESP_LOGI(TAG, "JPEG encoding time: %ld ms", int((end_time - start_time) / 1000));
     });
 
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(3);
+    auto& pool = HttpPool::GetInstance();
+    auto http = pool.Acquire(3, explain_url_);
     std::string boundary = "----ESP32_CAMERA_BOUNDARY";
 
-    http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
-    http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
-    if (!explain_token_.empty()) {
-        http->SetHeader("Authorization", "Bearer " + explain_token_);
-    }
-    http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
-    http->SetHeader("Transfer-Encoding", "chunked");
-    if (!http->Open("POST", explain_url_)) {
+    bool opened = pool.Open(http, 3, "POST", explain_url_, [this, &boundary](Http* http) {
+        http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
+        http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
+        if (!explain_token_.empty()) {
+            http->SetHeader("Authorization", "Bearer " + explain_token_);
+        }
+        http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
+        http->SetHeader("Transfer-Encoding", "chunked");
+    });
+    if (!opened) {
         ESP_LOGE(TAG, "Failed to connect to explain URL");
         encoder_thread_.join();
         JpegChunk chunk;
@@ -279,7 +282,7 @@ std::string Esp32Camera::Explain(const std::string &question) {
     }
 
     std::string result = http->ReadAll();
-    http->Close();
+    pool.Release(3, explain_url_, std::move(http));
 
     size_t remain_stack_size = uxTaskGetStackHighWaterMark(nullptr);
     ESP_LOGI(TAG, "Explain image size=%dx%d, compressed size=%d, remain stack size=%d, question=%s\n%s",
@@ -4,6 +4,7 @@
 #include "lvgl_image.h"
 #include "board.h"
 #include "system_info.h"
+#include "http_pool.h"
 #include "config.h"
 #include "settings.h"
 
@@ -679,8 +680,8 @@ std::string SscmaCamera::Explain(const std::string& question) {
         return "{\"success\": false, \"message\": \"Image explain URL or token is not set\"}";
     }
 
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(3);
+    auto& pool = HttpPool::GetInstance();
+    auto http = pool.Acquire(3, explain_url_);
     // 构造multipart/form-data请求体
     std::string boundary = "----ESP32_CAMERA_BOUNDARY";
     
@@ -703,14 +704,16 @@ std::string SscmaCamera::Explain(const std::string& question) {
     multipart_footer += "\r\n--" + boundary + "--\r\n";
 
     // 配置HTTP客户端，使用分块传输编码
-    http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
-    http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
-    if (!explain_token_.empty()) {
-        http->SetHeader("Authorization", "Bearer " + explain_token_);
-    }
-    http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
-    http->SetHeader("Transfer-Encoding", "chunked");
-    if (!http->Open("POST", explain_url_)) {
+    bool opened = pool.Open(http, 3, "POST", explain_url_, [this, &boundary](Http* http) {
+        http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
+        http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
+        if (!explain_token_.empty()) {
+            http->SetHeader("Authorization", "Bearer " + explain_token_);
+        }
+        http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
+        http->SetHeader("Transfer-Encoding", "chunked");
+    });
+    if (!opened) {
         ESP_LOGE(TAG, "Failed to connect to explain URL");
         return "{\"success\": false, \"message\": \"Failed to connect to explain URL\"}";
     }
@@ -736,7 +739,7 @@ std::string SscmaCamera::Explain(const std::string& question) {
     }
 
     std::string result = http->ReadAll();
-    http->Close();
+    pool.Release(3, explain_url_, std::move(http));
 
     ESP_LOGI(TAG, "Explain image size=%d, question=%s\n%s", jpeg_data_.len, question.c_str(), result.c_str());
     return result;
@@ -0,0 +1,261 @@
+#include "delta_patcher.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "DeltaPatcher"
+
+
+DeltaPatcher::DeltaPatcher(ReadCallback read_callback, WriteCallback write_callback)
+    : read_callback_(read_callback), write_callback_(write_callback) {
+}
+
+void DeltaPatcher::SetBaseSha256(const uint8_t* sha256) {
+    memcpy(base_sha256_, sha256, sizeof(base_sha256_));
+    check_base_ = true;
+}
+
+static uint32_t ReadUint32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool DeltaPatcher::Fail(const char* reason) {
+    ESP_LOGE(TAG, "%s at output offset %u", reason, GetWrittenSize());
+    state_ = kStateError;
+    return false;
+}
+
+bool DeltaPatcher::ParseHeader() {
+    if (memcmp(header_, DELTA_PATCH_MAGIC, 4) != 0) {
+        return Fail("Invalid patch magic");
+    }
+    new_size_ = ReadUint32(header_ + 4);
+    base_size_ = ReadUint32(header_ + 8);
+    if (check_base_ && memcmp(header_ + 16, base_sha256_, sizeof(base_sha256_)) != 0) {
+        return Fail("Patch was made for a different base image");
+    }
+    ESP_LOGI(TAG, "Patching %u byte base into %u byte image", base_size_, new_size_);
+    return true;
+}
+
+bool DeltaPatcher::ReadVarint(uint8_t byte, bool& done) {
+    if (varint_shift_ > 56) {
+        return Fail("Varint overflow");
+    }
+    varint_ |= (uint64_t)(byte & 0x7F) << varint_shift_;
+    varint_shift_ += 7;
+    done = (byte & 0x80) == 0;
+    return true;
+}
+
+// Bytes outside the base image read as zero, matching bspatch
+bool DeltaPatcher::ReadBase(uint8_t* data, size_t length) {
+    int64_t offset = base_offset_;
+    base_offset_ += length;
+    while (length > 0) {
+        if (offset < 0 || offset >= (int64_t)base_size_) {
+            size_t gap = offset < 0 ? std::min<int64_t>(-offset, length) : length;
+            memset(data, 0, gap);
+            data += gap;
+            offset += gap;
+            length -= gap;
+            continue;
+        }
+        size_t size = std::min<int64_t>(base_size_ - offset, length);
+        if (!read_callback_(offset, data, size)) {
+            return Fail("Failed to read base image");
+        }
+        data += size;
+        offset += size;
+        length -= size;
+    }
+    return true;
+}
+
+bool DeltaPatcher::Flush() {
+    if (output_length_ == 0) {
+        return true;
+    }
+    if (written_ + output_length_ > new_size_) {
+        return Fail("Patch produces more data than declared");
+    }
+    if (!write_callback_(output_, output_length_)) {
+        return Fail("Failed to write output");
+    }
+    written_ += output_length_;
+    output_length_ = 0;
+    return true;
+}
+
+bool DeltaPatcher::EmitBase(size_t length) {
+    while (length > 0) {
+        if (output_length_ == sizeof(output_) && !Flush()) {
+            return false;
+        }
+        size_t size = std::min(length, sizeof(output_) - output_length_);
+        if (!ReadBase(output_ + output_length_, size)) {
+            return false;
+        }
+        output_length_ += size;
+        length -= size;
+    }
+    return true;
+}
+
+bool DeltaPatcher::EmitLiteral(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        if (output_length_ == sizeof(output_) && !Flush()) {
+            return false;
+        }
+        size_t size = std::min(length, sizeof(output_) - output_length_);
+        uint8_t* out = output_ + output_length_;
+        if (!ReadBase(out, size)) {
+            return false;
+        }
+        for (size_t i = 0; i < size; i++) {
+            out[i] += data[i];
+        }
+        output_length_ += size;
+        data += size;
+        length -= size;
+    }
+    return true;
+}
+
+bool DeltaPatcher::EmitExtra(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        if (output_length_ == sizeof(output_) && !Flush()) {
+            return false;
+        }
+        size_t size = std::min(length, sizeof(output_) - output_length_);
+        memcpy(output_ + output_length_, data, size);
+        output_length_ += size;
+        data += size;
+        length -= size;
+    }
+    return true;
+}
+
+void DeltaPatcher::NextRun() {
+    if (add_remaining_ > 0) {
+        state_ = kStateZeroRun;
+    } else if (extra_remaining_ > 0) {
+        state_ = kStateExtra;
+    } else {
+        EndRecord();
+    }
+}
+
+void DeltaPatcher::EndRecord() {
+    base_offset_ += seek_;
+    state_ = kStateAddLength;
+}
+
+bool DeltaPatcher::Feed(const uint8_t* data, size_t length) {
+    const uint8_t* end = data + length;
+    while (data < end) {
+        bool done = false;
+        switch (state_) {
+        case kStateHeader: {
+            size_t size = std::min<size_t>(end - data, sizeof(header_) - header_length_);
+            memcpy(header_ + header_length_, data, size);
+            header_length_ += size;
+            data += size;
+            if (header_length_ == sizeof(header_)) {
+                if (!ParseHeader()) {
+                    return false;
+                }
+                state_ = kStateAddLength;
+            }
+            break;
+        }
+        case kStateAddLength:
+        case kStateExtraLength:
+        case kStateSeek:
+        case kStateZeroRun:
+        case kStateLiteralLength:
+            if (!ReadVarint(*data++, done)) {
+                return false;
+            }
+            if (!done) {
+                break;
+            }
+            if (state_ == kStateAddLength) {
+                add_remaining_ = varint_;
+                state_ = kStateExtraLength;
+            } else if (state_ == kStateExtraLength) {
+                extra_remaining_ = varint_;
+                state_ = kStateSeek;
+            } else if (state_ == kStateSeek) {
+                // zigzag: 0, -1, 1, -2, ... so small backward seeks stay short
+                seek_ = (int64_t)(varint_ >> 1) ^ -(int64_t)(varint_ & 1);
+                if (add_remaining_ + extra_remaining_ > new_size_ - GetWrittenSize()) {
+                    return Fail("Record exceeds image size");
+                }
+                NextRun();
+            } else if (state_ == kStateZeroRun) {
+                if (varint_ > add_remaining_) {
+                    return Fail("Zero run exceeds add block");
+                }
+                add_remaining_ -= varint_;
+                if (!EmitBase(varint_)) {
+                    return false;
+                }
+                state_ = kStateLiteralLength;
+            } else {
+                if (varint_ > add_remaining_) {
+                    return Fail("Literal exceeds add block");
+                }
+                literal_remaining_ = varint_;
+                add_remaining_ -= varint_;
+                if (literal_remaining_ > 0) {
+                    state_ = kStateLiteral;
+                } else {
+                    NextRun();
+                }
+            }
+            varint_ = 0;
+            varint_shift_ = 0;
+            break;
+        case kStateLiteral: {
+            size_t size = std::min<size_t>(end - data, literal_remaining_);
+            if (!EmitLiteral(data, size)) {
+                return false;
+            }
+            data += size;
+            literal_remaining_ -= size;
+            if (literal_remaining_ == 0) {
+                NextRun();
+            }
+            break;
+        }
+        case kStateExtra: {
+            size_t size = std::min<size_t>(end - data, extra_remaining_);
+            if (!EmitExtra(data, size)) {
+                return false;
+            }
+            data += size;
+            extra_remaining_ -= size;
+            if (extra_remaining_ == 0) {
+                EndRecord();
+            }
+            break;
+        }
+        case kStateError:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatcher::Finish() {
+    if (state_ != kStateAddLength || !Flush()) {
+        return Fail("Patch ended unexpectedly");
+    }
+    if (written_ != new_size_) {
+        return Fail("Patch produced fewer bytes than declared");
+    }
+    return true;
+}
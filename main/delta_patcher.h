@@ -0,0 +1,91 @@
+#ifndef DELTA_PATCHER_H
+#define DELTA_PATCHER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// 输出缓冲区大小，攒满后一次写入 OTA 分区
+#define DELTA_PATCHER_OUTPUT_SIZE   4096
+#define DELTA_PATCH_MAGIC           "XZD1"
+#define DELTA_PATCH_HEADER_SIZE     48
+
+/**
+ * Applies a streaming binary patch generated by scripts/delta_patch.py.
+ * The patch carries bsdiff records, so the new image is produced strictly in
+ * order while the base image is read at random offsets.
+ *
+ * Header (little endian):
+ *   magic "XZD1" | new_size u32 | base_size u32 | reserved u32 | base_sha256[32]
+ * Then records until new_size bytes are produced:
+ *   add_len varint | extra_len varint | seek zigzag varint
+ *   add_len bytes of (new - base), coded as runs of
+ *       zero_run varint | literal_len varint | literal bytes
+ *   extra_len bytes copied verbatim
+ *   base offset advances by add_len + seek
+ */
+class DeltaPatcher {
+public:
+    // Reads the base image, must fill exactly length bytes
+    typedef std::function<bool(size_t offset, uint8_t* data, size_t length)> ReadCallback;
+    typedef std::function<bool(const uint8_t* data, size_t length)> WriteCallback;
+
+    DeltaPatcher(ReadCallback read_callback, WriteCallback write_callback);
+
+    // Patch is rejected unless its base digest matches
+    void SetBaseSha256(const uint8_t* sha256);
+    bool Feed(const uint8_t* data, size_t length);
+    bool Finish();
+
+    size_t GetNewSize() const { return new_size_; }
+    size_t GetWrittenSize() const { return written_ + output_length_; }
+
+private:
+    enum State {
+        kStateHeader,
+        kStateAddLength,
+        kStateExtraLength,
+        kStateSeek,
+        kStateZeroRun,
+        kStateLiteralLength,
+        kStateLiteral,
+        kStateExtra,
+        kStateError,
+    };
+
+    ReadCallback read_callback_;
+    WriteCallback write_callback_;
+    uint8_t base_sha256_[32] = {};
+    bool check_base_ = false;
+
+    State state_ = kStateHeader;
+    uint8_t header_[DELTA_PATCH_HEADER_SIZE];
+    size_t header_length_ = 0;
+    uint64_t varint_ = 0;
+    int varint_shift_ = 0;
+
+    size_t new_size_ = 0;
+    size_t base_size_ = 0;
+    int64_t base_offset_ = 0;
+    size_t add_remaining_ = 0;
+    size_t extra_remaining_ = 0;
+    size_t literal_remaining_ = 0;
+    int64_t seek_ = 0;
+
+    uint8_t output_[DELTA_PATCHER_OUTPUT_SIZE];
+    size_t output_length_ = 0;
+    size_t written_ = 0;
+
+    bool ParseHeader();
+    bool ReadVarint(uint8_t byte, bool& done);
+    bool ReadBase(uint8_t* data, size_t length);
+    bool Flush();
+    bool Fail(const char* reason);
+    bool EmitBase(size_t length);
+    bool EmitLiteral(const uint8_t* data, size_t length);
+    bool EmitExtra(const uint8_t* data, size_t length);
+    void NextRun();
+    void EndRecord();
+};
+
+#endif // DELTA_PATCHER_H
@@ -0,0 +1,305 @@
+#include "download_pipeline.h"
+#include "board.h"
+#include "http_pool.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+
+#define TAG "DownloadPipeline"
+
+
+DownloadPipeline::DownloadPipeline(size_t buffer_size) : buffer_size_(buffer_size) {
+    mbedtls_sha256_init(&sha256_ctx_);
+}
+
+DownloadPipeline::~DownloadPipeline() {
+    Release();
+    mbedtls_sha256_free(&sha256_ctx_);
+}
+
+bool DownloadPipeline::Allocate() {
+    for (int i = 0; i < DOWNLOAD_PIPELINE_BUFFER_COUNT; i++) {
+        // Prefer PSRAM, esp_flash copies through an internal bounce buffer when needed
+        buffers_[i] = (uint8_t*)heap_caps_malloc(buffer_size_, MALLOC_CAP_SPIRAM);
+        if (buffers_[i] == nullptr) {
+            buffers_[i] = (uint8_t*)heap_caps_malloc(buffer_size_, MALLOC_CAP_8BIT);
+        }
+        if (buffers_[i] == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate %u bytes download buffer", buffer_size_);
+            return false;
+        }
+    }
+
+    free_queue_ = xQueueCreate(DOWNLOAD_PIPELINE_BUFFER_COUNT, sizeof(Chunk));
+    // One extra slot for the end-of-stream marker
+    full_queue_ = xQueueCreate(DOWNLOAD_PIPELINE_BUFFER_COUNT + 1, sizeof(Chunk));
+    writer_done_ = xSemaphoreCreateBinary();
+    if (free_queue_ == nullptr || full_queue_ == nullptr || writer_done_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create download queues");
+        return false;
+    }
+
+    for (int i = 0; i < DOWNLOAD_PIPELINE_BUFFER_COUNT; i++) {
+        Chunk chunk = {buffers_[i], 0, 0};
+        xQueueSend(free_queue_, &chunk, 0);
+    }
+    return true;
+}
+
+void DownloadPipeline::Release() {
+    for (int i = 0; i < DOWNLOAD_PIPELINE_BUFFER_COUNT; i++) {
+        if (buffers_[i] != nullptr) {
+            heap_caps_free(buffers_[i]);
+            buffers_[i] = nullptr;
+        }
+    }
+    if (free_queue_ != nullptr) {
+        vQueueDelete(free_queue_);
+        free_queue_ = nullptr;
+    }
+    if (full_queue_ != nullptr) {
+        vQueueDelete(full_queue_);
+        full_queue_ = nullptr;
+    }
+    if (writer_done_ != nullptr) {
+        vSemaphoreDelete(writer_done_);
+        writer_done_ = nullptr;
+    }
+}
+
+void DownloadPipeline::WriterTask() {
+    while (true) {
+        Chunk chunk;
+        xQueueReceive(full_queue_, &chunk, portMAX_DELAY);
+        if (chunk.data == nullptr) {
+            break;
+        }
+
+        // After a failure keep recycling buffers so the download task never blocks
+        if (!writer_failed_) {
+            auto start_time = esp_timer_get_time();
+            mbedtls_sha256_update(&sha256_ctx_, chunk.data, chunk.length);
+            if (!write_callback_(chunk.data, chunk.length, chunk.offset)) {
+                ESP_LOGE(TAG, "Write failed at offset %u", chunk.offset);
+                writer_failed_ = true;
+            }
+            writer_busy_us_ += esp_timer_get_time() - start_time;
+        }
+
+        chunk.length = 0;
+        xQueueSend(free_queue_, &chunk, portMAX_DELAY);
+    }
+
+    mbedtls_sha256_finish(&sha256_ctx_, sha256_);
+    xSemaphoreGive(writer_done_);
+}
+
+bool DownloadPipeline::Submit(Chunk& chunk, int64_t& stall_us) {
+    xQueueSend(full_queue_, &chunk, portMAX_DELAY);
+
+    // Blocking here means flash is slower than the network
+    auto start_time = esp_timer_get_time();
+    xQueueReceive(free_queue_, &chunk, portMAX_DELAY);
+    stall_us += esp_timer_get_time() - start_time;
+    return !writer_failed_;
+}
+
+std::string DownloadPipeline::GetSha256() const {
+    char hex[sizeof(sha256_) * 2 + 1];
+    for (size_t i = 0; i < sizeof(sha256_); i++) {
+        snprintf(hex + i * 2, 3, "%02x", sha256_[i]);
+    }
+    return std::string(hex);
+}
+
+bool DownloadPipeline::Run(const std::string& url, WriteCallback write_callback, ProgressCallback progress_callback) {
+    if (!Allocate()) {
+        Release();
+        return false;
+    }
+
+    write_callback_ = write_callback;
+    writer_failed_ = false;
+    writer_busy_us_ = 0;
+    total_size_ = 0;
+    mbedtls_sha256_starts(&sha256_ctx_, 0);
+
+    // Flash operations are not allowed from a task whose stack is in PSRAM
+    if (xTaskCreate([](void* arg) {
+        DownloadPipeline* pipeline = (DownloadPipeline*)arg;
+        pipeline->WriterTask();
+        vTaskDelete(NULL);
+    }, "download_writer", DOWNLOAD_PIPELINE_WRITER_STACK_SIZE, this, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+        Release();
+        return false;
+    }
+
+    auto& pool = HttpPool::GetInstance();
+    Chunk chunk;
+    xQueueReceive(free_queue_, &chunk, portMAX_DELAY);
+    chunk.offset = 0;
+
+    size_t received = 0, recent_read = 0;
+    int retries = 0, resumes = 0;
+    int64_t stall_us = 0;
+    bool completed = false;
+    auto start_time = esp_timer_get_time();
+    auto last_calc_time = start_time;
+
+    while (!writer_failed_) {
+        if (retries > 0) {
+            if (retries > DOWNLOAD_PIPELINE_MAX_RETRIES) {
+                ESP_LOGE(TAG, "Giving up after %d retries at %u/%u", DOWNLOAD_PIPELINE_MAX_RETRIES, received, total_size_);
+                break;
+            }
+            ESP_LOGW(TAG, "Retrying download from offset %u in %d ms (%d/%d)", received,
+                DOWNLOAD_PIPELINE_RETRY_DELAY_MS * retries, retries, DOWNLOAD_PIPELINE_MAX_RETRIES);
+            vTaskDelay(pdMS_TO_TICKS(DOWNLOAD_PIPELINE_RETRY_DELAY_MS * retries));
+        }
+        retries++;
+
+        auto http = pool.Acquire(0, url);
+        bool ranged = received > 0;
+        if (ranged) {
+            resumes++;
+        }
+        bool opened = pool.Open(http, 0, "GET", url, [ranged, received](Http* http) {
+            // A pooled connection may carry the body of an earlier POST
+            http->SetContent(std::string());
+            if (ranged) {
+                http->SetHeader("Range", "bytes=" + std::to_string(received) + "-");
+            }
+        });
+        if (!opened) {
+            ESP_LOGE(TAG, "Failed to open HTTP connection");
+            continue;
+        }
+
+        // Bytes of the response body to drop when the server ignores the Range header
+        size_t skip = 0;
+        int status_code = http->GetStatusCode();
+        size_t body_length = http->GetBodyLength();
+        if (status_code == 206 && received > 0) {
+            if (received + body_length != total_size_) {
+                ESP_LOGE(TAG, "Unexpected partial content length %u at offset %u", body_length, received);
+                http->Close();
+                break;
+            }
+        } else if (status_code == 200) {
+            if (body_length == 0) {
+                ESP_LOGE(TAG, "Failed to get content length");
+                http->Close();
+                break;
+            }
+            if (total_size_ == 0) {
+                total_size_ = body_length;
+            } else if (body_length != total_size_) {
+                ESP_LOGE(TAG, "Content length changed from %u to %u", total_size_, body_length);
+                http->Close();
+                break;
+            }
+            if (received > 0) {
+                ESP_LOGW(TAG, "Server does not support Range, skipping %u bytes", received);
+                skip = received;
+            }
+        } else {
+            ESP_LOGE(TAG, "Failed to download, status code: %d", status_code);
+            http->Close();
+            if (status_code >= 400 && status_code < 500) {
+                break;
+            }
+            continue;
+        }
+
+        while (received < total_size_) {
+            if (chunk.length == buffer_size_) {
+                size_t next_offset = chunk.offset + chunk.length;
+                if (!Submit(chunk, stall_us)) {
+                    break;
+                }
+                chunk.offset = next_offset;
+            }
+
+            // Skipped bytes land in the unused tail of the buffer and are overwritten
+            size_t to_read = buffer_size_ - chunk.length;
+            if (skip > 0) {
+                to_read = std::min(to_read, skip);
+            }
+            int ret = http->Read((char*)chunk.data + chunk.length, to_read);
+            if (ret <= 0) {
+                ESP_LOGW(TAG, "Connection ended at %u/%u: %s", received, total_size_,
+                    ret < 0 ? esp_err_to_name(ret) : "EOF");
+                break;
+            }
+            if (skip > 0) {
+                skip -= ret;
+                continue;
+            }
+
+            chunk.length += ret;
+            received += ret;
+            recent_read += ret;
+            retries = 0;
+
+            // Calculate speed and progress every second
+            if (esp_timer_get_time() - last_calc_time >= 1000000 || received == total_size_) {
+                size_t progress = received * 100 / total_size_;
+                ESP_LOGI(TAG, "Progress: %u%% (%u/%u), Speed: %uB/s", progress, received, total_size_, recent_read);
+                if (progress_callback) {
+                    progress_callback(progress, recent_read);
+                }
+                last_calc_time = esp_timer_get_time();
+                recent_read = 0;
+            }
+        }
+
+        if (received == total_size_) {
+            // The Range header would stick to the connection, so only a plain request is kept
+            if (ranged) {
+                http->Close();
+            } else {
+                pool.Release(0, url, std::move(http));
+            }
+            completed = true;
+            break;
+        }
+        http->Close();
+    }
+
+    // Flush the last partial buffer, then stop the writer
+    if (completed && chunk.length > 0 && !writer_failed_) {
+        xQueueSend(full_queue_, &chunk, portMAX_DELAY);
+    }
+    Chunk end_marker = {nullptr, 0, 0};
+    xQueueSend(full_queue_, &end_marker, portMAX_DELAY);
+    xSemaphoreTake(writer_done_, portMAX_DELAY);
+    Release();
+
+    if (!completed || writer_failed_) {
+        return false;
+    }
+
+    auto elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
+    // newlib nano printf has no %llu, the rate is computed in 64 bits and printed as 32 bits
+    uint32_t rate = elapsed_ms > 0 ? (uint32_t)((uint64_t)total_size_ * 1000 / elapsed_ms) : 0;
+    ESP_LOGI(TAG, "Downloaded %u bytes in %lu ms, average %luB/s, %d resumes, writer busy %lu ms, download stalled %lu ms",
+        total_size_, (uint32_t)elapsed_ms, rate,
+        resumes, (uint32_t)(writer_busy_us_ / 1000), (uint32_t)(stall_us / 1000));
+
+    if (!expected_sha256_.empty()) {
+        auto sha256 = GetSha256();
+        if (strcasecmp(sha256.c_str(), expected_sha256_.c_str()) != 0) {
+            ESP_LOGE(TAG, "SHA-256 mismatch, expected %s, got %s", expected_sha256_.c_str(), sha256.c_str());
+            return false;
+        }
+        ESP_LOGI(TAG, "SHA-256 verified: %s", sha256.c_str());
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef DOWNLOAD_PIPELINE_H
+#define DOWNLOAD_PIPELINE_H
+
+#include <functional>
+#include <string>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <mbedtls/sha256.h>
+
+// 乒乓缓冲区大小，下载任务填满一块后交给写入任务
+#define DOWNLOAD_PIPELINE_BUFFER_SIZE       (16 * 1024)
+#define DOWNLOAD_PIPELINE_BUFFER_COUNT      2
+// 连续多少次没有任何进展的重连后放弃
+#define DOWNLOAD_PIPELINE_MAX_RETRIES       5
+#define DOWNLOAD_PIPELINE_RETRY_DELAY_MS    2000
+#define DOWNLOAD_PIPELINE_WRITER_STACK_SIZE 4096
+
+/**
+ * Downloads a URL on the calling task while a writer task consumes the data,
+ * so network receive keeps going while flash is being erased and written.
+ * A dropped connection is resumed with an HTTP Range request from the last
+ * byte received; the data is hashed with SHA-256 on the writer side.
+ */
+class DownloadPipeline {
+public:
+    // Runs on the writer task, data arrives in stream order. Return false to abort.
+    typedef std::function<bool(const uint8_t* data, size_t length, size_t offset)> WriteCallback;
+    typedef std::function<void(int progress, size_t speed)> ProgressCallback;
+
+    DownloadPipeline(size_t buffer_size = DOWNLOAD_PIPELINE_BUFFER_SIZE);
+    ~DownloadPipeline();
+
+    // Lowercase or uppercase hex digest, empty to skip verification
+    void SetExpectedSha256(const std::string& sha256) { expected_sha256_ = sha256; }
+    bool Run(const std::string& url, WriteCallback write_callback, ProgressCallback progress_callback);
+
+    size_t GetTotalSize() const { return total_size_; }
+    std::string GetSha256() const;
+
+private:
+    struct Chunk {
+        uint8_t* data;
+        size_t length;
+        size_t offset;
+    };
+
+    size_t buffer_size_;
+    uint8_t* buffers_[DOWNLOAD_PIPELINE_BUFFER_COUNT] = {};
+    QueueHandle_t free_queue_ = nullptr;
+    QueueHandle_t full_queue_ = nullptr;
+    SemaphoreHandle_t writer_done_ = nullptr;
+    WriteCallback write_callback_;
+    mbedtls_sha256_context sha256_ctx_;
+    uint8_t sha256_[32] = {};
+    std::string expected_sha256_;
+    size_t total_size_ = 0;
+    volatile bool writer_failed_ = false;
+    int64_t writer_busy_us_ = 0;
+
+    bool Allocate();
+    void Release();
+    void WriterTask();
+    bool Submit(Chunk& chunk, int64_t& stall_us);
+};
+
+#endif // DOWNLOAD_PIPELINE_H
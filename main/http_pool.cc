@@ -0,0 +1,190 @@
+#include "http_pool.h"
+#include "board.h"
+#include "application.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "HttpPool"
+
+
+HttpPool::HttpPool() {
+    esp_timer_create_args_t idle_timer_args = {
+        .callback = [](void* arg) {
+            // Closing may be a blocking modem round trip, keep it off the esp_timer task
+            auto pool = (HttpPool*)arg;
+            Application::GetInstance().Schedule([pool]() {
+                pool->CloseExpired();
+            });
+        },
+        .arg = this,
+        .name = "http_pool_idle",
+    };
+    esp_timer_create(&idle_timer_args, &idle_timer_);
+}
+
+HttpPool::~HttpPool() {
+    if (idle_timer_ != nullptr) {
+        esp_timer_stop(idle_timer_);
+        esp_timer_delete(idle_timer_);
+    }
+}
+
+// scheme://host[:port], the part of the URL a connection is bound to
+std::string HttpPool::GetOrigin(const std::string& url) {
+    size_t pos = url.find("://");
+    pos = (pos == std::string::npos) ? 0 : pos + 3;
+    size_t end = url.find_first_of("/?#", pos);
+    return url.substr(0, end);
+}
+
+void HttpPool::CloseIdle(int connect_id) {
+    for (auto it = idle_.begin(); it != idle_.end();) {
+        if (it->connect_id == connect_id) {
+            it->http->Close();
+            it = idle_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Idle connections hold a socket slot and TLS buffers, close them once they can no longer be reused
+void HttpPool::CloseExpired() {
+    std::list<IdleConnection> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = esp_timer_get_time();
+        int64_t next_expire = 0;
+        for (auto it = idle_.begin(); it != idle_.end();) {
+            auto expire = it->idle_since + HTTP_POOL_IDLE_TIMEOUT_MS * 1000LL;
+            if (expire <= now) {
+                auto next = std::next(it);
+                expired.splice(expired.end(), idle_, it);
+                it = next;
+                continue;
+            }
+            if (next_expire == 0 || expire < next_expire) {
+                next_expire = expire;
+            }
+            ++it;
+        }
+        // A release may have started the timer again before this ran
+        if (next_expire > 0) {
+            esp_timer_stop(idle_timer_);
+            esp_timer_start_once(idle_timer_, next_expire - now);
+        }
+    }
+    // Out of the pool already, so requests on other connect ids are not held up by the close
+    for (auto& connection : expired) {
+        ESP_LOGI(TAG, "Closing idle connection to %s", connection.origin.c_str());
+        connection.http->Close();
+    }
+}
+
+std::unique_ptr<Http> HttpPool::Acquire(int connect_id, const std::string& url) {
+    auto origin = GetOrigin(url);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = esp_timer_get_time();
+        for (auto it = idle_.begin(); it != idle_.end(); ++it) {
+            if (it->connect_id != connect_id) {
+                continue;
+            }
+            if (it->origin == origin && now - it->idle_since < HTTP_POOL_IDLE_TIMEOUT_MS * 1000LL) {
+                auto http = std::move(it->http);
+                idle_.erase(it);
+                reused_.insert(http.get());
+                // An earlier request may have changed the timeout, e.g. the activation long poll
+                http->SetTimeout(HTTP_POOL_DEFAULT_TIMEOUT_MS);
+                return http;
+            }
+            // Another host or idle for too long, free the connect id for a new connection
+            it->http->Close();
+            idle_.erase(it);
+            break;
+        }
+    }
+    return Board::GetInstance().GetNetwork()->CreateHttp(connect_id);
+}
+
+void HttpPool::Release(int connect_id, const std::string& url, std::unique_ptr<Http> http) {
+    if (!http) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    reused_.erase(http.get());
+    CloseIdle(connect_id);
+    idle_.push_back(IdleConnection{connect_id, GetOrigin(url), std::move(http), esp_timer_get_time()});
+    if (!esp_timer_is_active(idle_timer_)) {
+        esp_timer_start_once(idle_timer_, HTTP_POOL_IDLE_TIMEOUT_MS * 1000LL);
+    }
+}
+
+std::unique_ptr<Http> HttpPool::Create(int connect_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CloseIdle(connect_id);
+    }
+    return Board::GetInstance().GetNetwork()->CreateHttp(connect_id);
+}
+
+bool HttpPool::Open(std::unique_ptr<Http>& http, int connect_id, const std::string& method, const std::string& url,
+    const std::function<void(Http*)>& setup) {
+    bool reused;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reused = reused_.erase(http.get()) > 0;
+    }
+
+    setup(http.get());
+    auto start_time = esp_timer_get_time();
+    bool success = http->Open(method, url);
+    auto elapsed = esp_timer_get_time() - start_time;
+
+    if (reused && !success) {
+        // The server has closed the idle connection, retry once on a new one
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stale_count_++;
+        }
+        ESP_LOGW(TAG, "Reused connection to %s failed, opening a new one", GetOrigin(url).c_str());
+        http->Close();
+        http = Board::GetInstance().GetNetwork()->CreateHttp(connect_id);
+        setup(http.get());
+        reused = false;
+        start_time = esp_timer_get_time();
+        success = http->Open(method, url);
+        elapsed = esp_timer_get_time() - start_time;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reused) {
+        reused_count_++;
+        reused_open_us_ += elapsed;
+    } else {
+        new_count_++;
+        new_open_us_ += elapsed;
+        ESP_LOGI(TAG, "New connection to %s opened in %d ms", GetOrigin(url).c_str(), int(elapsed / 1000));
+    }
+    return success;
+}
+
+void HttpPool::Clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& connection : idle_) {
+            connection.http->Close();
+        }
+        idle_.clear();
+        reused_.clear();
+        esp_timer_stop(idle_timer_);
+    }
+    LogStatistics();
+}
+
+void HttpPool::LogStatistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ESP_LOGI(TAG, "Connections: %d new (%d ms opening, handshakes included), %d reused (%d ms opening), %d stale",
+        new_count_, int(new_open_us_ / 1000), reused_count_, int(reused_open_us_ / 1000), stale_count_);
+}
@@ -0,0 +1,77 @@
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <http.h>
+#include <esp_timer.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+// 空闲连接保留时间，超过后由定时器通知主任务关闭
+#define HTTP_POOL_IDLE_TIMEOUT_MS   15000
+// 复用连接的读写超时，与网络组件新建连接的默认值一致
+#define HTTP_POOL_DEFAULT_TIMEOUT_MS    30000
+
+/**
+ * Keeps finished HTTP connections open so the next request to the same
+ * host skips the TCP and TLS handshake.
+ * At most one idle connection is kept per connect id, since on cellular
+ * modules the connect id is a socket slot that only one connection may use.
+ */
+class HttpPool {
+public:
+    static HttpPool& GetInstance() {
+        static HttpPool instance;
+        return instance;
+    }
+
+    // Returns the idle connection to the same host on this connect id with the default timeout, or a new one
+    std::unique_ptr<Http> Acquire(int connect_id, const std::string& url);
+    // The response body must have been read completely, and no per-request header set
+    void Release(int connect_id, const std::string& url, std::unique_ptr<Http> http);
+    // New connection that is not returned to the pool, frees the connect id first
+    std::unique_ptr<Http> Create(int connect_id);
+    // Applies setup and opens the request, accounting the time to new and reused connections.
+    // A reused connection the server has closed is replaced by a new one and opened once more
+    bool Open(std::unique_ptr<Http>& http, int connect_id, const std::string& method, const std::string& url,
+        const std::function<void(Http*)>& setup);
+    // Closes all idle connections, they hold sockets and TLS buffers
+    void Clear();
+    void LogStatistics();
+
+private:
+    HttpPool();
+    ~HttpPool();
+    HttpPool(const HttpPool&) = delete;
+    HttpPool& operator=(const HttpPool&) = delete;
+
+    struct IdleConnection {
+        int connect_id;
+        std::string origin;
+        std::unique_ptr<Http> http;
+        int64_t idle_since;
+    };
+
+    std::mutex mutex_;
+    std::list<IdleConnection> idle_;
+    esp_timer_handle_t idle_timer_ = nullptr;
+    // Handed out from the pool and not opened yet
+    std::set<Http*> reused_;
+
+    int new_count_ = 0;
+    int reused_count_ = 0;
+    int stale_count_ = 0;
+    int64_t new_open_us_ = 0;
+    int64_t reused_open_us_ = 0;
+
+    static std::string GetOrigin(const std::string& url);
+    void CloseIdle(int connect_id);
+    // Runs on the main task, the idle timer only schedules it
+    void CloseExpired();
+};
+
+#endif // HTTP_POOL_H
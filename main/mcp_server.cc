@@ -15,6 +15,7 @@
 #include "oled_display.h"
 #include "board.h"
 #include "settings.h"
+#include "http_pool.h"
 #include "lvgl_theme.h"
 #include "lvgl_display.h"
 
@@ -214,7 +215,7 @@ void McpServer::AddUserOnlyTools() {
                 // 构造multipart/form-data请求体
                 std::string boundary = "----ESP32_SCREEN_SNAPSHOT_BOUNDARY";
                 
-                auto http = Board::GetInstance().GetNetwork()->CreateHttp(3);
+                auto http = HttpPool::GetInstance().Create(3);
                 http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
                 if (!http->Open("POST", url)) {
                     throw std::runtime_error("Failed to open URL: " + url);
@@ -255,7 +256,7 @@ void McpServer::AddUserOnlyTools() {
             }),
             [display](const PropertyList& properties) -> ReturnValue {
                 auto url = properties["url"].value<std::string>();
-                auto http = Board::GetInstance().GetNetwork()->CreateHttp(3);
+                auto http = HttpPool::GetInstance().Create(3);
 
                 if (!http->Open("GET", url)) {
                     throw std::runtime_error("Failed to open URL: " + url);
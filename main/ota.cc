@@ -1,5 +1,8 @@
 #include "ota.h"
+#include "download_pipeline.h"
+#include "delta_patcher.h"
 #include "system_info.h"
+#include "http_pool.h"
 #include "settings.h"
 #include "assets/lang_config.h"
 
@@ -52,10 +55,8 @@ std::string Ota::GetCheckVersionUrl() {
     return url + CONFIG_MANUFACTURER_CODE;
 }
 
-std::unique_ptr<Http> Ota::SetupHttp() {
+void Ota::SetupHttp(Http* http) {
     auto& board = Board::GetInstance();
-    auto network = board.GetNetwork();
-    auto http = network->CreateHttp(0);
     auto user_agent = SystemInfo::GetUserAgent();
     http->SetHeader("Activation-Version", has_serial_number_ ? "2" : "1");
     http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
@@ -67,8 +68,6 @@ std::unique_ptr<Http> Ota::SetupHttp() {
     http->SetHeader("User-Agent", user_agent);
     http->SetHeader("Accept-Language", Lang::CODE);
     http->SetHeader("Content-Type", "application/json");
-
-    return http;
 }
 
 /* 
@@ -88,13 +87,18 @@ esp_err_t Ota::CheckVersion() {
         return ESP_ERR_INVALID_ARG;
     }
 
-    auto http = SetupHttp();
+    // Check version and activation go to the same server, reuse the connection
+    auto& pool = HttpPool::GetInstance();
+    auto http = pool.Acquire(0, url);
+    check_version_count_++;
 
     std::string data = board.GetSystemInfoJson();
     std::string method = data.length() > 0 ? "POST" : "GET";
-    http->SetContent(std::move(data));
-
-    if (!http->Open(method, url)) {
+    bool opened = pool.Open(http, 0, method, url, [this, &data](Http* http) {
+        SetupHttp(http);
+        http->SetContent(std::string(data));
+    });
+    if (!opened) {
         int last_error = http->GetLastError();
         ESP_LOGE(TAG, "Failed to open HTTP connection, code=0x%x", last_error);
         return last_error;
@@ -107,7 +111,7 @@ esp_err_t Ota::CheckVersion() {
     }
 
     data = http->ReadAll();
-    http->Close();
+    pool.Release(0, url, std::move(http));
 
     // Response: { "firmware": { "version": "1.0.0", "url": "http://" } }
     // Parse the JSON response and check if the version is newer
@@ -225,6 +229,34 @@ esp_err_t Ota::CheckVersion() {
         if (cJSON_IsString(url)) {
             firmware_url_ = url->valuestring;
         }
+        // Optional, verified against the streaming digest before the image is accepted
+        firmware_sha256_.clear();
+        cJSON *sha256 = cJSON_GetObjectItem(firmware, "sha256");
+        if (cJSON_IsString(sha256)) {
+            firmware_sha256_ = sha256->valuestring;
+        }
+        // A patch is only usable when it was made against the build we are running
+        delta_url_.clear();
+        delta_sha256_.clear();
+        cJSON *delta = cJSON_GetObjectItem(firmware, "delta");
+        if (cJSON_IsObject(delta)) {
+            cJSON *delta_url = cJSON_GetObjectItem(delta, "url");
+            cJSON *base = cJSON_GetObjectItem(delta, "base");
+            cJSON *delta_sha256 = cJSON_GetObjectItem(delta, "sha256");
+            char elf_sha256[65];
+            for (int i = 0; i < 32; i++) {
+                snprintf(elf_sha256 + i * 2, 3, "%02x", app_desc->app_elf_sha256[i]);
+            }
+            if (cJSON_IsString(delta_url) && cJSON_IsString(base) && strcasecmp(base->valuestring, elf_sha256) == 0) {
+                delta_url_ = delta_url->valuestring;
+                if (cJSON_IsString(delta_sha256)) {
+                    delta_sha256_ = delta_sha256->valuestring;
+                }
+                ESP_LOGI(TAG, "Delta update available");
+            } else {
+                ESP_LOGI(TAG, "Delta update does not match the running build, using full image");
+            }
+        }
 
         if (cJSON_IsString(version) && cJSON_IsString(url)) {
             // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -268,7 +300,15 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
-bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progress, size_t speed)> callback) {
+bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progress, size_t speed)> callback,
+    const std::string& firmware_sha256, const std::string& delta_url, const std::string& delta_sha256) {
+    if (!delta_url.empty()) {
+        if (UpgradeDelta(delta_url, callback, delta_sha256)) {
+            return true;
+        }
+        ESP_LOGW(TAG, "Delta upgrade failed, falling back to full image");
+    }
+
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
     esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
@@ -278,82 +318,103 @@ bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progre
     }
 
     ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
-    bool image_header_checked = false;
-    std::string image_header;
+    bool ota_begun = false;
+
+    // Download and flash writes overlap, esp_ota_write runs on the pipeline's writer task
+    DownloadPipeline pipeline;
+    pipeline.SetExpectedSha256(firmware_sha256);
+    bool success = pipeline.Run(firmware_url, [&](const uint8_t* data, size_t length, size_t offset) {
+        if (offset == 0) {
+            const size_t header_size = sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t);
+            if (length < header_size) {
+                ESP_LOGE(TAG, "Firmware image is too small");
+                return false;
+            }
+            esp_app_desc_t new_app_info;
+            memcpy(&new_app_info, data + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
 
-    auto network = Board::GetInstance().GetNetwork();
-    auto http = network->CreateHttp(0);
-    if (!http->Open("GET", firmware_url)) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection");
+            auto current_version = esp_app_get_description()->version;
+            ESP_LOGI(TAG, "Current version: %s, New version: %s", current_version, new_app_info.version);
+
+            if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
+                ESP_LOGE(TAG, "Failed to begin OTA");
+                return false;
+            }
+            ota_begun = true;
+        }
+
+        auto err = esp_ota_write(update_handle, data, length);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
+            return false;
+        }
+        return true;
+    }, callback);
+
+    if (!success) {
+        if (ota_begun) {
+            esp_ota_abort(update_handle);
+        }
         return false;
     }
 
-    if (http->GetStatusCode() != 200) {
-        ESP_LOGE(TAG, "Failed to get firmware, status code: %d", http->GetStatusCode());
+    return FinishUpgrade(update_handle, update_partition);
+}
+
+bool Ota::UpgradeDelta(const std::string& delta_url, std::function<void(int progress, size_t speed)> callback,
+    const std::string& delta_sha256) {
+    ESP_LOGI(TAG, "Upgrading firmware with delta from %s", delta_url.c_str());
+    auto running_partition = esp_ota_get_running_partition();
+    auto update_partition = esp_ota_get_next_update_partition(NULL);
+    if (update_partition == NULL) {
+        ESP_LOGE(TAG, "Failed to get update partition");
         return false;
     }
 
-    size_t content_length = http->GetBodyLength();
-    if (content_length == 0) {
-        ESP_LOGE(TAG, "Failed to get content length");
+    // The patch header carries the digest of the image it was made against
+    uint8_t base_sha256[32];
+    if (esp_partition_get_sha256(running_partition, base_sha256) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to get running image digest");
         return false;
     }
 
-    char buffer[512];
-    size_t total_read = 0, recent_read = 0;
-    auto last_calc_time = esp_timer_get_time();
-    while (true) {
-        int ret = http->Read(buffer, sizeof(buffer));
-        if (ret < 0) {
-            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
-            return false;
-        }
-
-        // Calculate speed and progress every second
-        recent_read += ret;
-        total_read += ret;
-        if (esp_timer_get_time() - last_calc_time >= 1000000 || ret == 0) {
-            size_t progress = total_read * 100 / content_length;
-            ESP_LOGI(TAG, "Progress: %u%% (%u/%u), Speed: %uB/s", progress, total_read, content_length, recent_read);
-            if (callback) {
-                callback(progress, recent_read);
-            }
-            last_calc_time = esp_timer_get_time();
-            recent_read = 0;
-        }
-
-        if (ret == 0) {
-            break;
-        }
-
-        if (!image_header_checked) {
-            image_header.append(buffer, ret);
-            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
-                esp_app_desc_t new_app_info;
-                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
-                
-                auto current_version = esp_app_get_description()->version;
-                ESP_LOGI(TAG, "Current version: %s, New version: %s", current_version, new_app_info.version);
-
-                if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
-                    esp_ota_abort(update_handle);
-                    ESP_LOGE(TAG, "Failed to begin OTA");
-                    return false;
-                }
+    esp_ota_handle_t update_handle = 0;
+    if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to begin OTA");
+        return false;
+    }
 
-                image_header_checked = true;
-                std::string().swap(image_header);
-            }
-        }
-        auto err = esp_ota_write(update_handle, buffer, ret);
+    // Holds the output buffer, keep it off the caller's stack
+    auto patcher = std::make_unique<DeltaPatcher>([running_partition](size_t offset, uint8_t* data, size_t length) {
+        return esp_partition_read(running_partition, offset, data, length) == ESP_OK;
+    }, [&update_handle](const uint8_t* data, size_t length) {
+        auto err = esp_ota_write(update_handle, data, length);
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
-            esp_ota_abort(update_handle);
             return false;
         }
+        return true;
+    });
+    patcher->SetBaseSha256(base_sha256);
+
+    // Patching runs on the pipeline's writer task, the download keeps going meanwhile
+    auto start_time = esp_timer_get_time();
+    DownloadPipeline pipeline;
+    pipeline.SetExpectedSha256(delta_sha256);
+    bool success = pipeline.Run(delta_url, [&patcher](const uint8_t* data, size_t length, size_t offset) {
+        return patcher->Feed(data, length);
+    }, callback);
+    if (!success || !patcher->Finish()) {
+        esp_ota_abort(update_handle);
+        return false;
     }
-    http->Close();
 
+    auto elapsed_ms = (esp_timer_get_time() - start_time) / 1000;
+    ESP_LOGI(TAG, "Delta %u bytes rebuilt %u byte image in %lu ms", pipeline.GetTotalSize(), patcher->GetNewSize(), (uint32_t)elapsed_ms);
+    return FinishUpgrade(update_handle, update_partition);
+}
+
+bool Ota::FinishUpgrade(esp_ota_handle_t update_handle, const esp_partition_t* update_partition) {
     esp_err_t err = esp_ota_end(update_handle);
     if (err != ESP_OK) {
         if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
@@ -375,7 +436,7 @@ bool Ota::Upgrade(const std::string& firmware_url, std::function<void(int progre
 }
 
 bool Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
-    return Upgrade(firmware_url_, callback);
+    return Upgrade(firmware_url_, callback, firmware_sha256_, delta_url_, delta_sha256_);
 }
 
 
@@ -456,24 +517,35 @@ esp_err_t Ota::Activate() {
         url += "activate";
     }
 
-    auto http = SetupHttp();
+    auto& pool = HttpPool::GetInstance();
+    auto http = pool.Acquire(0, url);
+    activate_count_++;
 
     std::string data = GetActivationPayload();
-    http->SetContent(std::move(data));
-
-    if (!http->Open("POST", url)) {
+    bool opened = pool.Open(http, 0, "POST", url, [this, &data](Http* http) {
+        SetupHttp(http);
+        // The server holds the request until the device is bound or timeout_ms has passed
+        http->SetTimeout(activation_timeout_ms_ + ACTIVATION_TIMEOUT_MARGIN_MS);
+        http->SetContent(std::string(data));
+    });
+    if (!opened) {
         ESP_LOGE(TAG, "Failed to open HTTP connection");
         return ESP_FAIL;
     }
     
     auto status_code = http->GetStatusCode();
     if (status_code == 202) {
+        // Read the body so the connection can carry the next attempt
+        http->ReadAll();
+        pool.Release(0, url, std::move(http));
         return ESP_ERR_TIMEOUT;
     }
     if (status_code != 200) {
         ESP_LOGE(TAG, "Failed to activate, code: %d, body: %s", status_code, http->ReadAll().c_str());
         return ESP_FAIL;
     }
+    http->ReadAll();
+    pool.Release(0, url, std::move(http));
 
     ESP_LOGI(TAG, "Activation successful");
     return ESP_OK;
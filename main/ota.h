@@ -5,8 +5,12 @@
 #include <string>
 
 #include <esp_err.h>
+#include <esp_ota_ops.h>
 #include "board.h"
 
+// 激活请求为长轮询，网络超时在服务端保持时间之上留出余量
+#define ACTIVATION_TIMEOUT_MARGIN_MS    5000
+
 class Ota {
 public:
     Ota();
@@ -21,14 +25,21 @@ public:
     bool HasActivationCode() { return has_activation_code_; }
     bool HasServerTime() { return has_server_time_; }
     bool StartUpgrade(std::function<void(int progress, size_t speed)> callback);
-    static bool Upgrade(const std::string& firmware_url, std::function<void(int progress, size_t speed)> callback);
+    static bool Upgrade(const std::string& firmware_url, std::function<void(int progress, size_t speed)> callback,
+        const std::string& firmware_sha256 = "", const std::string& delta_url = "", const std::string& delta_sha256 = "");
     void MarkCurrentVersionValid();
 
     const std::string& GetFirmwareVersion() const { return firmware_version_; }
     const std::string& GetCurrentVersion() const { return current_version_; }
     const std::string& GetFirmwareUrl() const { return firmware_url_; }
+    const std::string& GetFirmwareSha256() const { return firmware_sha256_; }
+    const std::string& GetDeltaUrl() const { return delta_url_; }
+    const std::string& GetDeltaSha256() const { return delta_sha256_; }
     const std::string& GetActivationMessage() const { return activation_message_; }
     const std::string& GetActivationCode() const { return activation_code_; }
+    int GetActivationTimeoutMs() const { return activation_timeout_ms_; }
+    int GetCheckVersionCount() const { return check_version_count_; }
+    int GetActivateCount() const { return activate_count_; }
     std::string GetCheckVersionUrl();
 
 private:
@@ -45,15 +56,23 @@ private:
     std::string current_version_;
     std::string firmware_version_;
     std::string firmware_url_;
+    std::string firmware_sha256_;
+    std::string delta_url_;
+    std::string delta_sha256_;
     std::string activation_challenge_;
     std::string serial_number_;
     int activation_timeout_ms_ = 30000;
+    int check_version_count_ = 0;
+    int activate_count_ = 0;
 
     std::function<void(int progress, size_t speed)> upgrade_callback_;
     std::vector<int> ParseVersion(const std::string& version);
     bool IsNewVersionAvailable(const std::string& currentVersion, const std::string& newVersion);
     std::string GetActivationPayload();
-    std::unique_ptr<Http> SetupHttp();
+    void SetupHttp(Http* http);
+    static bool UpgradeDelta(const std::string& delta_url, std::function<void(int progress, size_t speed)> callback,
+        const std::string& delta_sha256);
+    static bool FinishUpgrade(esp_ota_handle_t update_handle, const esp_partition_t* update_partition);
 };
 
 #endif // _OTA_H
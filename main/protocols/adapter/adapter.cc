@@ -1,5 +1,6 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/queue.h>
 #include <freertos/task.h>
 #include <sys/time.h>
 #include <cJSON.h>
@@ -10,6 +11,7 @@
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 #define ADAPTER_LOG_TAG    "[ADAPTER]"
 #define LOG_LEVEL_ENABLED  LOG_INFO_LEVEL
@@ -88,69 +90,235 @@ sip_ret_t adapter_start_thread(void (*task_func)(void*), const char* name, int s
 }
 
 /**
- * 以下封装定时任务的启动函数
+ * 以下是定时器时间轮，所有定时任务共用一个任务执行。
+ * 每个槽是一个按到期时间未排序的单链表，定时器按绝对到期 tick 挂到 tick % SLOTS 的槽上，
+ * 超过一圈的定时器留在槽中直到 tick 相等时才触发。任务只在最近的非空槽到期或有新定时器加入时唤醒。
  */
 typedef void (*timer_task_cb_t)(void *arg);
-typedef struct
-{
-    TickType_t       period_ticks;
-    timer_task_cb_t  callback;
-    void            *arg;
-} timer_task_ctx_t;
-
-static void timer_task_entry(void *param)
-{
-    timer_task_ctx_t *ctx = (timer_task_ctx_t *)param;
-    TickType_t lastWakeTime = xTaskGetTickCount();
-
-    for (;;)
-    {
-        ctx->callback(ctx->arg);
-        vTaskDelayUntil(&lastWakeTime, ctx->period_ticks);
+
+typedef enum {
+    TIMER_STATE_FREE = 0,
+    TIMER_STATE_PENDING,   // 挂在时间轮上
+    TIMER_STATE_FIRING,    // 回调执行中
+    TIMER_STATE_STOPPED    // 回调执行中被停止，回调结束后释放
+} timer_state_t;
+
+typedef struct wheel_timer {
+    timer_task_cb_t     callback;
+    void               *arg;
+    uint32_t            period_ticks;
+    uint64_t            expire_tick;
+    uint16_t            generation;
+    timer_state_t       state;
+    struct wheel_timer *next;
+} wheel_timer_t;
+
+static wheel_timer_t s_timers[SIP_TIMER_MAX];
+static wheel_timer_t *s_wheel[SIP_TIMER_WHEEL_SLOTS];
+static uint64_t s_wheel_tick = 0;
+static TaskHandle_t s_timer_task = NULL;
+static sip_timer_stats_t s_timer_stats = {0};
+static StaticSemaphore_t s_timer_mutex_buf;
+static SemaphoreHandle_t s_timer_mutex = xSemaphoreCreateMutexStatic(&s_timer_mutex_buf);
+
+static uint64_t timer_now_ms(){
+    // 单调时钟，不受 SNTP 校时影响，64 位不会回绕
+    return (uint64_t)(esp_timer_get_time() / 1000);
+}
+
+static void wheel_insert(wheel_timer_t *timer){
+    // 到期 tick 不能早于下一次处理的 tick，否则要等一整圈
+    if (timer->expire_tick <= s_wheel_tick) {
+        timer->expire_tick = s_wheel_tick + 1;
+    }
+    wheel_timer_t **slot = &s_wheel[timer->expire_tick % SIP_TIMER_WHEEL_SLOTS];
+    timer->next = *slot;
+    *slot = timer;
+    timer->state = TIMER_STATE_PENDING;
+}
+
+static void wheel_remove(wheel_timer_t *timer){
+    wheel_timer_t **link = &s_wheel[timer->expire_tick % SIP_TIMER_WHEEL_SLOTS];
+    while (*link) {
+        if (*link == timer) {
+            *link = timer->next;
+            timer->next = NULL;
+            return;
+        }
+        link = &(*link)->next;
     }
 }
 
-sip_ret_t adapter_start_periodic_task(void (*timer_task_cb)(void*), int period_ms, int stack_size, void* arg){
-    static timer_task_ctx_t ctx_pool[8];
-    static uint8_t index = 0;
+/**
+ * 下一个非空槽距当前 tick 的距离，没有定时器时返回 0
+ */
+static uint32_t wheel_next_ticks(){
+    for (uint32_t i = 1; i <= SIP_TIMER_WHEEL_SLOTS; i++) {
+        if (s_wheel[(s_wheel_tick + i) % SIP_TIMER_WHEEL_SLOTS]) {
+            return i;
+        }
+    }
+    return 0;
+}
 
-    if (index >= 8 || timer_task_cb == NULL)
-        return RET_ERROR;
+static void record_lateness(uint32_t lateness_ms){
+    s_timer_stats.fired++;
+    s_timer_stats.last_lateness_ms = lateness_ms;
+    s_timer_stats.total_lateness_ms += lateness_ms;
+    if (lateness_ms > s_timer_stats.max_lateness_ms) {
+        s_timer_stats.max_lateness_ms = lateness_ms;
+    }
+}
 
-    timer_task_ctx_t *ctx = &ctx_pool[index];
-    ctx->period_ticks = pdMS_TO_TICKS(period_ms);
-    ctx->callback     = timer_task_cb;
-    ctx->arg          = arg;
-    std::string name = "timer_task_" + std::to_string(index++);
+static void timer_wheel_task(void *param){
+    wheel_timer_t *due[SIP_TIMER_MAX];
+
+    for (;;) {
+        int due_count = 0;
+        xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+        uint64_t now_tick = timer_now_ms() / SIP_TIMER_WHEEL_TICK_MS;
+        while (now_tick > s_wheel_tick) {
+            s_wheel_tick++;
+            wheel_timer_t **link = &s_wheel[s_wheel_tick % SIP_TIMER_WHEEL_SLOTS];
+            while (*link) {
+                wheel_timer_t *timer = *link;
+                if (timer->expire_tick != s_wheel_tick) {
+                    link = &timer->next;
+                    continue;
+                }
+                *link = timer->next;
+                timer->next = NULL;
+                timer->state = TIMER_STATE_FIRING;
+                due[due_count++] = timer;
+            }
+        }
+        xSemaphoreGive(s_timer_mutex);
+
+        // 回调中可以启动或停止定时器，因此不持有锁
+        for (int i = 0; i < due_count; i++) {
+            wheel_timer_t *timer = due[i];
+            // 延迟从到期 tick 开始计算，不包含时间轮精度带来的取整
+            uint64_t now_ms = timer_now_ms();
+            uint64_t expire_ms = timer->expire_tick * SIP_TIMER_WHEEL_TICK_MS;
+            uint32_t lateness_ms = now_ms > expire_ms ? (uint32_t)(now_ms - expire_ms) : 0;
+            if (lateness_ms > SIP_TIMER_LATENESS_WARN_MS) {
+                LOG_WARN("Timer %d fired %lu ms late", (int)(timer - s_timers), lateness_ms);
+            }
+            timer->callback(timer->arg);
+
+            xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+            record_lateness(lateness_ms);
+            if (timer->state == TIMER_STATE_FIRING && timer->period_ticks > 0) {
+                // 周期定时器按原计划推进，落后时跳过错过的周期，不连续补发
+                timer->expire_tick += timer->period_ticks;
+                uint64_t current_tick = timer_now_ms() / SIP_TIMER_WHEEL_TICK_MS;
+                if (timer->expire_tick <= current_tick) {
+                    timer->expire_tick += ((current_tick - timer->expire_tick) / timer->period_ticks + 1) * timer->period_ticks;
+                }
+                wheel_insert(timer);
+            } else {
+                timer->state = TIMER_STATE_FREE;
+            }
+            xSemaphoreGive(s_timer_mutex);
+        }
 
-    StackType_t *task_stack = (StackType_t *)heap_caps_malloc(stack_size, MALLOC_CAP_SPIRAM);
-    StaticTask_t *task_tcb = (StaticTask_t *)heap_caps_malloc(sizeof(StaticTask_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+        uint32_t next_ticks = wheel_next_ticks();
+        uint64_t target_ms = (s_wheel_tick + next_ticks) * SIP_TIMER_WHEEL_TICK_MS;
+        xSemaphoreGive(s_timer_mutex);
 
-    if (task_stack && task_tcb) {
-        return xTaskCreateStatic(
-            timer_task_entry,
-            name.c_str(),
-            stack_size,
-            ctx,
-            tskIDLE_PRIORITY + 5,
-            task_stack,
-            task_tcb
-        ) != NULL ? RET_OK : RET_ERROR;
-    } else {
-        if (task_stack) free(task_stack);
-        if (task_tcb) free(task_tcb);
-        LOG_WARN("@@@@@@@@@@@@@@@Failed to allocate stack in PSRAM for %s, falling back to internal", name.c_str());
-        return xTaskCreate(
-            timer_task_entry,
-            name.c_str(),
-            stack_size,
-            ctx,
-            tskIDLE_PRIORITY + 5,
-            NULL
-        ) == pdPASS ? RET_OK : RET_ERROR;
+        TickType_t wait = portMAX_DELAY;
+        if (next_ticks > 0) {
+            uint64_t now_ms = timer_now_ms();
+            wait = target_ms > now_ms ? pdMS_TO_TICKS((uint32_t)(target_ms - now_ms)) + 1 : 1;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+int adapter_start_timer(void (*callback)(void*), int delay_ms, int period_ms, void* arg){
+    if (!callback || delay_ms < 0 || period_ms < 0 || !s_timer_mutex) {
+        return -1;
     }
 
+    xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+    if (!s_timer_task) {
+        s_wheel_tick = timer_now_ms() / SIP_TIMER_WHEEL_TICK_MS;
+        StackType_t *task_stack = (StackType_t *)heap_caps_malloc(SIP_TIMER_TASK_STACK_SIZE, MALLOC_CAP_SPIRAM);
+        StaticTask_t *task_tcb = (StaticTask_t *)heap_caps_malloc(sizeof(StaticTask_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (task_stack && task_tcb) {
+            s_timer_task = xTaskCreateStatic(timer_wheel_task, "timer_wheel", SIP_TIMER_TASK_STACK_SIZE,
+                NULL, tskIDLE_PRIORITY + 5, task_stack, task_tcb);
+        } else {
+            if (task_stack) free(task_stack);
+            if (task_tcb) free(task_tcb);
+            LOG_WARN("Failed to allocate stack in PSRAM for timer_wheel, falling back to internal");
+            xTaskCreate(timer_wheel_task, "timer_wheel", SIP_TIMER_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 5, &s_timer_task);
+        }
+        if (!s_timer_task) {
+            xSemaphoreGive(s_timer_mutex);
+            return -1;
+        }
+    }
 
+    int index = 0;
+    while (index < SIP_TIMER_MAX && s_timers[index].state != TIMER_STATE_FREE) {
+        index++;
+    }
+    if (index >= SIP_TIMER_MAX) {
+        xSemaphoreGive(s_timer_mutex);
+        LOG_WARN("No free timer, %d timers in use", SIP_TIMER_MAX);
+        return -1;
+    }
+
+    wheel_timer_t *timer = &s_timers[index];
+    uint64_t expire_ms = timer_now_ms() + (uint32_t)delay_ms;
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->period_ticks = period_ms > 0 ? (period_ms + SIP_TIMER_WHEEL_TICK_MS - 1) / SIP_TIMER_WHEEL_TICK_MS : 0;
+    timer->expire_tick = (expire_ms + SIP_TIMER_WHEEL_TICK_MS - 1) / SIP_TIMER_WHEEL_TICK_MS;
+    timer->generation++;
+    wheel_insert(timer);
+    int timer_id = (timer->generation << 8) | index;
+    xSemaphoreGive(s_timer_mutex);
+
+    xTaskNotifyGive(s_timer_task);
+    return timer_id;
+}
+
+void adapter_stop_timer(int timer_id){
+    if (timer_id < 0 || !s_timer_mutex) {
+        return;
+    }
+    int index = timer_id & 0xFF;
+    if (index >= SIP_TIMER_MAX) {
+        return;
+    }
+    xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+    wheel_timer_t *timer = &s_timers[index];
+    if (timer->generation == (uint16_t)(timer_id >> 8)) {
+        if (timer->state == TIMER_STATE_PENDING) {
+            wheel_remove(timer);
+            timer->state = TIMER_STATE_FREE;
+        } else if (timer->state == TIMER_STATE_FIRING) {
+            timer->state = TIMER_STATE_STOPPED;
+        }
+    }
+    xSemaphoreGive(s_timer_mutex);
+}
+
+sip_ret_t adapter_start_periodic_task(void (*timer_task_cb)(void*), int period_ms, int stack_size, void* arg){
+    (void)stack_size;
+    return adapter_start_timer(timer_task_cb, 0, period_ms, arg) >= 0 ? RET_OK : RET_ERROR;
+}
+
+void get_sip_timer_statistics(sip_timer_stats_ptr stats){
+    if (!stats || !s_timer_mutex) {
+        return;
+    }
+    xSemaphoreTake(s_timer_mutex, portMAX_DELAY);
+    *stats = s_timer_stats;
+    xSemaphoreGive(s_timer_mutex);
 }
 
 
@@ -163,6 +331,18 @@ void adapter_task_delay(int delay_ms){
     vTaskDelayUntil(&lastWakeTime, period);
 }
 
+void* adapter_get_current_task(void){
+    return xTaskGetCurrentTaskHandle();
+}
+
+void* adapter_malloc_large(size_t size){
+    void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (!ptr) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
 void* adapter_create_json_object(){
     cJSON* root = cJSON_CreateObject();
     return root;
@@ -280,18 +460,20 @@ void adapter_unlock_sip_mutex(){
 }
 
 
-static SemaphoreHandle_t m_sip_list_mutex = NULL;
-void adapter_lock_sip_list_mutex(){
-    if (m_sip_list_mutex == NULL) {
-        m_sip_list_mutex = xSemaphoreCreateMutex();
-    }
-    xSemaphoreTake(m_sip_list_mutex, portMAX_DELAY);
+void* adapter_create_queue(int length, int item_size){
+    return xQueueCreate(length, item_size);
 }
 
-void adapter_unlock_sip_list_mutex(){
-    if (m_sip_list_mutex != NULL) {
-        xSemaphoreGive(m_sip_list_mutex);
-    }
+sip_ret_t adapter_queue_send(void* queue, const void* item, int timeout_ms){
+    if (!queue || !item) return RET_ERROR;
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xQueueSend((QueueHandle_t)queue, item, ticks) == pdTRUE ? RET_OK : RET_ERROR;
+}
+
+sip_ret_t adapter_queue_receive(void* queue, void* item, int timeout_ms){
+    if (!queue || !item) return RET_ERROR;
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xQueueReceive((QueueHandle_t)queue, item, ticks) == pdTRUE ? RET_OK : RET_ERROR;
 }
 
 
@@ -322,6 +504,11 @@ void adapter_clear_traffic_tunnel(){
     // To be implemented if needed
 }
 
+uint32_t adapter_get_traffic_sequence(){
+    auto& app = Application::GetInstance();
+    return ((SipMqttProtocol*) app.GetProtocol())->GetLocalSequence();
+}
+
 
 sip_ret_t adapter_transmit_mqtt_message(char* message){
     auto& app = Application::GetInstance();
@@ -329,11 +516,27 @@ sip_ret_t adapter_transmit_mqtt_message(char* message){
 	return RET_OK;
 }
 
+sip_ret_t adapter_transmit_mqtt_binary(const char* data, size_t len){
+    auto& app = Application::GetInstance();
+    ((SipMqttProtocol*) app.GetProtocol())->TransmitSIPMessage(std::string(data, len));
+    return RET_OK;
+}
+
 void on_call_established(char* session_id, media_parameter_ptr media_param){
     auto& app = Application::GetInstance();
     ((SipMqttProtocol*) app.GetProtocol())->OnCallEstablished(std::string(session_id), media_param);
 }
 
+void on_call_resumed(char* session_id, media_parameter_ptr media_param, uint32_t sequence){
+    auto& app = Application::GetInstance();
+    ((SipMqttProtocol*) app.GetProtocol())->OnCallResumed(std::string(session_id), media_param, sequence);
+}
+
+void on_call_confirmed(char* session_id){
+    auto& app = Application::GetInstance();
+    ((SipMqttProtocol*) app.GetProtocol())->OnCallConfirmed(std::string(session_id));
+}
+
 
 void on_call_ack_error(session_call_error_t error_code){
     auto& app = Application::GetInstance();
@@ -11,11 +11,15 @@ extern "C" {
 #endif
 
 /**
- * SIP消息缓存到列表中，并用任务进行异步处理
+ * SIP消息缓存到队列中，并用任务进行异步处理
  * 强烈建议打开此宏，以异步方式处理收到的 SIP 消息，避免阻塞 MQTT 回调任务。
  * 否则在处理 SIP 消息时可能会阻塞 MQTT 客户端，导致不可预见的异常
  */
 #define SIP_MESSAGE_CACHED_IN_LIST       
+/**
+ * 优先使用轻量级 SIP 解析器，只处理设备实际收到的消息子集，不支持的写法自动退回 osip 解析
+ */
+#define SIP_USE_LITE_PARSER
 #define DCP_VERSION                            "2.1"
 #define REGISTER_EXPIRE_SECOND                 300      //注册间隔5分钟   
 #define COMMAND_TIMEOUT_MS                     30000         //命令超时时间
@@ -23,6 +27,32 @@ extern "C" {
 #define SESSION_OPUS_CBR                       0       //opus是否使用cbr编码
 #define SESSION_AUDIO_FRAME_GAP                55      //音频帧间隔ms, 需要比frame_duration小
 #define SESSION_SUPPORT_FRAME_AGGREGATION      0       //是否支持帧聚合，开启后如果服务端发送的帧将把3个帧放在一个UDP中下发，减少处理开销和丢包率，但会增加一点点编码延迟
+#define SESSION_UPLINK_FRAME_AGGREGATION       1       //上行帧聚合，每个UDP包最多打包的帧数，1表示不聚合，需服务端在SDP中确认
+#define SIP_MESSAGE_QUEUE_LENGTH               16      //SIP消息队列长度
+#define SIP_MESSAGE_QUEUE_SEND_TIMEOUT_MS      100     //队列满时MQTT回调任务最长等待时间，超时后丢弃消息
+#define SIP_ARENA_SIZE                         (16 * 1024) //osip单次解析/构建消息使用的内存池大小，不够时退回堆分配
+#define SIP_SUPPORT_BINARY_ENVELOPE            1       //REGISTER时申请使用二进制信封承载SIP/MCP消息，服务端在200 OK中确认后生效，否则继续使用JSON信封
+#define SIP_TIMER_WHEEL_TICK_MS                10      //时间轮精度ms
+#define SIP_TIMER_WHEEL_SLOTS                  128     //时间轮槽数，一圈 1.28 秒，更长的定时器按圈数比较
+#define SIP_TIMER_MAX                          20      //同时存在的定时器数量上限，每个事务占 2 个，另有 2 个周期任务，见 sip_transaction.c 中的检查
+#define SIP_TIMER_TASK_STACK_SIZE              (1024 * 8) //所有定时回调共用的任务栈大小
+#define SIP_TIMER_LATENESS_WARN_MS             200     //回调执行延迟超过该值时打印警告
+#define SIP_TIMER_T1_MS                        500     //RFC 3261 T1，首次重传间隔
+#define SIP_TIMER_T2_MS                        4000    //RFC 3261 T2，非 INVITE 请求的最大重传间隔
+#define SIP_TRANSACTION_TIMEOUT_MS             (64 * SIP_TIMER_T1_MS) //Timer B/F，客户端事务超时
+#define SIP_TRANSACTION_FALLBACK_MS            (SIP_TRANSACTION_TIMEOUT_MS + 2000) //事务未能创建时的兜底超时，必须比 Timer B/F 长，正常情况下由事务超时结束等待
+#define SIP_TRANSACTION_MAX                    8       //同时存在的客户端事务数量上限
+#define SESSION_WARM_STANDBY                   1       //通话结束后请服务端停放媒体会话（SDP standby 秒数），有效期内唤醒直接在停放的媒体上开流，INVITE 异步确认
+
+/**
+ * 二进制信封格式（网络字节序）:
+ * |magic 1u|protocol 1u|payload_len 4u|payload payload_len|
+ * magic 不是合法的 JSON 起始字符，接收端据此区分两种信封
+ */
+#define SIP_ENVELOPE_MAGIC                     0xB5
+#define SIP_ENVELOPE_HEADER_SIZE               6
+#define SIP_ENVELOPE_PROTOCOL_SIP              1
+#define SIP_ENVELOPE_PROTOCOL_MCP              2
 
 
 
@@ -59,10 +89,27 @@ void adatper_log(sip_log_level_t level, const char* tag, const char* format, ...
 uint32_t adapter_get_system_ms(void);
 
 /**
- * @brief  Start a periodic task
+ * @brief  Start a periodic task, the first call happens on the next timer tick
+ * @note   All periodic tasks share the timer wheel task, stack_size is kept for compatibility
+ *         and ignored. Callbacks must not block for long, otherwise the other timers run late.
  */
 sip_ret_t adapter_start_periodic_task(void (*task_func)(void *), int period_ms, int stack_size, void* arg);
 
+/**
+ * @brief  Start a timer on the timer wheel
+ * @param  callback: Called on the timer wheel task
+ * @param  delay_ms: Delay of the first call
+ * @param  period_ms: Period of the following calls, 0 for a one-shot timer
+ * @return Timer id, negative on failure
+ */
+int adapter_start_timer(void (*callback)(void*), int delay_ms, int period_ms, void* arg);
+
+/**
+ * @brief  Stop a timer, stale or negative ids are ignored. One-shot timers release
+ *         their id after firing, so it is safe to stop them afterwards.
+ */
+void adapter_stop_timer(int timer_id);
+
 /**
  * @brief  Start a new thread
  */
@@ -73,6 +120,16 @@ sip_ret_t adapter_start_thread(void (*task_func)(void*), const char* name, int s
  */
 void adapter_task_delay(int delay_ms);
 
+/**
+ * @brief  Get an opaque handle of the calling task
+ */
+void* adapter_get_current_task(void);
+
+/**
+ * @brief  Allocate a large buffer, PSRAM is preferred when available
+ */
+void* adapter_malloc_large(size_t size);
+
 /**
  * @brief  Create a new JSON object
  */
@@ -159,14 +216,19 @@ void adapter_lock_sip_mutex();
 void adapter_unlock_sip_mutex();
 
 /**
- * @brief  Lock SIP message list mutex
+ * @brief  Create a message queue holding up to length items of item_size bytes
  */
-void adapter_lock_sip_list_mutex();
+void* adapter_create_queue(int length, int item_size);
 
 /**
- * @brief  Unlock SIP message list mutex
+ * @brief  Copy an item into a message queue, waits up to timeout_ms when the queue is full
  */
-void adapter_unlock_sip_list_mutex();
+sip_ret_t adapter_queue_send(void* queue, const void* item, int timeout_ms);
+
+/**
+ * @brief  Block until an item is received from a message queue, timeout_ms < 0 waits forever
+ */
+sip_ret_t adapter_queue_receive(void* queue, void* item, int timeout_ms);
 
 /**
  * @brief  Lock MCP tools list mutex
@@ -188,6 +250,11 @@ int adapter_start_traffic_tunnel(media_parameter_ptr media_param);
  */ 
 void adapter_clear_traffic_tunnel();
 
+/**
+ * @brief  Get the last sequence sent on the media traffic tunnel, parked together with the media keys
+ */
+uint32_t adapter_get_traffic_sequence();
+
 
 /**
  * @brief  Send message to server via MQTT
@@ -196,12 +263,31 @@ void adapter_clear_traffic_tunnel();
  */
 sip_ret_t adapter_transmit_mqtt_message(char* message);
 
+/**
+ * @brief  Transmit a binary MQTT message, the data may contain '\0'
+ * @param  data: Pointer to the message data
+ * @param  len: Length of the message data
+ */
+sip_ret_t adapter_transmit_mqtt_binary(const char* data, size_t len);
+
 
 /**
  * @brief  Callback when call is established
  */
 void on_call_established(char* session_id, media_parameter_ptr media_param);
 
+/**
+ * @brief  Callback when a call is started on the parked media of a previous call,
+ *         the audio may be sent right away while the INVITE is still pending
+ * @param  sequence: Last sequence sent with the parked keys, the resumed audio continues after it
+ */
+void on_call_resumed(char* session_id, media_parameter_ptr media_param, uint32_t sequence);
+
+/**
+ * @brief  Callback when the server accepts a resumed call with unchanged media parameters
+ */
+void on_call_confirmed(char* session_id);
+
 /**
  * @brief  Callback when call ACK encounters error
  */
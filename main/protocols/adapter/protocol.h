@@ -88,6 +88,8 @@ typedef enum {
     EVENT_SESSION_BARGE_IN = 2,
     EVENT_SYSTEM_NOTIFICATION = 3,
     EVENT_DEVICE_LIFECYCLE = 4,
+    EVENT_AUDIO_INPUT_VAD = 5,
+    EVENT_AUDIO_RECEIVE_STATS = 6,
 
     
     DATA_AUDIO_INPUT_TEXT = 101,
@@ -133,6 +135,29 @@ typedef struct {
     audio_input_stop_reason_t reason;
 } event_audio_input_state_stop_t, *event_audio_input_state_stop_ptr;
 
+/**
+ * Voice activity of the uplink audio. When the device stops sending silent frames,
+ * it tells the server so that the missing frames are not treated as packet loss.
+ */
+typedef struct {
+    bool speaking;
+} event_audio_input_vad_t, *event_audio_input_vad_ptr;
+
+/**
+ * Quality of the downlink audio received by the device in the current session,
+ * reported periodically so that the server can correlate it with the network type.
+ */
+typedef struct {
+    char network[16];            // board network type, e.g. wifi / ml307
+    uint32_t received;
+    uint32_t lost;
+    uint32_t duplicates;
+    uint32_t too_old;
+    uint32_t reordered;
+    uint32_t max_reorder_depth;
+    uint32_t jitter_ms;
+} event_audio_receive_stats_t, *event_audio_receive_stats_ptr;
+
 typedef struct{
     char text[1024];
 } data_audio_input_text_t, *data_audio_input_text_ptr;
@@ -285,6 +310,8 @@ typedef struct{
     unsigned char nonce[16];   // AES 初始向量/nonce
     unsigned char aes_key[16]; // AES 128位密钥
     int idle_timeout; // seconds of idle before terminates the session
+    int uplink_aggregation; // uplink frames per UDP datagram accepted by the server, 0 or 1 means no aggregation
+    int standby; // seconds the server keeps the media session parked after the call ends, 0 means no standby
 }media_parameter_t, *media_parameter_ptr;
 
 
@@ -306,6 +333,13 @@ sip_ret_t init_call(const char* wake_up_word);
  */
 sip_ret_t finish_call();
 
+/**
+ * @brief  Cancel the session being initiated, or end it if it is already established
+ * @return RET_OK: Cancel successful
+ *     Other: Cancel failed
+ */
+sip_ret_t cancel_call();
+
 
 /**
  * @brief  Send start listening command to server
@@ -321,6 +355,22 @@ sip_ret_t send_start_listening(listening_mode_t mode);
  */
 sip_ret_t send_stop_listening(audio_input_stop_reason_t reason);
 
+/**
+ * @brief  Send uplink voice activity change to server
+ * @param  speaking: true when the device resumes sending audio, false when it stops on silence
+ * @return RET_OK: Sent successfully
+ *     Other: Send failed
+ */
+sip_ret_t send_voice_activity(bool speaking);
+
+/**
+ * @brief  Send downlink audio receive statistics to server
+ * @param  param: statistics of the current session
+ * @return RET_OK: Sent successfully
+ *     Other: Send failed
+ */
+sip_ret_t send_audio_statistics(event_audio_receive_stats_ptr param);
+
 /**
  * @brief  Send abort current speech synthesis command to server
  * @param  reason: Abort reason
@@ -345,6 +395,56 @@ void init_session_module(const char* uid, const char* device_ip);
  */
 void handle_received_mqtt_message(const char *data, size_t len);     
 
+/**
+ * Dispatch latency of received SIP messages, measured from the MQTT callback
+ * to the moment the session task starts handling the message.
+ */
+typedef struct {
+    uint32_t dispatched;
+    uint32_t dropped;          // queue full
+    uint32_t last_latency_ms;
+    uint32_t max_latency_ms;
+    uint32_t total_latency_ms;
+} sip_dispatch_stats_t, *sip_dispatch_stats_ptr;
+
+/**
+ * @brief  Get dispatch latency statistics of received SIP messages
+ * @param  stats: Output statistics
+ */
+void get_sip_dispatch_statistics(sip_dispatch_stats_ptr stats);
+
+/**
+ * Usage of the per-message osip arena
+ */
+typedef struct {
+    uint32_t scopes;             // parse/build calls served by the arena
+    uint32_t high_water_mark;    // largest arena usage of a single call, in bytes
+    uint32_t fallback_allocs;    // allocations that did not fit and went to the heap
+} sip_arena_stats_t, *sip_arena_stats_ptr;
+
+/**
+ * @brief  Get usage statistics of the osip arena
+ * @param  stats: Output statistics
+ */
+void get_sip_arena_statistics(sip_arena_stats_ptr stats);
+
+/**
+ * Lateness of the adapter timer wheel callbacks, measured from the scheduled time
+ * to the moment the callback starts
+ */
+typedef struct {
+    uint32_t fired;
+    uint32_t last_lateness_ms;
+    uint32_t max_lateness_ms;
+    uint32_t total_lateness_ms;
+} sip_timer_stats_t, *sip_timer_stats_ptr;
+
+/**
+ * @brief  Get lateness statistics of the adapter timers
+ * @param  stats: Output statistics
+ */
+void get_sip_timer_statistics(sip_timer_stats_ptr stats);
+
 /**
  * @brief  Transmit MCP message over SIP
  * @param  message: Pointer to the MCP message string
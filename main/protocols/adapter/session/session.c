@@ -1,8 +1,11 @@
 #include "../protocol.h"
 #include "session.h"
+#include "sip_transaction.h"
 #include "osip_adapter.h"
 #include "osipparser2/osip_list.h"
 #include "string.h"
+#include "strings.h"
+#include <stdatomic.h>
 
 
 #define ADAPTER_LOG_TAG        "[SESSION]"
@@ -31,7 +34,9 @@ static session_state_machine_t m_session_state = {
     .last_keepalive_ms = 0,
     .last_traffic_ms = 0,
     .invite_200_ok_resp_message = NULL,
-    .device_ip = {0}
+    .device_ip = {0},
+    .binary_envelope = 0,
+    .resumed = 0
 };
 
 media_parameter_t g_audio_enc_media_param = {
@@ -50,7 +55,34 @@ media_parameter_t g_audio_enc_media_param = {
 
 media_parameter_t g_audio_dec_media_param = {0};
 
-static osip_list_t m_received_sip_list;
+/**
+ * 上一次通话结束后由服务端停放的媒体会话，有效期内唤醒可以直接开流
+ */
+typedef struct {
+    int valid;
+    char call_id[64];
+    media_parameter_t media;
+    uint32_t expire_ms;
+    uint32_t sequence;  // 停放时已发送的最后一个音频序号，恢复后从这里继续计数
+} parked_media_t;
+
+static parked_media_t m_parked_media = {0};
+
+typedef struct {
+    char* data;
+    size_t len;
+    uint32_t enqueue_ms;
+} queued_sip_message_t;
+
+static void* m_received_sip_queue = NULL;
+// 分发统计在 MQTT 回调和会话任务中更新，使用原子变量，避免为计数去等 sip 互斥锁
+static struct {
+    _Atomic uint32_t dispatched;
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t last_latency_ms;
+    _Atomic uint32_t max_latency_ms;
+    _Atomic uint32_t total_latency_ms;
+} m_dispatch_stats;
 
 int check_if_session_in_call(){
     return m_session_state.session_status == SESSION_STATUS_IN_CALL;
@@ -92,42 +124,58 @@ void report_register_status(register_param_ptr  param){
     m_register_param.network.type = param->network.type;
 }
 
-static sip_ret_t transmit_sip(char *message){
+/**
+ * 按协商结果选择信封：服务端确认二进制信封后直接发送 |magic|protocol|len|payload|，
+ * 省去 JSON 序列化和对 CRLF、引号的转义；否则使用 {"protocol":"SIP","payload":"..."}
+ */
+static sip_ret_t transmit_envelope(uint8_t protocol, const char *message){
     if (!message){
         return RET_ERROR;
     }
     sip_ret_t ret = RET_ERROR;
-    void *root = adapter_create_json_object();
-    adapter_put_json_string_value(root, "protocol", "SIP");
-    adapter_put_json_string_value(root, "payload", message);
 
-    char* json_string = adapter_serialize_json_to_string(root);
-    if (json_string) {
-        ret = adapter_transmit_mqtt_message(json_string);
+#if SIP_SUPPORT_BINARY_ENVELOPE
+    if (m_session_state.binary_envelope){
+        size_t len = strlen(message);
+        char *frame = malloc(SIP_ENVELOPE_HEADER_SIZE + len);
+        if (!frame){
+            return RET_ERROR;
+        }
+        frame[0] = (char)SIP_ENVELOPE_MAGIC;
+        frame[1] = (char)protocol;
+        frame[2] = (char)((len >> 24) & 0xFF);
+        frame[3] = (char)((len >> 16) & 0xFF);
+        frame[4] = (char)((len >> 8) & 0xFF);
+        frame[5] = (char)(len & 0xFF);
+        memcpy(frame + SIP_ENVELOPE_HEADER_SIZE, message, len);
+        ret = adapter_transmit_mqtt_binary(frame, SIP_ENVELOPE_HEADER_SIZE + len);
+        free(frame);
+        return ret;
     }
+#endif
 
-    adapter_delete_json_object(root);
-    return ret;
-}
-
-sip_ret_t transmit_mcp_over_sip(const char *message){
-    if (!message){
-        return RET_ERROR;
-    }
-    sip_ret_t ret = RET_ERROR;
     void *root = adapter_create_json_object();
-    adapter_put_json_string_value(root, "protocol", "MCP");
+    adapter_put_json_string_value(root, "protocol", protocol == SIP_ENVELOPE_PROTOCOL_SIP ? "SIP" : "MCP");
     adapter_put_json_string_value(root, "payload", message);
 
     char* json_string = adapter_serialize_json_to_string(root);
     if (json_string) {
         ret = adapter_transmit_mqtt_message(json_string);
+        free(json_string);
     }
 
     adapter_delete_json_object(root);
     return ret;
 }
 
+static sip_ret_t transmit_sip(char *message){
+    return transmit_envelope(SIP_ENVELOPE_PROTOCOL_SIP, message);
+}
+
+sip_ret_t transmit_mcp_over_sip(const char *message){
+    return transmit_envelope(SIP_ENVELOPE_PROTOCOL_MCP, message);
+}
+
 
 static void proc_response_register(MOVE received_sip_message_ptr  message){
     LOG_INFO("Processing REGISTER response");
@@ -140,7 +188,11 @@ static void proc_response_register(MOVE received_sip_message_ptr  message){
             m_session_state.last_keepalive_ms = adapter_get_system_ms();
             m_session_state.last_register_ms = m_session_state.last_keepalive_ms;
             power_on_register = 1; // 只在第一次注册时携带开机注册标志，之后的注册都不携带
-            LOG_INFO("REGISTER successful");
+#if SIP_SUPPORT_BINARY_ENVELOPE
+            // 每次注册都重新协商，服务端回退到旧版本时自动恢复 JSON 信封
+            m_session_state.binary_envelope = (strcasecmp(message->x_envelope, "binary") == 0);
+#endif
+            LOG_INFO("REGISTER successful, envelope: %s", m_session_state.binary_envelope ? "binary" : "json");
         }
         m_session_state.session_status = SESSION_STATUS_IDLE;
         m_session_state.last_keepalive_ms = m_session_state.last_req_message_ms;
@@ -169,18 +221,106 @@ static int clear_session(){
     return 0;
 }
 
+/**
+ * 通话正常结束时停放媒体参数，服务端在 SDP 中没有给出 standby 时不停放
+ */
+static void park_media(){
+#if SESSION_WARM_STANDBY
+    if (g_audio_dec_media_param.standby <= 0){
+        m_parked_media.valid = 0;
+        return;
+    }
+    strncpy(m_parked_media.call_id, m_session_state.session_id, sizeof(m_parked_media.call_id) - 1);
+    m_parked_media.media = g_audio_dec_media_param;
+    m_parked_media.expire_ms = adapter_get_system_ms() + (uint32_t)g_audio_dec_media_param.standby * 1000;
+    m_parked_media.sequence = adapter_get_traffic_sequence();
+    m_parked_media.valid = 1;
+    LOG_INFO("Media of %s parked for %d seconds at sequence %lu", m_parked_media.call_id,
+        g_audio_dec_media_param.standby, m_parked_media.sequence);
+#endif
+}
 
+/**
+ * 在停放的媒体上开流后 INVITE 失败，音频通道必须关闭
+ */
+static void abort_resumed_call(){
+    if (!m_session_state.resumed){
+        return;
+    }
+    LOG_WARN("Resumed call rejected, closing audio channel");
+    m_session_state.resumed = 0;
+    adapter_clear_traffic_tunnel();
+    on_call_terminated_by_server();
+}
+
+
+
+/**
+ * INVITE 的非 2xx 最终响应需要在 INVITE 事务内回 ACK
+ */
+static void send_non_2xx_ack(received_sip_message_ptr response){
+    char *out_msg = NULL;
+    size_t out_len = 0;
+    if (build_non_2xx_ack(response, m_session_state.uid, m_session_state.device_ip, &out_msg, &out_len) == RET_OK && out_msg){
+        transmit_sip(out_msg);
+    }
+    if (out_msg) free_sip_message(out_msg);
+}
+
+/**
+ * 已发送 CANCEL 的 INVITE 的最终响应：487 等失败响应回 ACK；
+ * 与 CANCEL 交错到达的 2xx 已经在服务端建立了对话，回 ACK 后立即 BYE
+ */
+static void proc_response_cancelled_invite(MOVE received_sip_message_ptr message){
+    m_session_state.cancelled_invite_seq = 0;
+    if (message->status_code >= 300){
+        LOG_INFO("Cancelled INVITE completed with %d", message->status_code);
+        send_non_2xx_ack(message);
+        free(message);
+        return;
+    }
+
+    LOG_INFO("Cancelled INVITE answered by server, ending call %s", message->call_id);
+    char *out_msg = NULL;
+    size_t out_len = 0;
+    if (build_ack(message, m_session_state.uid, m_session_state.device_ip, &out_msg, &out_len) == RET_OK && out_msg){
+        transmit_sip(out_msg);
+    }
+    if (out_msg){
+        free_sip_message(out_msg);
+        out_msg = NULL;
+    }
+    if (build_bye(message, m_session_state.uid, m_session_state.device_ip, m_session_state.seq, &out_msg, &out_len) == RET_OK){
+        sip_transaction_send("BYE", (int)m_session_state.seq, out_msg);
+        m_session_state.seq++;
+        free_sip_message(out_msg);
+    }
+    free(message);
+}
 
 static sip_ret_t proc_response_invite(MOVE received_sip_message_ptr message){
     LOG_INFO("Processing INVITE response");
     adapter_lock_sip_mutex();
+    if (m_session_state.cancelled_invite_seq != 0 && message->cseq_num == m_session_state.cancelled_invite_seq){
+        proc_response_cancelled_invite(message);
+        adapter_unlock_sip_mutex();
+        return RET_ERROR;
+    }
+    if (m_session_state.session_status != SESSION_STATUS_INVITING){
+        // 200 OK 的重传说明服务端没有收到 ACK，通话中重发 ACK，其余迟到的响应直接丢弃
+        if (m_session_state.session_status == SESSION_STATUS_IN_CALL && is_response_ok(message) &&
+            strncmp(message->call_id, m_session_state.session_id, sizeof(m_session_state.session_id)) == 0){
+            LOG_INFO("INVITE 200 OK retransmitted, resending ACK");
+            send_invite_ack();
+        }
+        adapter_unlock_sip_mutex();
+        free(message);
+        return RET_ERROR;
+    }
+
     int ret = RET_OK;
     do
     {
-        if (m_session_state.session_status != SESSION_STATUS_INVITING){
-            ret = RET_ERROR;
-            break;
-        }
 
         if (is_response_ok(message) && message->cseq_num == m_session_state.last_req_message_seq) {
 
@@ -195,6 +335,7 @@ static sip_ret_t proc_response_invite(MOVE received_sip_message_ptr message){
             strncpy(m_session_state.session_id, message->call_id, sizeof(m_session_state.session_id)-1);
 
             downlink_sdp_parameter_t sdp = {0};
+            media_parameter_t parked = g_audio_dec_media_param;
             if (message->body_length > 0) {
                 // 解析 SDP
                 if (parse_sdp(message->message_body, &sdp) == RET_OK) {
@@ -209,6 +350,23 @@ static sip_ret_t proc_response_invite(MOVE received_sip_message_ptr message){
                     strncpy(g_audio_dec_media_param.encryption, sdp.encryption, sizeof(g_audio_dec_media_param.encryption)-1);
                     memcpy(g_audio_dec_media_param.nonce, sdp.nonce, sizeof(g_audio_dec_media_param.nonce));
                     memcpy(g_audio_dec_media_param.aes_key, sdp.aes_key, sizeof(g_audio_dec_media_param.aes_key));
+                    g_audio_dec_media_param.uplink_aggregation = sdp.uplink_aggregation < SESSION_UPLINK_FRAME_AGGREGATION ?
+                        sdp.uplink_aggregation : SESSION_UPLINK_FRAME_AGGREGATION;
+                    g_audio_dec_media_param.standby = sdp.standby;
+
+                    // 恢复的通话已经在停放的媒体上开流，服务端沿用原媒体时只需确认，否则按新参数重建
+                    if (m_session_state.resumed){
+                        m_session_state.resumed = 0;
+                        if (strcmp(parked.ip, g_audio_dec_media_param.ip) == 0 &&
+                            parked.port == g_audio_dec_media_param.port &&
+                            memcmp(parked.aes_key, g_audio_dec_media_param.aes_key, sizeof(parked.aes_key)) == 0 &&
+                            memcmp(parked.nonce, g_audio_dec_media_param.nonce, sizeof(parked.nonce)) == 0){
+                            on_call_confirmed(m_session_state.session_id);
+                            send_invite_ack();
+                            break;
+                        }
+                        LOG_INFO("Server replaced the parked media, restarting traffic");
+                    }
 
                     if (adapter_start_traffic_tunnel(&g_audio_dec_media_param) == 0){
                         on_call_established(m_session_state.session_id, &g_audio_dec_media_param);
@@ -219,6 +377,9 @@ static sip_ret_t proc_response_invite(MOVE received_sip_message_ptr message){
                 }
             }
         }else{
+            if (message->status_code >= 300){
+                send_non_2xx_ack(message);
+            }
             if(message->status_code == 403){
                 if (message->x_reason_code == CALL_ERROR_MEMBERSHIP_INVALID){
                     on_call_ack_error(CALL_ERROR_MEMBERSHIP_INVALID);
@@ -234,6 +395,7 @@ static sip_ret_t proc_response_invite(MOVE received_sip_message_ptr message){
         m_session_state.last_req_message_ms = 0;
         m_session_state.last_req_message_seq = 0;
         m_session_state.invite_200_ok_resp_message = NULL;
+        abort_resumed_call();
         free(message);
     }
     adapter_unlock_sip_mutex();
@@ -244,6 +406,7 @@ static sip_ret_t proc_response_invite(MOVE received_sip_message_ptr message){
 static void proc_response_info(MOVE received_sip_message_ptr message){
 
     if (message->cseq_num != m_session_state.last_req_message_seq){
+        free(message);
         return;
     }
     if (is_response_ok(message)) {
@@ -256,6 +419,17 @@ static void proc_response_info(MOVE received_sip_message_ptr message){
 }
 
 static void proc_response_bye(MOVE received_sip_message_ptr message){
+    // BYE 可能经过多次重传才得到响应，此时如果已经发起了新的会话，不能把它清掉
+    adapter_lock_sip_mutex();
+    if (m_session_state.session_status == SESSION_STATUS_INVITING ||
+        (m_session_state.session_status == SESSION_STATUS_IN_CALL &&
+         strncmp(message->call_id, m_session_state.session_id, sizeof(m_session_state.session_id)) != 0)){
+        LOG_INFO("BYE response for a previous call, ignore: %s", message->call_id);
+        adapter_unlock_sip_mutex();
+        free(message);
+        return;
+    }
+    adapter_unlock_sip_mutex();
     clear_session();
     adapter_clear_traffic_tunnel();
     on_call_terminated_ack();
@@ -305,7 +479,8 @@ static void proc_request_invite(MOVE received_sip_message_ptr  message){
             .frame_gap = SESSION_AUDIO_FRAME_GAP,
             .wake_up_word = NULL,
             .support_frame_aggregation = SESSION_SUPPORT_FRAME_AGGREGATION,
-            .support_redundant = 0
+            .support_redundant = 0,
+            .uplink_aggregation = SESSION_UPLINK_FRAME_AGGREGATION
         };
         strncpy(sdp_param.session_id, sdp.session_id, sizeof(sdp_param.session_id) - 1);
         if (build_invite_200_ok_response(message,
@@ -337,6 +512,11 @@ static void proc_request_invite(MOVE received_sip_message_ptr  message){
         strncpy(g_audio_dec_media_param.encryption, sdp.encryption, sizeof(g_audio_dec_media_param.encryption) - 1);
         memcpy(g_audio_dec_media_param.nonce, sdp.nonce, sizeof(g_audio_dec_media_param.nonce));
         memcpy(g_audio_dec_media_param.aes_key, sdp.aes_key, sizeof(g_audio_dec_media_param.aes_key));
+        g_audio_dec_media_param.uplink_aggregation = sdp.uplink_aggregation < SESSION_UPLINK_FRAME_AGGREGATION ?
+            sdp.uplink_aggregation : SESSION_UPLINK_FRAME_AGGREGATION;
+        // 服务端发起的通话没有请求停放，新密钥生效后旧的停放媒体也不能再恢复
+        g_audio_dec_media_param.standby = 0;
+        m_parked_media.valid = 0;
 
         m_session_state.session_status = SESSION_STATUS_IN_CALL;
         m_session_state.last_keepalive_ms = adapter_get_system_ms();
@@ -617,7 +797,8 @@ void send_register(register_param_ptr param){
             .device_ip = m_session_state.device_ip,
             .expires_sec = REGISTER_EXPIRE_SECOND,
             .cseq_num = (int)(m_session_state.seq),
-            .register_param = *param
+            .register_param = *param,
+            .support_binary_envelope = SIP_SUPPORT_BINARY_ENVELOPE
         };
         char* message = NULL;
         size_t message_len = 0;
@@ -627,7 +808,7 @@ void send_register(register_param_ptr param){
         }
 
         
-        ret = transmit_sip(message);
+        ret = sip_transaction_send("REGISTER", (int)m_session_state.seq, message);
         if (ret == RET_OK){
             LOG_INFO("REGISTER request sent successfully, scenario: %d", param->scenario);
             m_session_state.session_status = SESSION_STATUS_REGISTERING;
@@ -654,6 +835,12 @@ sip_ret_t init_call(const char* wake_up_word){
         }
 
         uint32_t ms = adapter_get_system_ms();
+        const char *resume_call_id = NULL;
+#if SESSION_WARM_STANDBY
+        if (m_parked_media.valid && (int32_t)(m_parked_media.expire_ms - ms) > 0){
+            resume_call_id = m_parked_media.call_id;
+        }
+#endif
         uplink_sdp_parameter_t sdp_param = {
             .uid = m_session_state.uid,
             .device_ip = m_session_state.device_ip,
@@ -665,7 +852,10 @@ sip_ret_t init_call(const char* wake_up_word){
             .cbr = SESSION_OPUS_CBR,
             .frame_gap = SESSION_AUDIO_FRAME_GAP,
             .wake_up_word = wake_up_word,
-            .support_frame_aggregation = SESSION_SUPPORT_FRAME_AGGREGATION
+            .support_frame_aggregation = SESSION_SUPPORT_FRAME_AGGREGATION,
+            .uplink_aggregation = SESSION_UPLINK_FRAME_AGGREGATION,
+            .standby = SESSION_WARM_STANDBY,
+            .resume_call_id = resume_call_id
         };
 
         sip_invite_param_t invite = {
@@ -684,10 +874,23 @@ sip_ret_t init_call(const char* wake_up_word){
         m_session_state.session_status = SESSION_STATUS_INVITING;
         m_session_state.last_req_message_ms = ms;
         m_session_state.last_req_message_seq = m_session_state.seq;
+        sip_transaction_send("INVITE", (int)m_session_state.seq, message);
         m_session_state.seq++;
-        transmit_sip(message);
         free_sip_message(message);
 
+        // 停放的媒体只能恢复一次，不等 INVITE 响应直接开流
+        m_parked_media.valid = 0;
+        if (resume_call_id){
+            LOG_INFO("Resuming parked media of %s", resume_call_id);
+            m_session_state.resumed = 1;
+            g_audio_dec_media_param = m_parked_media.media;
+            if (adapter_start_traffic_tunnel(&g_audio_dec_media_param) == 0){
+                on_call_resumed(m_parked_media.call_id, &g_audio_dec_media_param, m_parked_media.sequence);
+            }else{
+                m_session_state.resumed = 0;
+            }
+        }
+
     }while(0);
 
     adapter_unlock_sip_mutex();
@@ -701,6 +904,12 @@ sip_ret_t finish_call(){
     sip_ret_t ret = RET_OK;
     do{
 
+        // 恢复的通话在确认前结束，按取消处理，迟到的 200 OK 会因状态不匹配被丢弃
+        if (m_session_state.session_status == SESSION_STATUS_INVITING && m_session_state.resumed){
+            ret = cancel_call();
+            break;
+        }
+
         if (m_session_state.session_status != SESSION_STATUS_IN_CALL){
             ret = RET_ERROR;
             break;
@@ -717,10 +926,11 @@ sip_ret_t finish_call(){
                 &message_len
             );
         if (ret == RET_OK){
+            sip_transaction_send("BYE", (int)m_session_state.seq, message);
             m_session_state.seq++;
-            transmit_sip(message);
             free_sip_message(message);
         }
+        park_media();
         clear_session();
         adapter_clear_traffic_tunnel();
 
@@ -730,6 +940,50 @@ sip_ret_t finish_call(){
     return ret;
 }
 
+/**
+ * 由事务层保存的 INVITE 副本构造 CANCEL，需在 INVITE 事务终止前调用
+ */
+static void send_cancel(int invite_seq){
+    const char *invite = sip_transaction_get_message("INVITE", invite_seq);
+    if (!invite){
+        return;
+    }
+    received_sip_message_ptr invite_info = NULL;
+    if (sip_parse_incoming_message(invite, strlen(invite), &invite_info) != RET_OK){
+        LOG_INFO("Failed to parse pending INVITE, CANCEL not sent");
+        return;
+    }
+    char* message = NULL;
+    size_t message_len = 0;
+    if (build_cancel(invite_info, &message, &message_len) == RET_OK){
+        sip_transaction_send("CANCEL", invite_seq, message);
+        free_sip_message(message);
+    }
+    free(invite_info);
+}
+
+sip_ret_t cancel_call(){
+    LOG_INFO("Cancelling call");
+    adapter_lock_sip_mutex();
+    sip_ret_t ret = RET_OK;
+    if (m_session_state.session_status == SESSION_STATUS_INVITING){
+        // 通知服务端取消未完成的 INVITE，INVITE 事务保留到最终响应，由 proc_response_invite 回 ACK
+        send_cancel(m_session_state.last_req_message_seq);
+        m_session_state.cancelled_invite_seq = m_session_state.last_req_message_seq;
+        m_session_state.session_status = SESSION_STATUS_IDLE;
+        m_session_state.last_req_message_ms = 0;
+        m_session_state.last_req_message_seq = 0;
+        if (m_session_state.resumed){
+            m_session_state.resumed = 0;
+            adapter_clear_traffic_tunnel();
+        }
+    }else if (m_session_state.session_status == SESSION_STATUS_IN_CALL){
+        ret = finish_call();
+    }
+    adapter_unlock_sip_mutex();
+    return ret;
+}
+
 static void send_invite_ack(){
     if (!m_session_state.invite_200_ok_resp_message){
         return;
@@ -793,8 +1047,8 @@ sip_ret_t send_abort_speaking(event_session_barge_in_ptr barge_in){
         uint32_t ms = adapter_get_system_ms();
         m_session_state.last_req_message_ms = ms;
         m_session_state.last_req_message_seq = m_session_state.seq;
+        sip_transaction_send("INFO", (int)m_session_state.seq, message);
         m_session_state.seq++;
-        transmit_sip(message);
         free_sip_message(message);
 
     }while(0);
@@ -840,8 +1094,8 @@ sip_ret_t send_start_listening(listening_mode_t mode){
         uint32_t ms = adapter_get_system_ms();
         m_session_state.last_req_message_ms = ms;
         m_session_state.last_req_message_seq = m_session_state.seq;
+        sip_transaction_send("INFO", (int)m_session_state.seq, message);
         m_session_state.seq++;
-        transmit_sip(message);
         free_sip_message(message);
 
     }while(0);
@@ -884,8 +1138,92 @@ sip_ret_t send_stop_listening(audio_input_stop_reason_t reason){
         uint32_t ms = adapter_get_system_ms();
         m_session_state.last_req_message_ms = ms;
         m_session_state.last_req_message_seq = m_session_state.seq;
+        sip_transaction_send("INFO", (int)m_session_state.seq, message);
+        m_session_state.seq++;
+        free_sip_message(message);
+
+    }while(0);
+
+    adapter_unlock_sip_mutex();
+    return ret;
+}
+
+sip_ret_t send_voice_activity(bool speaking){
+
+    event_audio_input_vad_t param = {speaking};
+    LOG_INFO("Sending voice activity: %s", speaking ? "speech" : "silence");
+    adapter_lock_sip_mutex();
+    sip_ret_t ret = RET_OK;
+    do{
+
+        if (m_session_state.session_status != SESSION_STATUS_IN_CALL){
+            ret = RET_ERROR;
+            break;
+        }
+
+        if (!m_session_state.invite_200_ok_resp_message){
+            ret = RET_ERROR;
+            break;
+        }
+
+        char* message = NULL;
+        size_t message_len = 0;
+        ret = build_audio_input_vad(
+            m_session_state.invite_200_ok_resp_message,
+            m_session_state.uid,
+            m_session_state.device_ip,
+            m_session_state.seq,
+            &param,
+            &message,
+            &message_len);
+        if (ret != RET_OK){
+            break;
+        }
+
+        // 不需要等待应答，不占用 last_req_message_* 以免干扰正在等待应答的请求
+        sip_transaction_send("INFO", (int)m_session_state.seq, message);
+        m_session_state.seq++;
+        free_sip_message(message);
+
+    }while(0);
+
+    adapter_unlock_sip_mutex();
+    return ret;
+}
+
+sip_ret_t send_audio_statistics(event_audio_receive_stats_ptr param){
+
+    adapter_lock_sip_mutex();
+    sip_ret_t ret = RET_OK;
+    do{
+
+        if (m_session_state.session_status != SESSION_STATUS_IN_CALL){
+            ret = RET_ERROR;
+            break;
+        }
+
+        if (!m_session_state.invite_200_ok_resp_message){
+            ret = RET_ERROR;
+            break;
+        }
+
+        char* message = NULL;
+        size_t message_len = 0;
+        ret = build_audio_receive_stats(
+            m_session_state.invite_200_ok_resp_message,
+            m_session_state.uid,
+            m_session_state.device_ip,
+            m_session_state.seq,
+            param,
+            &message,
+            &message_len);
+        if (ret != RET_OK){
+            break;
+        }
+
+        // 不需要等待应答，不占用 last_req_message_* 以免干扰正在等待应答的请求
+        sip_transaction_send("INFO", (int)m_session_state.seq, message);
         m_session_state.seq++;
-        transmit_sip(message);
         free_sip_message(message);
 
     }while(0);
@@ -921,7 +1259,11 @@ void handle_received_sip(const char *data, size_t len)
                 free(msg_info);
             }
         } else{
-            // 处理响应消息
+            // 处理响应消息，重复响应和临时响应由事务层吸收
+            if (!sip_transaction_on_response(msg_info)) {
+                free(msg_info);
+                return;
+            }
             if (strcmp(msg_info->method, "REGISTER") == 0) {
                 proc_response_register(msg_info);
             } else if (strcmp(msg_info->method, "INVITE") == 0) {
@@ -941,6 +1283,52 @@ void handle_received_sip(const char *data, size_t len)
 }
 
 
+/**
+ * 分发一条 MQTT 消息，二进制信封以 SIP_ENVELOPE_MAGIC 开头，其余按 JSON 信封处理
+ */
+static void dispatch_mqtt_message(const char *data, size_t len){
+    if ((uint8_t)data[0] == SIP_ENVELOPE_MAGIC){
+        if (len < SIP_ENVELOPE_HEADER_SIZE){
+            LOG_INFO("Binary envelope too short: %d", (int)len);
+            return;
+        }
+        const uint8_t *header = (const uint8_t *)data;
+        size_t payload_len = ((size_t)header[2] << 24) | ((size_t)header[3] << 16) |
+                             ((size_t)header[4] << 8) | (size_t)header[5];
+        if (payload_len != len - SIP_ENVELOPE_HEADER_SIZE){
+            LOG_INFO("Binary envelope length mismatch: %d != %d", (int)payload_len, (int)(len - SIP_ENVELOPE_HEADER_SIZE));
+            return;
+        }
+        // data 末尾有 '\0'，payload 可直接作为字符串使用
+        const char *payload = data + SIP_ENVELOPE_HEADER_SIZE;
+        if (header[1] == SIP_ENVELOPE_PROTOCOL_SIP){
+            handle_received_sip(payload, payload_len);
+        }else
+        if (header[1] == SIP_ENVELOPE_PROTOCOL_MCP){
+            on_server_mcp_call(payload);
+        }else{
+            LOG_INFO("Unknown envelope protocol: %d", header[1]);
+        }
+        return;
+    }
+
+    void *root = adapter_parse_json_string((char *)data);
+    if(root != NULL){
+        char* protocol = adapter_get_json_string_value(root, "protocol");
+        char* payload = adapter_get_json_string_value(root, "payload");
+        if (protocol && payload){
+            if (strcmp("SIP", protocol) == 0){
+                handle_received_sip(payload, strlen(payload));
+            }else
+            if (strcmp("MCP", protocol) == 0){
+                on_server_mcp_call(payload);
+            }
+        }
+        adapter_delete_json_object(root);
+        root = NULL;
+    }
+}
+
 void handle_received_mqtt_message(const char *data, size_t len){
     if (!data || len == 0){
         return;
@@ -952,33 +1340,33 @@ void handle_received_mqtt_message(const char *data, size_t len){
         return;
     }
 
-    strncpy(((char*)buf), data, len);
+    memcpy(buf, data, len);
     buf[len] = 0;
 
-    adapter_lock_sip_list_mutex();
-
-    if (osip_list_add(&m_received_sip_list, buf, -1) < 0){
+    queued_sip_message_t item = {
+        .data = buf,
+        .len = len,
+        .enqueue_ms = adapter_get_system_ms()
+    };
+    if (adapter_queue_send(m_received_sip_queue, &item, SIP_MESSAGE_QUEUE_SEND_TIMEOUT_MS) != RET_OK){
+        LOG_INFO("SIP message queue full, message dropped");
         free(buf);
-        adapter_unlock_sip_list_mutex();
+        atomic_fetch_add_explicit(&m_dispatch_stats.dropped, 1, memory_order_relaxed);
         return;
     }
-
-    adapter_unlock_sip_list_mutex();
 #else
-    void *root = adapter_parse_json_string((char *)data);
-    if(root != NULL){
-        char protocol[10] = {0};
-        strcpy(protocol, adapter_get_json_string_value(root, "protocol"));
-        char* payload = adapter_get_json_string_value(root, "payload");
-        if (strcmp("SIP", protocol) == 0){
-            handle_received_sip(payload, strlen(payload));
-        }else
-        if (strcmp("MCP", protocol) == 0){
-            on_server_mcp_call(payload);
+    if ((uint8_t)data[0] == SIP_ENVELOPE_MAGIC){
+        // 二进制信封需要 '\0' 结尾的副本
+        char* buf = malloc(len + 1);
+        if (!buf){
+            return;
         }
-        adapter_delete_json_object(root);
-        root = NULL;
-
+        memcpy(buf, data, len);
+        buf[len] = 0;
+        dispatch_mqtt_message(buf, len);
+        free(buf);
+    }else{
+        dispatch_mqtt_message(data, len);
     }
 #endif
     return;
@@ -987,6 +1375,31 @@ void handle_received_mqtt_message(const char *data, size_t len){
 
 
 
+/**
+ * 客户端事务超时（Timer B/F），重传全部失败，按服务端无响应处理
+ */
+static void on_transaction_timeout(const char *method, int cseq_num){
+    adapter_lock_sip_mutex();
+    if (strcmp(method, "INVITE") == 0 && cseq_num == m_session_state.cancelled_invite_seq){
+        m_session_state.cancelled_invite_seq = 0;
+    }
+    if (cseq_num == m_session_state.last_req_message_seq){
+        if (strcmp(method, "INVITE") == 0 && m_session_state.session_status == SESSION_STATUS_INVITING){
+            m_session_state.session_status = SESSION_STATUS_IDLE;
+            m_session_state.last_req_message_ms = 0;
+            m_session_state.last_req_message_seq = 0;
+            abort_resumed_call();
+            on_call_ack_error(CALL_ERROR_SERVER_NO_ANSWER);
+        }else
+        if (strcmp(method, "REGISTER") == 0 && m_session_state.session_status == SESSION_STATUS_REGISTERING){
+            m_session_state.session_status = SESSION_STATUS_IDLE;
+            m_session_state.last_req_message_ms = 0;
+            m_session_state.last_req_message_seq = 0;
+        }
+    }
+    adapter_unlock_sip_mutex();
+}
+
 void session_checking(void *param){
     if (!m_session_state.protocol_inited){
         return;
@@ -995,20 +1408,23 @@ void session_checking(void *param){
     adapter_lock_sip_mutex();
     uint32_t ms = adapter_get_system_ms();
 
-    // 检查注册状态
+    // 检查注册状态，REGISTER/INVITE 通常由事务的 Timer F/B 先结束等待，这里只兜底
     if (m_session_state.session_status == SESSION_STATUS_REGISTERING){
-        if ((m_session_state.last_req_message_ms + COMMAND_TIMEOUT_MS) <= ms){
+        if ((m_session_state.last_req_message_ms + SIP_TRANSACTION_FALLBACK_MS) <= ms){
+            sip_transaction_cancel("REGISTER", m_session_state.last_req_message_seq);
             m_session_state.session_status = SESSION_STATUS_IDLE;
             m_session_state.last_req_message_ms = 0;
             m_session_state.last_req_message_seq = 0;
         }
     }else
     if (m_session_state.session_status == SESSION_STATUS_INVITING){
-        if ((m_session_state.last_req_message_ms + COMMAND_TIMEOUT_MS) <= ms){
+        if ((m_session_state.last_req_message_ms + SIP_TRANSACTION_FALLBACK_MS) <= ms){
+            sip_transaction_cancel("INVITE", m_session_state.last_req_message_seq);
             m_session_state.session_status = SESSION_STATUS_IDLE;
             m_session_state.last_req_message_ms = 0;
             m_session_state.last_req_message_seq = 0;
 
+            abort_resumed_call();
             on_call_ack_error(CALL_ERROR_SERVER_NO_ANSWER);
         }
     }else
@@ -1016,6 +1432,8 @@ void session_checking(void *param){
         if ((m_session_state.last_traffic_ms + g_audio_enc_media_param.idle_timeout * 1000) <= ms){
             LOG_INFO("No traffic for %d seconds, assuming call dropped", g_audio_enc_media_param.idle_timeout);
             finish_call();
+            // 服务端可能已经释放了媒体，不能恢复
+            m_parked_media.valid = 0;
             on_call_terminated_by_server();
         }
     }else
@@ -1033,37 +1451,39 @@ void session_checking(void *param){
 }
 
 
+void get_sip_dispatch_statistics(sip_dispatch_stats_ptr stats){
+    if (!stats){
+        return;
+    }
+    stats->dispatched = atomic_load_explicit(&m_dispatch_stats.dispatched, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&m_dispatch_stats.dropped, memory_order_relaxed);
+    stats->last_latency_ms = atomic_load_explicit(&m_dispatch_stats.last_latency_ms, memory_order_relaxed);
+    stats->max_latency_ms = atomic_load_explicit(&m_dispatch_stats.max_latency_ms, memory_order_relaxed);
+    stats->total_latency_ms = atomic_load_explicit(&m_dispatch_stats.total_latency_ms, memory_order_relaxed);
+}
+
+
 void mqtt_proc_task(void *param){
     while (1) {
-        adapter_lock_sip_list_mutex();
-        int list_size = osip_list_size(&m_received_sip_list);
-        if (list_size == 0) {
-            adapter_unlock_sip_list_mutex();
-            adapter_task_delay(50);
+        // 阻塞等待消息，收到后立即处理，不再轮询
+        queued_sip_message_t item = {0};
+        if (adapter_queue_receive(m_received_sip_queue, &item, -1) != RET_OK) {
             continue;
         }
-        uint8_t* msg = (uint8_t*)osip_list_get(&m_received_sip_list, 0);
-        if (msg) {
-            osip_list_remove(&m_received_sip_list, 0);
+        char* msg = item.data;
+
+        uint32_t latency_ms = adapter_get_system_ms() - item.enqueue_ms;
+        // 只有本任务写这几项，最大值不需要比较交换
+        atomic_fetch_add_explicit(&m_dispatch_stats.dispatched, 1, memory_order_relaxed);
+        atomic_store_explicit(&m_dispatch_stats.last_latency_ms, latency_ms, memory_order_relaxed);
+        atomic_fetch_add_explicit(&m_dispatch_stats.total_latency_ms, latency_ms, memory_order_relaxed);
+        if (latency_ms > atomic_load_explicit(&m_dispatch_stats.max_latency_ms, memory_order_relaxed)){
+            atomic_store_explicit(&m_dispatch_stats.max_latency_ms, latency_ms, memory_order_relaxed);
         }
-        adapter_unlock_sip_list_mutex();
 
         if (msg) {
             // 处理接收到的消息
-            void *root = adapter_parse_json_string((char *)msg);
-            if(root != NULL){
-                char protocol[10] = {0};
-                strcpy(protocol, adapter_get_json_string_value(root, "protocol"));
-                char* payload = adapter_get_json_string_value(root, "payload");
-                if (strcmp("SIP", protocol) == 0){
-                    handle_received_sip(payload, strlen(payload));
-                }else
-                if (strcmp("MCP", protocol) == 0){
-                    on_server_mcp_call(payload);
-                }
-                adapter_delete_json_object(root);
-                root = NULL;
-            }
+            dispatch_mqtt_message(msg, item.len);
             free(msg);
         }
     }
@@ -1087,15 +1507,29 @@ void init_session_module(const char* uid, const char* device_ip){
     m_session_state.uid[len - 1] = '\0';
     strncpy(m_session_state.device_ip, device_ip, sizeof(m_session_state.device_ip)-1);
     m_session_state.seq = adapter_get_system_ms()%1000;
+    m_session_state.binary_envelope = 0;
+    m_session_state.resumed = 0;
+    m_session_state.cancelled_invite_seq = 0;
+    m_parked_media.valid = 0;
     adapter_unlock_sip_mutex();
 
+    sip_transaction_clear();
+    sip_transaction_init(transmit_sip, on_transaction_timeout);
+
 #ifdef SIP_MESSAGE_CACHED_IN_LIST
-    osip_list_init(&m_received_sip_list);
-    adapter_start_thread(mqtt_proc_task, "mqtt_proc_task", 1024*8, 16, NULL);
+    if (!m_received_sip_queue){
+        m_received_sip_queue = adapter_create_queue(SIP_MESSAGE_QUEUE_LENGTH, sizeof(queued_sip_message_t));
+        adapter_start_thread(mqtt_proc_task, "mqtt_proc_task", 1024*8, 16, NULL);
+    }
 #else
     send_register(&m_register_param);
 #endif
 
-    adapter_start_periodic_task(session_checking, 1000, 1024*8, NULL);
-    adapter_start_periodic_task(proc_register_task, 10 * 1000, 1024*8, NULL);
+    // 定时任务共用适配层的时间轮，协议重启时不重复添加
+    static int timers_started = 0;
+    if (!timers_started){
+        timers_started = 1;
+        adapter_start_periodic_task(session_checking, 1000, 1024*8, NULL);
+        adapter_start_periodic_task(proc_register_task, 10 * 1000, 1024*8, NULL);
+    }
 }
@@ -27,6 +27,9 @@ typedef struct {
     uint32_t last_traffic_ms;  // 上次的语音流量的时间ms, 用于判断通话是否活跃
     received_sip_message_ptr invite_200_ok_resp_message;
     char device_ip[16];
+    int binary_envelope;       // 服务端已确认使用二进制信封
+    int resumed;               // 已在停放的媒体上开流，INVITE 尚未确认
+    int cancelled_invite_seq;  // 已发送 CANCEL、仍在等待最终响应的 INVITE 序号，0 表示没有
 } session_state_machine_t;
 
 int check_if_session_in_call();
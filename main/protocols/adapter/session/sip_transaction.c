@@ -0,0 +1,281 @@
+#include "../protocol.h"
+#include "sip_transaction.h"
+#include "string.h"
+#include "stdlib.h"
+
+#define ADAPTER_LOG_TAG        "[SIP-TRANSACTION]"
+#define LOG_LEVEL_ENABLED      LOG_INFO_LEVEL
+#include "../adapter.h"
+
+
+typedef struct {
+    int in_use;
+    uint8_t generation;
+    int invite;
+    int cseq_num;
+    char method[16];
+    char branch[64];
+    char *message;                 // 用于重传的请求副本
+    uint32_t interval_ms;          // 当前重传间隔
+    int retransmit_timer;          // Timer A / E
+    int timeout_timer;             // Timer B / F
+    int retransmissions;
+} sip_client_transaction_t;
+
+// 每个事务同时持有 Timer A/E 和 Timer B/F，会话检查和注册各占一个周期定时器；
+// 同一批到期的重传定时器在回调中重新启动时，自身槽位尚未释放，再多留一个
+_Static_assert(SIP_TIMER_MAX >= 2 * SIP_TRANSACTION_MAX + 3, "SIP_TIMER_MAX too small for SIP_TRANSACTION_MAX");
+
+static sip_client_transaction_t m_transactions[SIP_TRANSACTION_MAX];
+static sip_ret_t (*m_transmit)(char *message) = NULL;
+static sip_transaction_timeout_cb m_on_timeout = NULL;
+
+
+/**
+ * 从报文中取出第一个 Via 的 branch 参数
+ */
+static void extract_branch(const char *message, char *out, size_t out_size){
+    out[0] = '\0';
+    const char *via = strstr(message, "\nVia:");
+    if (!via) {
+        via = strstr(message, "\nv:");
+    }
+    if (!via) {
+        return;
+    }
+    const char *line_end = strchr(via + 1, '\n');
+    const char *branch = strstr(via, "branch=");
+    if (!branch || (line_end && branch > line_end)) {
+        return;
+    }
+    branch += strlen("branch=");
+    size_t len = strcspn(branch, ";, \r\n");
+    if (len >= out_size) {
+        len = out_size - 1;
+    }
+    memcpy(out, branch, len);
+    out[len] = '\0';
+}
+
+static void *timer_arg(sip_client_transaction_t *trans){
+    int index = (int)(trans - m_transactions);
+    return (void *)(intptr_t)((trans->generation << 8) | index);
+}
+
+/**
+ * 定时器回调可能在事务结束、槽位被复用之后才执行，用 generation 校验
+ */
+static sip_client_transaction_t *transaction_from_arg(void *arg){
+    int value = (int)(intptr_t)arg;
+    int index = value & 0xFF;
+    if (index >= SIP_TRANSACTION_MAX) {
+        return NULL;
+    }
+    sip_client_transaction_t *trans = &m_transactions[index];
+    if (!trans->in_use || trans->generation != (uint8_t)(value >> 8)) {
+        return NULL;
+    }
+    return trans;
+}
+
+static void terminate_transaction(sip_client_transaction_t *trans){
+    adapter_stop_timer(trans->retransmit_timer);
+    adapter_stop_timer(trans->timeout_timer);
+    if (trans->message) {
+        free(trans->message);
+    }
+    uint8_t generation = trans->generation;
+    memset(trans, 0, sizeof(*trans));
+    trans->generation = generation + 1;
+    trans->retransmit_timer = -1;
+    trans->timeout_timer = -1;
+}
+
+static void on_retransmit_timer(void *arg){
+    adapter_lock_sip_mutex();
+    sip_client_transaction_t *trans = transaction_from_arg(arg);
+    if (trans && trans->message && m_transmit) {
+        trans->retransmissions++;
+        LOG_INFO("Retransmitting %s cseq %d (#%d)", trans->method, trans->cseq_num, trans->retransmissions);
+        m_transmit(trans->message);
+
+        // Timer A 每次翻倍；Timer E 翻倍但不超过 T2
+        trans->interval_ms *= 2;
+        if (!trans->invite && trans->interval_ms > SIP_TIMER_T2_MS) {
+            trans->interval_ms = SIP_TIMER_T2_MS;
+        }
+        trans->retransmit_timer = adapter_start_timer(on_retransmit_timer, trans->interval_ms, 0, timer_arg(trans));
+    }
+    adapter_unlock_sip_mutex();
+}
+
+static void on_timeout_timer(void *arg){
+    adapter_lock_sip_mutex();
+    sip_client_transaction_t *trans = transaction_from_arg(arg);
+    if (trans) {
+        char method[sizeof(trans->method)];
+        int cseq_num = trans->cseq_num;
+        strncpy(method, trans->method, sizeof(method));
+        LOG_INFO("%s cseq %d timed out after %d retransmissions", method, cseq_num, trans->retransmissions);
+        // 超时回调中可能发起新的事务，先释放槽位
+        trans->timeout_timer = -1;
+        terminate_transaction(trans);
+        if (m_on_timeout) {
+            m_on_timeout(method, cseq_num);
+        }
+    }
+    adapter_unlock_sip_mutex();
+}
+
+static sip_client_transaction_t *find_transaction(const char *method, int cseq_num, const char *branch){
+    for (int i = 0; i < SIP_TRANSACTION_MAX; i++) {
+        sip_client_transaction_t *trans = &m_transactions[i];
+        if (!trans->in_use || trans->cseq_num != cseq_num || strcmp(trans->method, method) != 0) {
+            continue;
+        }
+        // 双方都有 branch 时才比较，兼容不回传 branch 的服务端
+        if (branch && branch[0] && trans->branch[0] && strcmp(trans->branch, branch) != 0) {
+            continue;
+        }
+        return trans;
+    }
+    return NULL;
+}
+
+void sip_transaction_init(sip_ret_t (*transmit)(char *message), sip_transaction_timeout_cb on_timeout){
+    adapter_lock_sip_mutex();
+    m_transmit = transmit;
+    m_on_timeout = on_timeout;
+    adapter_unlock_sip_mutex();
+}
+
+sip_ret_t sip_transaction_send(const char *method, int cseq_num, char *message){
+    if (!method || !message || !m_transmit) {
+        return RET_ERROR;
+    }
+
+    adapter_lock_sip_mutex();
+    sip_client_transaction_t *trans = NULL;
+    for (int i = 0; i < SIP_TRANSACTION_MAX; i++) {
+        if (!m_transactions[i].in_use) {
+            trans = &m_transactions[i];
+            break;
+        }
+    }
+
+    if (!trans) {
+        LOG_WARN("Transaction table full, %s cseq %d sent without retransmission", method, cseq_num);
+        sip_ret_t ret = m_transmit(message);
+        adapter_unlock_sip_mutex();
+        return ret;
+    }
+
+    size_t len = strlen(message);
+    trans->message = malloc(len + 1);
+    if (!trans->message) {
+        sip_ret_t ret = m_transmit(message);
+        adapter_unlock_sip_mutex();
+        return ret;
+    }
+    memcpy(trans->message, message, len + 1);
+    trans->in_use = 1;
+    trans->invite = strcmp(method, "INVITE") == 0;
+    trans->cseq_num = cseq_num;
+    strncpy(trans->method, method, sizeof(trans->method) - 1);
+    extract_branch(message, trans->branch, sizeof(trans->branch));
+    trans->interval_ms = SIP_TIMER_T1_MS;
+    trans->retransmissions = 0;
+    trans->retransmit_timer = -1;
+
+    // 没有 Timer B/F 的事务收不到最终响应时永远不会结束，宁可不发送
+    trans->timeout_timer = adapter_start_timer(on_timeout_timer, SIP_TRANSACTION_TIMEOUT_MS, 0, timer_arg(trans));
+    if (trans->timeout_timer < 0) {
+        LOG_WARN("No timer for %s cseq %d, request not sent", method, cseq_num);
+        terminate_transaction(trans);
+        adapter_unlock_sip_mutex();
+        return RET_ERROR;
+    }
+    trans->retransmit_timer = adapter_start_timer(on_retransmit_timer, SIP_TIMER_T1_MS, 0, timer_arg(trans));
+
+    sip_ret_t ret = m_transmit(message);
+    adapter_unlock_sip_mutex();
+    return ret;
+}
+
+int sip_transaction_on_response(received_sip_message_ptr response){
+    if (!response) {
+        return 0;
+    }
+
+    char branch[64] = {0};
+    const char *param = strstr(response->via_header, "branch=");
+    if (param) {
+        param += strlen("branch=");
+        size_t len = strcspn(param, ";, \r\n");
+        if (len >= sizeof(branch)) {
+            len = sizeof(branch) - 1;
+        }
+        memcpy(branch, param, len);
+    }
+
+    adapter_lock_sip_mutex();
+    int deliver = 0;
+    sip_client_transaction_t *trans = find_transaction(response->method, response->cseq_num, branch);
+    if (!trans) {
+        // 2xx 的重传需要会话层重发 ACK，其余响应属于已结束的事务，直接丢弃
+        deliver = strcmp(response->method, "INVITE") == 0 && response->status_code >= 200 && response->status_code < 300;
+        if (!deliver) {
+            LOG_INFO("Absorbed %d response for %s cseq %d without transaction",
+                response->status_code, response->method, response->cseq_num);
+        }
+    } else if (response->status_code < 200) {
+        // 临时响应：INVITE 停止重传只等 Timer B；非 INVITE 按 T2 间隔继续重传
+        if (trans->invite) {
+            adapter_stop_timer(trans->retransmit_timer);
+            trans->retransmit_timer = -1;
+        } else {
+            trans->interval_ms = SIP_TIMER_T2_MS;
+        }
+    } else {
+        if (trans->retransmissions > 0) {
+            LOG_INFO("%s cseq %d completed after %d retransmissions", trans->method, trans->cseq_num, trans->retransmissions);
+        }
+        terminate_transaction(trans);
+        deliver = 1;
+    }
+    adapter_unlock_sip_mutex();
+    return deliver;
+}
+
+const char *sip_transaction_get_message(const char *method, int cseq_num){
+    if (!method) {
+        return NULL;
+    }
+    adapter_lock_sip_mutex();
+    sip_client_transaction_t *trans = find_transaction(method, cseq_num, NULL);
+    const char *message = trans ? trans->message : NULL;
+    adapter_unlock_sip_mutex();
+    return message;
+}
+
+void sip_transaction_cancel(const char *method, int cseq_num){
+    if (!method) {
+        return;
+    }
+    adapter_lock_sip_mutex();
+    sip_client_transaction_t *trans = find_transaction(method, cseq_num, NULL);
+    if (trans) {
+        terminate_transaction(trans);
+    }
+    adapter_unlock_sip_mutex();
+}
+
+void sip_transaction_clear(void){
+    adapter_lock_sip_mutex();
+    for (int i = 0; i < SIP_TRANSACTION_MAX; i++) {
+        if (m_transactions[i].in_use) {
+            terminate_transaction(&m_transactions[i]);
+        }
+    }
+    adapter_unlock_sip_mutex();
+}
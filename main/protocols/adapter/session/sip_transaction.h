@@ -0,0 +1,56 @@
+#ifndef __SIP_TRANSACTION_H__
+#define __SIP_TRANSACTION_H__
+#include "osip_adapter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * RFC 3261 17.1 客户端事务。MQTT QoS0 按不可靠传输处理：
+ * INVITE 使用 Timer A 重传（T1 起每次翻倍），Timer B 超时；
+ * 其他请求使用 Timer E 重传（T1 起翻倍，上限 T2），Timer F 超时。
+ * 事务以 CSeq 序号 + 方法 + Via branch 区分，可同时存在多个。
+ * 所有函数都在 sip 互斥锁保护下运行，可以在已持有该锁时调用。
+ */
+
+/**
+ * 事务超时回调（Timer B/F），在定时器任务中调用，调用时已持有 sip 互斥锁
+ */
+typedef void (*sip_transaction_timeout_cb)(const char *method, int cseq_num);
+
+void sip_transaction_init(sip_ret_t (*transmit)(char *message), sip_transaction_timeout_cb on_timeout);
+
+/**
+ * 发送请求并创建客户端事务，message 会被复制用于重传，调用者仍需自行释放。
+ * 事务表已满时只发送一次，不做重传
+ */
+sip_ret_t sip_transaction_send(const char *method, int cseq_num, char *message);
+
+/**
+ * 收到响应时调用。返回 1 表示需要交给会话层处理，返回 0 表示已被事务层吸收：
+ * 临时响应、以及找不到事务的非 INVITE 响应（如重传请求后收到的重复响应）。
+ * INVITE 的 2xx 即使事务已结束也交给会话层，以便重发 ACK
+ */
+int sip_transaction_on_response(received_sip_message_ptr response);
+
+/**
+ * 取得进行中事务的请求副本（如用于构造 CANCEL），事务结束后失效，没有时返回 NULL
+ */
+const char *sip_transaction_get_message(const char *method, int cseq_num);
+
+/**
+ * 终止指定事务，不再重传，也不会触发超时回调
+ */
+void sip_transaction_cancel(const char *method, int cseq_num);
+
+/**
+ * 终止所有事务
+ */
+void sip_transaction_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,589 @@
+#include "osip_adapter.h"
+#include "string.h"
+#include "stdlib.h"
+#include "limits.h"
+
+#define ADAPTER_LOG_TAG    "[DCP-DECODER]"
+#define LOG_LEVEL_ENABLED  LOG_INFO_LEVEL
+#include "adapter/adapter.h"
+
+
+/**
+ * DCP 消息解码器：按下面的描述表一次扫描 JSON 文本，直接填充目标结构体，不构建 cJSON 树。
+ * 新增服务端下发的 DCP 命令时，只需在 s_dcp_schemas 中增加一项并描述其 params 字段。
+ */
+
+#define DCP_MAX_NESTING    32
+
+typedef enum {
+    DCP_FIELD_STRING,   // char[]，超长截断
+    DCP_FIELD_INT,      // 数字
+    DCP_FIELD_FLAG,     // 数字或 true/false
+    DCP_FIELD_FLOAT,    // 数字或数字字符串
+    DCP_FIELD_ENUM,     // 字符串映射为枚举值，未知值使用默认值
+    DCP_FIELD_OBJECT,   // 嵌套对象，字段由 fields 描述
+    DCP_FIELD_CONST     // 不从 params 读取，固定为默认值
+} dcp_field_type_t;
+
+typedef struct {
+    const char *name;
+    int value;
+} dcp_enum_entry_t;
+
+typedef struct dcp_field {
+    const char *key;
+    dcp_field_type_t type;
+    uint16_t offset;
+    uint16_t size;
+    int default_int;
+    float default_float;
+    const dcp_enum_entry_t *enums;
+    const struct dcp_field *fields;
+} dcp_field_t;
+
+typedef struct {
+    const char *name;
+    dcp_cmd_type_t cmd_type;
+    size_t struct_size;
+    const dcp_field_t *fields;
+} dcp_schema_t;
+
+#define FIELD_SIZE(type, member) sizeof(((type*)0)->member)
+
+#define DCP_STRING(type, member, key) \
+    {key, DCP_FIELD_STRING, offsetof(type, member), FIELD_SIZE(type, member), 0, 0.0f, NULL, NULL}
+#define DCP_INT(type, member, key, def) \
+    {key, DCP_FIELD_INT, offsetof(type, member), FIELD_SIZE(type, member), def, 0.0f, NULL, NULL}
+#define DCP_FLAG(type, member, key) \
+    {key, DCP_FIELD_FLAG, offsetof(type, member), FIELD_SIZE(type, member), 0, 0.0f, NULL, NULL}
+#define DCP_FLOAT(type, member, key, def) \
+    {key, DCP_FIELD_FLOAT, offsetof(type, member), FIELD_SIZE(type, member), 0, def, NULL, NULL}
+#define DCP_ENUM(type, member, key, table, def) \
+    {key, DCP_FIELD_ENUM, offsetof(type, member), FIELD_SIZE(type, member), def, 0.0f, table, NULL}
+#define DCP_OBJECT(type, member, key, sub_fields) \
+    {key, DCP_FIELD_OBJECT, offsetof(type, member), FIELD_SIZE(type, member), 0, 0.0f, NULL, sub_fields}
+#define DCP_CONST(type, member, value) \
+    {NULL, DCP_FIELD_CONST, offsetof(type, member), FIELD_SIZE(type, member), value, 0.0f, NULL, NULL}
+#define DCP_FIELD_END \
+    {NULL, DCP_FIELD_STRING, 0, 0, 0, 0.0f, NULL, NULL}
+
+
+static const dcp_enum_entry_t s_notification_levels[] = {
+    {"info", _INFO_}, {"warning", _WARNING_}, {"critical", _CRITICAL_}, {NULL, 0}
+};
+
+static const dcp_enum_entry_t s_subscription_status[] = {
+    {"active", ACTIVE}, {"expired", EXIPIRED}, {"trial", TRIAL}, {"blocked", BLOCKED}, {NULL, 0}
+};
+
+static const dcp_enum_entry_t s_device_modes[] = {
+    {"explanation", EXPLANATION}, {"interaction", INTERACTION}, {"duo", DUO}, {"human_agent", HUMAN_AGENT}, {NULL, 0}
+};
+
+static const dcp_enum_entry_t s_device_motions[] = {
+    {"nod", NOD}, {"shake_head", SHAKE_HEAD}, {"dance", DANCE}, {"wave", WAVE},
+    {"emotion", EMOTION}, {"custom", CUSTOM}, {"idle", IDLE}, {NULL, 0}
+};
+
+static const dcp_enum_entry_t s_motion_priorities[] = {
+    {"low", _LOW_}, {"normal", _NORMAL_}, {"high", _HIGH_}, {"interrupt", _INTERRUPT_}, {NULL, 0}
+};
+
+static const dcp_enum_entry_t s_motion_stop_scopes[] = {
+    {"all", ALL}, {"current", CURRENT}, {"type", TYPE}, {NULL, 0}
+};
+
+
+static const dcp_field_t s_audio_input_text_fields[] = {
+    DCP_STRING(data_audio_input_text_t, text, "text"),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_audio_output_start_fields[] = {
+    DCP_CONST(control_audio_output_state_t, state, ON),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_audio_output_text_fields[] = {
+    DCP_STRING(data_audio_output_text_t, text, "text"),
+    DCP_STRING(data_audio_output_text_t, emotion, "emotion"),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_audio_output_stop_fields[] = {
+    DCP_CONST(control_audio_output_state_t, state, OFF),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_system_notification_fields[] = {
+    DCP_ENUM(event_system_notification_t, level, "level", s_notification_levels, _INFO_),
+    DCP_STRING(event_system_notification_t, emotion, "emotion"),
+    DCP_STRING(event_system_notification_t, message, "message"),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_device_capability_fields[] = {
+    DCP_INT(device_capability_t, chat, "chat", 0),
+    DCP_INT(device_capability_t, vision, "vision", 0),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_device_lifecycle_fields[] = {
+    DCP_FLAG(event_device_lifecycle_t, activated, "activated"),
+    DCP_ENUM(event_device_lifecycle_t, subscription, "subscription", s_subscription_status, ACTIVE),
+    DCP_OBJECT(event_device_lifecycle_t, capabilities, "capabilities", s_device_capability_fields),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_device_mode_set_fields[] = {
+    DCP_ENUM(control_device_mode_set_t, mode, "mode", s_device_modes, EXPLANATION),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_device_motion_execute_fields[] = {
+    DCP_ENUM(control_device_motion_execute_t, action, "action", s_device_motions, IDLE),
+    DCP_ENUM(control_device_motion_execute_t, priority, "priority", s_motion_priorities, _NORMAL_),
+    DCP_INT(control_device_motion_execute_t, repeat, "repeat", 0),
+    DCP_FLOAT(control_device_motion_execute_t, speed, "speed", 1.0f),
+    DCP_FIELD_END
+};
+
+static const dcp_field_t s_device_motion_stop_fields[] = {
+    DCP_ENUM(control_device_motion_stop_t, scope, "scope", s_motion_stop_scopes, ALL),
+    DCP_ENUM(control_device_motion_stop_t, type, "type", s_device_motions, IDLE),
+    DCP_FIELD_END
+};
+
+/**
+ * audio.output.text 在 TTS 期间每句一条，放在第一位
+ */
+static const dcp_schema_t s_dcp_schemas[] = {
+    {DCP_AUDIO_OUTPUT_TEXT,     DATA_AUDIO_OUTPUT_TEXT,        sizeof(data_audio_output_text_t),        s_audio_output_text_fields},
+    {DCP_AUDIO_INPUT_TEXT,      DATA_AUDIO_INPUT_TEXT,         sizeof(data_audio_input_text_t),         s_audio_input_text_fields},
+    {DCP_AUDIO_OUTPUT_START,    CONTROL_AUDIO_OUTPUT_STATE,    sizeof(control_audio_output_state_t),    s_audio_output_start_fields},
+    {DCP_AUDIO_OUTPUT_STOP,     CONTROL_AUDIO_OUTPUT_STATE,    sizeof(control_audio_output_state_t),    s_audio_output_stop_fields},
+    {DCP_SYSTEM_NOTIFICATION,   EVENT_SYSTEM_NOTIFICATION,     sizeof(event_system_notification_t),     s_system_notification_fields},
+    {DCP_DEVICE_LIFECYCLE,      EVENT_DEVICE_LIFECYCLE,        sizeof(event_device_lifecycle_t),        s_device_lifecycle_fields},
+    {DCP_DEVICE_MODE_SET,       CONTROL_DEVICE_MODE_SET,       sizeof(control_device_mode_set_t),       s_device_mode_set_fields},
+    {DCP_DEVICE_MOTION_EXECUTE, CONTROL_DEVICE_MOTION_EXECUTE, sizeof(control_device_motion_execute_t), s_device_motion_execute_fields},
+    {DCP_DEVICE_MOTION_STOP,    CONTROL_DEVICE_MOTION_STOP,    sizeof(control_device_motion_stop_t),    s_device_motion_stop_fields},
+};
+
+
+static const char *skip_ws(const char *p){
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    return p;
+}
+
+static int hex_value(char c){
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int parse_hex4(const char *p, unsigned int *out){
+    unsigned int val = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hex_value(p[i]);
+        if (h < 0) {
+            return 0;
+        }
+        val = (val << 4) | (unsigned int)h;
+    }
+    *out = val;
+    return 1;
+}
+
+/**
+ * 写入一个字节，超出 dst_size - 1 的部分丢弃（与 strncpy 截断一致）
+ */
+static void put_byte(char *dst, size_t dst_size, size_t *pos, char c){
+    if (dst && *pos + 1 < dst_size) {
+        dst[*pos] = c;
+    }
+    (*pos)++;
+}
+
+/**
+ * 解析 p 处的 JSON 字符串（p 指向开头的引号），转义后的内容写入 dst（可为 NULL，只校验并跳过）。
+ * 成功返回结束引号之后的位置，格式错误返回 NULL
+ */
+static const char *decode_string(const char *p, char *dst, size_t dst_size){
+    size_t pos = 0;
+    if (*p != '"') {
+        return NULL;
+    }
+    p++;
+    while (*p != '"') {
+        unsigned char c = (unsigned char)*p;
+        if (c == '\0' || c < 0x20) {
+            return NULL;
+        }
+        if (c != '\\') {
+            put_byte(dst, dst_size, &pos, (char)c);
+            p++;
+            continue;
+        }
+        p++;
+        switch (*p) {
+        case '"':  put_byte(dst, dst_size, &pos, '"');  break;
+        case '\\': put_byte(dst, dst_size, &pos, '\\'); break;
+        case '/':  put_byte(dst, dst_size, &pos, '/');  break;
+        case 'b':  put_byte(dst, dst_size, &pos, '\b'); break;
+        case 'f':  put_byte(dst, dst_size, &pos, '\f'); break;
+        case 'n':  put_byte(dst, dst_size, &pos, '\n'); break;
+        case 'r':  put_byte(dst, dst_size, &pos, '\r'); break;
+        case 't':  put_byte(dst, dst_size, &pos, '\t'); break;
+        case 'u': {
+            unsigned int cp = 0;
+            if (!parse_hex4(p + 1, &cp)) {
+                return NULL;
+            }
+            p += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                // UTF-16 代理对
+                unsigned int low = 0;
+                if (p[1] != '\\' || p[2] != 'u' || !parse_hex4(p + 3, &low) || low < 0xDC00 || low > 0xDFFF) {
+                    return NULL;
+                }
+                p += 6;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                return NULL;
+            }
+            if (cp < 0x80) {
+                put_byte(dst, dst_size, &pos, (char)cp);
+            } else if (cp < 0x800) {
+                put_byte(dst, dst_size, &pos, (char)(0xC0 | (cp >> 6)));
+                put_byte(dst, dst_size, &pos, (char)(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                put_byte(dst, dst_size, &pos, (char)(0xE0 | (cp >> 12)));
+                put_byte(dst, dst_size, &pos, (char)(0x80 | ((cp >> 6) & 0x3F)));
+                put_byte(dst, dst_size, &pos, (char)(0x80 | (cp & 0x3F)));
+            } else {
+                put_byte(dst, dst_size, &pos, (char)(0xF0 | (cp >> 18)));
+                put_byte(dst, dst_size, &pos, (char)(0x80 | ((cp >> 12) & 0x3F)));
+                put_byte(dst, dst_size, &pos, (char)(0x80 | ((cp >> 6) & 0x3F)));
+                put_byte(dst, dst_size, &pos, (char)(0x80 | (cp & 0x3F)));
+            }
+            break;
+        }
+        default:
+            return NULL;
+        }
+        p++;
+    }
+    if (dst && dst_size > 0) {
+        dst[pos < dst_size ? pos : dst_size - 1] = '\0';
+    }
+    return p + 1;
+}
+
+/**
+ * 解析 JSON 数字，成功返回数字之后的位置
+ */
+static const char *decode_number(const char *p, double *out){
+    if (*p != '-' && (*p < '0' || *p > '9')) {
+        return NULL;
+    }
+    // 与 cJSON 一样只把数字字符交给 strtod，避免 inf、十六进制等写法被接受
+    char buf[64];
+    size_t len = 0;
+    while (len < sizeof(buf) - 1 && ((p[len] >= '0' && p[len] <= '9') ||
+           p[len] == '-' || p[len] == '+' || p[len] == '.' || p[len] == 'e' || p[len] == 'E')) {
+        buf[len] = p[len];
+        len++;
+    }
+    buf[len] = '\0';
+    char *end = NULL;
+    double val = strtod(buf, &end);
+    if (end == buf) {
+        return NULL;
+    }
+    *out = val;
+    return p + (end - buf);
+}
+
+static int number_to_int(double val){
+    if (val >= INT_MAX) return INT_MAX;
+    if (val <= (double)INT_MIN) return INT_MIN;
+    return (int)val;
+}
+
+static const char *match_literal(const char *p, const char *literal){
+    size_t len = strlen(literal);
+    return strncmp(p, literal, len) == 0 ? p + len : NULL;
+}
+
+static const char *skip_value(const char *p, int depth);
+
+/**
+ * 遍历对象，对每个键调用 on_member。on_member 负责解析值并返回值之后的位置
+ */
+typedef const char *(*dcp_member_cb)(const char *key, size_t key_len, const char *value, int depth, void *ctx);
+
+static const char *walk_object(const char *p, int depth, dcp_member_cb on_member, void *ctx){
+    if (*p != '{' || depth > DCP_MAX_NESTING) {
+        return NULL;
+    }
+    p = skip_ws(p + 1);
+    if (*p == '}') {
+        return p + 1;
+    }
+    while (1) {
+        const char *key = p + 1;
+        const char *key_end = decode_string(p, NULL, 0);
+        if (!key_end) {
+            return NULL;
+        }
+        p = skip_ws(key_end);
+        if (*p != ':') {
+            return NULL;
+        }
+        p = skip_ws(p + 1);
+        p = on_member ? on_member(key, (size_t)(key_end - 1 - key), p, depth, ctx) : skip_value(p, depth + 1);
+        if (!p) {
+            return NULL;
+        }
+        p = skip_ws(p);
+        if (*p == '}') {
+            return p + 1;
+        }
+        if (*p != ',') {
+            return NULL;
+        }
+        p = skip_ws(p + 1);
+    }
+}
+
+static const char *skip_value(const char *p, int depth){
+    double num = 0;
+    if (depth > DCP_MAX_NESTING) {
+        return NULL;
+    }
+    switch (*p) {
+    case '"':
+        return decode_string(p, NULL, 0);
+    case '{':
+        return walk_object(p, depth, NULL, NULL);
+    case '[':
+        p = skip_ws(p + 1);
+        if (*p == ']') {
+            return p + 1;
+        }
+        while (1) {
+            p = skip_value(p, depth + 1);
+            if (!p) {
+                return NULL;
+            }
+            p = skip_ws(p);
+            if (*p == ']') {
+                return p + 1;
+            }
+            if (*p != ',') {
+                return NULL;
+            }
+            p = skip_ws(p + 1);
+        }
+    case 't':
+        return match_literal(p, "true");
+    case 'f':
+        return match_literal(p, "false");
+    case 'n':
+        return match_literal(p, "null");
+    default:
+        return decode_number(p, &num);
+    }
+}
+
+static int key_equals(const char *key, size_t key_len, const char *name){
+    return strlen(name) == key_len && strncmp(key, name, key_len) == 0;
+}
+
+static void store_int(uint8_t *base, const dcp_field_t *field, int value){
+    if (field->size == sizeof(int)) {
+        memcpy(base + field->offset, &value, sizeof(int));
+    }
+}
+
+static void apply_defaults(uint8_t *base, const dcp_field_t *fields){
+    for (const dcp_field_t *field = fields; field->size; field++) {
+        switch (field->type) {
+        case DCP_FIELD_INT:
+        case DCP_FIELD_ENUM:
+        case DCP_FIELD_CONST:
+            store_int(base, field, field->default_int);
+            break;
+        case DCP_FIELD_FLOAT:
+            memcpy(base + field->offset, &field->default_float, sizeof(float));
+            break;
+        case DCP_FIELD_OBJECT:
+            apply_defaults(base + field->offset, field->fields);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+typedef struct {
+    uint8_t *base;
+    const dcp_field_t *fields;
+} dcp_object_ctx_t;
+
+/**
+ * 解码一个字段。值类型与描述不符时跳过该值，字段保持默认值
+ */
+static const char *decode_field(const char *key, size_t key_len, const char *p, int depth, void *ctx){
+    dcp_object_ctx_t *obj = (dcp_object_ctx_t *)ctx;
+    const dcp_field_t *field = obj->fields;
+    for (; field->size; field++) {
+        if (field->key && key_equals(key, key_len, field->key)) {
+            break;
+        }
+    }
+    if (!field->size) {
+        return skip_value(p, depth + 1);
+    }
+
+    uint8_t *dst = obj->base + field->offset;
+    double num = 0;
+    switch (field->type) {
+    case DCP_FIELD_STRING:
+        if (*p == '"') {
+            return decode_string(p, (char *)dst, field->size);
+        }
+        break;
+    case DCP_FIELD_INT:
+        if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            const char *end = decode_number(p, &num);
+            if (end) {
+                store_int(obj->base, field, number_to_int(num));
+            }
+            return end;
+        }
+        break;
+    case DCP_FIELD_FLAG:
+        if (*p == 't' || *p == 'f') {
+            const char *end = skip_value(p, depth + 1);
+            if (end) {
+                store_int(obj->base, field, *p == 't');
+            }
+            return end;
+        }
+        if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            const char *end = decode_number(p, &num);
+            if (end) {
+                store_int(obj->base, field, number_to_int(num));
+            }
+            return end;
+        }
+        break;
+    case DCP_FIELD_FLOAT:
+        if (*p == '"') {
+            char buf[24] = {0};
+            const char *end = decode_string(p, buf, sizeof(buf));
+            char *num_end = NULL;
+            float val = strtof(buf, &num_end);
+            if (end && num_end != buf) {
+                memcpy(dst, &val, sizeof(float));
+            }
+            return end;
+        }
+        if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            const char *end = decode_number(p, &num);
+            if (end) {
+                float val = (float)num;
+                memcpy(dst, &val, sizeof(float));
+            }
+            return end;
+        }
+        break;
+    case DCP_FIELD_ENUM:
+        if (*p == '"') {
+            char buf[32] = {0};
+            const char *end = decode_string(p, buf, sizeof(buf));
+            for (const dcp_enum_entry_t *entry = field->enums; end && entry->name; entry++) {
+                if (strcmp(buf, entry->name) == 0) {
+                    store_int(obj->base, field, entry->value);
+                    break;
+                }
+            }
+            return end;
+        }
+        break;
+    case DCP_FIELD_OBJECT:
+        if (*p == '{') {
+            dcp_object_ctx_t sub = {dst, field->fields};
+            return walk_object(p, depth + 1, decode_field, &sub);
+        }
+        break;
+    default:
+        break;
+    }
+    return skip_value(p, depth + 1);
+}
+
+typedef struct {
+    const dcp_schema_t *schema;
+    int name_found;
+    const char *params;
+} dcp_top_ctx_t;
+
+/**
+ * 顶层只关心 name 和 params。name 可能出现在 params 之后，因此先记录 params 的位置
+ */
+static const char *decode_top_member(const char *key, size_t key_len, const char *p, int depth, void *ctx){
+    dcp_top_ctx_t *top = (dcp_top_ctx_t *)ctx;
+    if (key_equals(key, key_len, "name") && *p == '"' && !top->name_found) {
+        const char *end = decode_string(p, NULL, 0);
+        if (!end) {
+            return NULL;
+        }
+        top->name_found = 1;
+        size_t name_len = (size_t)(end - 1 - (p + 1));
+        for (size_t i = 0; i < sizeof(s_dcp_schemas) / sizeof(s_dcp_schemas[0]); i++) {
+            if (key_equals(p + 1, name_len, s_dcp_schemas[i].name)) {
+                top->schema = &s_dcp_schemas[i];
+                break;
+            }
+        }
+        return end;
+    }
+    if (key_equals(key, key_len, "params") && !top->params) {
+        top->params = p;
+    }
+    return skip_value(p, depth + 1);
+}
+
+
+dcp_cmd_type_t parse_dcp_message(char* data, void** out_param){
+    if (!data || data[0] == '\0' || !out_param) {
+        return INVALID_CMD;
+    }
+    *out_param = NULL;
+
+    dcp_top_ctx_t top = {0};
+    if (!walk_object(skip_ws(data), 0, decode_top_member, &top) || !top.schema) {
+        return INVALID_CMD;
+    }
+
+    uint8_t *param = malloc(top.schema->struct_size);
+    if (!param) {
+        return INVALID_CMD;
+    }
+    memset(param, 0, top.schema->struct_size);
+    apply_defaults(param, top.schema->fields);
+
+    // params 在第一遍扫描中已校验过，这里只需定位字段
+    if (top.params && *top.params == '{') {
+        dcp_object_ctx_t obj = {param, top.schema->fields};
+        walk_object(top.params, 1, decode_field, &obj);
+    }
+
+    *out_param = param;
+    return top.schema->cmd_type;
+}
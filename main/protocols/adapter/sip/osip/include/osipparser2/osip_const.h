@@ -30,6 +30,8 @@
 #define OSIP_SP " \0"
 
 #define MINISIZE  1
+/* keep osip_set_allocators available in MINISIZE builds, used by the adapter's per-message arena */
+#define OSIP_ALLOCATOR_HOOKS  1
 
 #define ACCEPT "accept"
 #define ACCEPT_ENCODING "accept-encoding"
@@ -63,7 +63,7 @@ extern "C" {
 
 #if !defined(WIN32) && !defined(_WIN32_WCE)
 
-#ifndef MINISIZE
+#if !defined(MINISIZE) || defined(OSIP_ALLOCATOR_HOOKS)
 typedef void *osip_malloc_func_t(size_t size);
 typedef void osip_free_func_t(void *ptr);
 typedef void *osip_realloc_func_t(void *ptr, size_t size);
@@ -98,7 +98,7 @@ void *_osip_realloc(void *ptr, size_t size, char *file, unsigned short line);
 
 #else
 
-#ifndef MINISIZE
+#if !defined(MINISIZE) || defined(OSIP_ALLOCATOR_HOOKS)
 #ifndef osip_malloc
 #define osip_malloc(S) (osip_malloc_func ? osip_malloc_func(S) : malloc(S))
 #endif
@@ -126,7 +126,7 @@ static osip_trace_func_t *trace_func = 0;
 
 static unsigned int random_seed_set = 0;
 
-#ifndef MINISIZE
+#if !defined(MINISIZE) || defined(OSIP_ALLOCATOR_HOOKS)
 #if !defined(WIN32) && !defined(_WIN32_WCE)
 osip_malloc_func_t *osip_malloc_func = 0;
 osip_realloc_func_t *osip_realloc_func = 0;
@@ -1143,7 +1143,7 @@ void osip_free(void *ptr) {
 
 #else
 
-#ifndef MINISIZE
+#if !defined(MINISIZE) || defined(OSIP_ALLOCATOR_HOOKS)
 void osip_set_allocators(osip_malloc_func_t *malloc_func, osip_realloc_func_t *realloc_func, osip_free_func_t *free_func) {
   osip_malloc_func = malloc_func;
   osip_realloc_func = realloc_func;
@@ -2,7 +2,10 @@
 #include "osipparser2/osip_parser.h"
 #include "osipparser2/sdp_message.h"
 #include "osip_adapter.h"
+#include "sip_lite_parser.h"
+#include "sip_arena.h"
 #include "string.h"
+#include "stdlib.h"
 
 #define ADAPTER_LOG_TAG    "[SIP-ADAPTER]"
 #define LOG_LEVEL_ENABLED  LOG_INFO_LEVEL
@@ -24,6 +27,26 @@ void free_sip_message(char* sip){
         osip_free(sip);
     }
 }
+
+/**
+ * 序列化消息，结果需要在内存池作用域结束后继续使用，因此位于内存池中时拷贝到堆上
+ */
+static int sip_message_to_str(osip_message_t *msg, char **out_msg, size_t *out_len){
+    int rc = osip_message_to_str(msg, out_msg, out_len);
+    if (rc != 0 || !*out_msg || !sip_arena_contains(*out_msg)) {
+        return rc;
+    }
+    char *copy = malloc(*out_len + 1);
+    if (!copy) {
+        *out_msg = NULL;
+        return -1;
+    }
+    memcpy(copy, *out_msg, *out_len);
+    copy[*out_len] = '\0';
+    osip_free(*out_msg);
+    *out_msg = copy;
+    return 0;
+}
 /**
  * 安全地将字符串转换为整数
  */
@@ -267,6 +290,16 @@ void* build_dcp_base_msg(dcp_cmd_type_t type){
         name = DCP_AUDIO_INPUT_STATE;
         sprintf(id, "%s%ld", EVENT_MSG_NAME_TAG,  gen_evt_id());
         break;
+    case EVENT_AUDIO_INPUT_VAD:
+        type_str = "event";
+        name = DCP_AUDIO_INPUT_VAD;
+        sprintf(id, "%s%ld", EVENT_MSG_NAME_TAG,  gen_evt_id());
+        break;
+    case EVENT_AUDIO_RECEIVE_STATS:
+        type_str = "event";
+        name = DCP_AUDIO_RECEIVE_STATS;
+        sprintf(id, "%s%ld", EVENT_MSG_NAME_TAG,  gen_evt_id());
+        break;
     case EVENT_SESSION_BARGE_IN:
         name = DCP_SESSION_BARGE_IN;
         type_str = "event";
@@ -307,6 +340,7 @@ sip_ret_t build_register(sip_register_param_ptr param, char **out_msg, size_t *o
     osip_message_t *msg = NULL;
     char buf[256];
 
+    sip_arena_begin();
     CHECK_RET(osip_message_init(&msg));
 
     // 请求行：REGISTER sip:server.lovaiot.com SIP/2.0
@@ -368,6 +402,11 @@ sip_ret_t build_register(sip_register_param_ptr param, char **out_msg, size_t *o
     // User-Agent: AI-Toy/1.0
     CHECK_RET(osip_message_set_header(msg, "User-Agent", USER_AGENT));
 
+    // X-Envelope: binary，申请后续消息使用二进制信封，旧服务端会忽略该头部
+    if (param->support_binary_envelope) {
+        CHECK_RET(osip_message_set_header(msg, "X-Envelope", "binary"));
+    }
+
 // Content-Type: application/sdp
     CHECK_RET(osip_message_set_header(msg, "Content-Type", "application/json"));
 
@@ -415,12 +454,14 @@ sip_ret_t build_register(sip_register_param_ptr param, char **out_msg, size_t *o
     }
     
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(msg, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
     osip_message_free(msg);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (msg) osip_message_free(msg);
+    sip_arena_end();
     return RET_ERROR;
 }
 
@@ -436,6 +477,18 @@ static sip_ret_t make_sdp(uplink_sdp_parameter_ptr param, char *dst, size_t dst_
     if (param->wake_up_word && param->wake_up_word[0] != '\0') {
         snprintf(wake_word_part, sizeof(wake_word_part), ",wake_up_word=%s", param->wake_up_word);
     }
+    char aggregation_part[24] = {0};
+    if (param->uplink_aggregation > 1) {
+        snprintf(aggregation_part, sizeof(aggregation_part), ",aggregation=%d", param->uplink_aggregation);
+    }
+    char standby_part[96] = {0};
+    if (param->standby) {
+        if (param->resume_call_id && param->resume_call_id[0] != '\0') {
+            snprintf(standby_part, sizeof(standby_part), ",standby=1,resume=%s", param->resume_call_id);
+        } else {
+            snprintf(standby_part, sizeof(standby_part), ",standby=1");
+        }
+    }
     int n = snprintf(dst, dst_sz,
         "v=0\r\n"
         "o=%s %s %ld IN IP4 0.0.0.0\r\n"
@@ -443,10 +496,11 @@ static sip_ret_t make_sdp(uplink_sdp_parameter_ptr param, char *dst, size_t dst_
         "c=IN IP4 0.0.0.0\r\n"
         "t=0 0\r\n"
         "m=audio 0 UDP/AI-AUDIO\r\n"
-        "a=lovaiot-uplink:codec=%s,frame=%d,sample_rate=%d,channels=%d,mcp=%d%s\r\n"
+        "a=lovaiot-uplink:codec=%s,frame=%d,sample_rate=%d,channels=%d,mcp=%d%s%s%s\r\n"
         "a=lovaiot-downlink:cbr=%d,frame_gap=%d,aggregation=%d,redundant=%d\r\n",
         param->uid, param->session_id, version, 
         param->codec, param->frame_duration_ms, param->sample_rate, param->channels, param->support_mcp ? 1 : 0, wake_word_part,
+        aggregation_part, standby_part,
         param->cbr ? 1 : 0, param->frame_gap, param->support_frame_aggregation ? 1 : 0, param->support_redundant ? 1 : 0    
     );
     return (n > 0 && (size_t)n < dst_sz) ? RET_OK : RET_ERROR;
@@ -496,6 +550,10 @@ static void parse_downlink_attribute_value(const char *value, downlink_sdp_param
             hex_string_to_array(val, param->aes_key, sizeof(param->aes_key));
         } else if (osip_strcasecmp(key, "nonce") == 0) {
             hex_string_to_array(val, param->nonce, sizeof(param->nonce));
+        } else if (osip_strcasecmp(key, "uplink_aggregation") == 0) {
+            param->uplink_aggregation = atoi(val);
+        } else if (osip_strcasecmp(key, "standby") == 0) {
+            param->standby = atoi(val);
         }
     }
 }
@@ -547,6 +605,7 @@ sip_ret_t parse_sdp(const char *sdp_buf, downlink_sdp_parameter_ptr param)
     if (!sdp_buf || !param) return RET_ERROR;
 
     sdp_message_t *sdp = NULL;
+    sip_arena_begin();
     CHECK_RET(sdp_message_init(&sdp));
 
     CHECK_RET(sdp_message_parse(sdp, sdp_buf));
@@ -594,10 +653,12 @@ sip_ret_t parse_sdp(const char *sdp_buf, downlink_sdp_parameter_ptr param)
     }
 
     sdp_message_free(sdp);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (sdp) sdp_message_free(sdp);
+    sip_arena_end();
     return RET_ERROR;    
 }
 
@@ -607,8 +668,9 @@ sip_ret_t build_invite(sip_invite_param_ptr param, char **out_msg, size_t *out_l
     if (!param || !param->uid || !param->device_ip || !out_msg || !out_len) return RET_ERROR;
 
     osip_message_t *msg = NULL;
-    char buf[350];
+    char buf[512];  // 同时用于 SDP，带唤醒词和恢复的 Call-ID 时超过 350
 
+    sip_arena_begin();
     CHECK_RET(osip_message_init(&msg));
 
     // INVITE sip:server.lovaiot.com SIP/2.0
@@ -669,7 +731,7 @@ sip_ret_t build_invite(sip_invite_param_ptr param, char **out_msg, size_t *out_l
 
     // Body：SDP（如果提供则设置）
     if (param->sdp != NULL){
-        make_sdp(param->sdp, buf, sizeof(buf));
+        CHECK_RET(make_sdp(param->sdp, buf, sizeof(buf)));
         size_t sdp_len = strlen(buf);
         CHECK_RET(osip_message_set_body(msg, buf, sdp_len));
     }
@@ -689,12 +751,14 @@ sip_ret_t build_invite(sip_invite_param_ptr param, char **out_msg, size_t *out_l
     }
 
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(msg, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
     osip_message_free(msg);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (msg) osip_message_free(msg);
+    sip_arena_end();
     return RET_ERROR;
 }
 
@@ -741,6 +805,7 @@ static sip_ret_t build_response(int status_code,
     osip_message_t *resp = NULL;
     char buf[512];
 
+    sip_arena_begin();
     CHECK_RET(osip_message_init(&resp));
 
     // 状态行：SIP/2.0 200 OK
@@ -805,12 +870,14 @@ static sip_ret_t build_response(int status_code,
     }
 
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(resp, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(resp, out_msg, out_len));
     osip_message_free(resp);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (resp) osip_message_free(resp);
+    sip_arena_end();
     return RET_ERROR;
 }
 
@@ -939,15 +1006,13 @@ sip_ret_t build_invite_error_response(received_sip_message_ptr request,
 
 
 
-sip_ret_t build_ack(received_sip_message_ptr response, const char *uid, const char *device_ip, char **out_msg, size_t *out_len)
+static sip_ret_t build_ack_with_via(received_sip_message_ptr response, const char *uid, const char *device_ip,
+                                    const char *via_hdr, char **out_msg, size_t *out_len)
 {
-    if (!response || !uid || !device_ip || !out_msg || !out_len) {
-        return RET_ERROR;
-    }
-
     osip_message_t *ack = NULL;
     char buf[256];
 
+    sip_arena_begin();
     CHECK_RET(osip_message_init(&ack));
 
     // 请求行：ACK {request_uri} SIP/2.0
@@ -960,12 +1025,7 @@ sip_ret_t build_ack(received_sip_message_ptr response, const char *uid, const ch
     CHECK_RET(osip_uri_init(&ack->req_uri));
     CHECK_RET(osip_uri_parse(ack->req_uri, req_uri_str));
 
-    // 2) Via 头（为新的 ACK 事务生成 branch）
-    //    协议承载在 MQTT 上，沿用栈中示例格式
-    char via_hdr[128] = {0};
-    snprintf(via_hdr, sizeof(via_hdr), "SIP/2.0/MQTT %s;branch=z9hG4bK-ack%u",
-             device_ip, (unsigned)(adapter_get_system_ms() & 0xFFFF));
-
+    // 2) Via 头
     osip_via_t *via = NULL;
     osip_via_init(&via);
     CHECK_RET(osip_via_parse(via, via_hdr));
@@ -1005,12 +1065,98 @@ sip_ret_t build_ack(received_sip_message_ptr response, const char *uid, const ch
     CHECK_RET(osip_message_set_content_length(ack, osip_strdup("0")));
 
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(ack, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(ack, out_msg, out_len));
     osip_message_free(ack);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (ack) osip_message_free(ack);
+    sip_arena_end();
+    return RET_ERROR;
+}
+
+sip_ret_t build_ack(received_sip_message_ptr response, const char *uid, const char *device_ip, char **out_msg, size_t *out_len)
+{
+    if (!response || !uid || !device_ip || !out_msg || !out_len) {
+        return RET_ERROR;
+    }
+
+    // 2xx 的 ACK 是新的事务，生成新的 branch；协议承载在 MQTT 上，沿用栈中示例格式
+    char via_hdr[128] = {0};
+    snprintf(via_hdr, sizeof(via_hdr), "SIP/2.0/MQTT %s;branch=z9hG4bK-ack%u",
+             device_ip, (unsigned)(adapter_get_system_ms() & 0xFFFF));
+    return build_ack_with_via(response, uid, device_ip, via_hdr, out_msg, out_len);
+}
+
+sip_ret_t build_non_2xx_ack(received_sip_message_ptr response, const char *uid, const char *device_ip, char **out_msg, size_t *out_len)
+{
+    if (!response || !uid || !device_ip || !out_msg || !out_len || !response->via_header[0]) {
+        return RET_ERROR;
+    }
+    return build_ack_with_via(response, uid, device_ip, response->via_header, out_msg, out_len);
+}
+
+/**
+ * 按 RFC 3261 9.1 为尚未收到最终响应的 INVITE 构造 CANCEL：
+ * Request-URI、Via（同一 branch）、From、To、Call-ID 与 INVITE 相同，CSeq 序号相同、方法为 CANCEL
+ */
+sip_ret_t build_cancel(received_sip_message_ptr invite, char **out_msg, size_t *out_len)
+{
+    if (!invite || !out_msg || !out_len) {
+        return RET_ERROR;
+    }
+
+    osip_message_t *cancel = NULL;
+    char buf[128];
+
+    sip_arena_begin();
+    CHECK_RET(osip_message_init(&cancel));
+
+    // 请求行：CANCEL sip:server.lovaiot.com SIP/2.0，与 INVITE 一致
+    osip_message_set_method(cancel, osip_strdup("CANCEL"));
+    osip_message_set_version(cancel, osip_strdup(SIP_VERSION));
+    CHECK_RET(osip_uri_init(&cancel->req_uri));
+    snprintf(buf, sizeof(buf), "sip:%s", SERVER_HOST);
+    CHECK_RET(osip_uri_parse(cancel->req_uri, buf));
+
+    // Via: 沿用 INVITE 的 Via，服务端据此匹配要取消的事务
+    osip_via_t *via = NULL;
+    osip_via_init(&via);
+    CHECK_RET(osip_via_parse(via, invite->via_header));
+    osip_list_add(&cancel->vias, via, -1);
+
+    // Max-Forwards: 70
+    CHECK_RET(osip_message_set_header(cancel, "Max-Forwards", "70"));
+
+    CHECK_RET(osip_from_init(&cancel->from));
+    CHECK_RET(osip_from_parse(cancel->from, invite->from_header));
+
+    CHECK_RET(osip_to_init(&cancel->to));
+    CHECK_RET(osip_to_parse(cancel->to, invite->to_header));
+
+    CHECK_RET(osip_call_id_init(&cancel->call_id));
+    CHECK_RET(osip_call_id_parse(cancel->call_id, invite->call_id_header));
+
+    // CSeq: 序号与 INVITE 相同，方法改为 CANCEL
+    CHECK_RET(osip_cseq_init(&cancel->cseq));
+    snprintf(buf, sizeof(buf), "%d CANCEL", invite->cseq_num);
+    CHECK_RET(osip_cseq_parse(cancel->cseq, buf));
+
+    // User-Agent: AI-Toy/1.0
+    CHECK_RET(osip_message_set_header(cancel, "User-Agent", USER_AGENT));
+
+    // Content-Length: 0
+    CHECK_RET(osip_message_set_content_length(cancel, osip_strdup("0")));
+
+    CHECK_RET(sip_message_to_str(cancel, out_msg, out_len));
+    osip_message_free(cancel);
+    sip_arena_end();
+    return RET_OK;
+
+fail:
+    if (cancel) osip_message_free(cancel);
+    sip_arena_end();
     return RET_ERROR;
 }
 
@@ -1085,6 +1231,7 @@ sip_ret_t build_audio_input_state_start(
         return RET_ERROR;
     }
 
+    sip_arena_begin();
     osip_message_t *msg = build_info(response, uid, device_ip, cseq_num);
 
     // Body: JSON 内容
@@ -1123,13 +1270,15 @@ sip_ret_t build_audio_input_state_start(
     CHECK_RET(osip_message_set_content_length(msg, buf));
 
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(msg, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
     osip_message_free(msg);
     adapter_delete_json_object(root);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (msg) osip_message_free(msg);
+    sip_arena_end();
     return RET_ERROR;
 }
 
@@ -1147,6 +1296,7 @@ sip_ret_t build_audio_input_state_stop(
         return RET_ERROR;
     }
 
+    sip_arena_begin();
     osip_message_t *msg = build_info(response, uid, device_ip, cseq_num);
     // Body: JSON 内容
     void *root = build_dcp_base_msg(EVENT_AUDIO_INPUT_STATE);
@@ -1179,13 +1329,126 @@ sip_ret_t build_audio_input_state_stop(
     CHECK_RET(osip_message_set_content_length(msg, buf));
 
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(msg, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
+    osip_message_free(msg);
+    adapter_delete_json_object(root);
+    sip_arena_end();
+    return RET_OK;
+
+fail:
+    if (msg) osip_message_free(msg);
+    sip_arena_end();
+    return RET_ERROR;
+}
+
+
+sip_ret_t build_audio_input_vad(
+               received_sip_message_ptr response,
+               const char *uid,
+               const char *device_ip,
+               int cseq_num,
+               event_audio_input_vad_ptr param,
+               char **out_msg,
+               size_t *out_len)
+{
+    if (!response || !uid || !device_ip || !param || !out_msg || !out_len) {
+        return RET_ERROR;
+    }
+
+    sip_arena_begin();
+    osip_message_t *msg = build_info(response, uid, device_ip, cseq_num);
+    // Body: JSON 内容
+    void *root = build_dcp_base_msg(EVENT_AUDIO_INPUT_VAD);
+    void* params = adapter_create_json_object();
+    adapter_put_json_object_value(root, "params", params);
+    adapter_put_json_string_value(params, "state", param->speaking ? "speech" : "silence");
+
+    char* json_string = adapter_serialize_json_to_string(root);
+    if (!json_string) {
+        goto fail;
+    }
+
+    // osip_message_set_body 会复制消息体
+    int json_len = (int)strlen(json_string);
+    int body_ret = osip_message_set_body(msg, json_string, (size_t)json_len);
+    free(json_string);
+    CHECK_RET(body_ret);
+
+    // Content-Length: 自动计算设置
+    char buf[64] = {0};
+    snprintf(buf, sizeof(buf), "%d", json_len);
+    CHECK_RET(osip_message_set_content_length(msg, buf));
+
+    // 序列化为最终字符串
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
+    osip_message_free(msg);
+    adapter_delete_json_object(root);
+    sip_arena_end();
+    return RET_OK;
+
+fail:
+    if (msg) osip_message_free(msg);
+    adapter_delete_json_object(root);
+    sip_arena_end();
+    return RET_ERROR;
+}
+
+
+sip_ret_t build_audio_receive_stats(
+               received_sip_message_ptr response,
+               const char *uid,
+               const char *device_ip,
+               int cseq_num,
+               event_audio_receive_stats_ptr param,
+               char **out_msg,
+               size_t *out_len)
+{
+    if (!response || !uid || !device_ip || !param || !out_msg || !out_len) {
+        return RET_ERROR;
+    }
+
+    sip_arena_begin();
+    osip_message_t *msg = build_info(response, uid, device_ip, cseq_num);
+    // Body: JSON 内容
+    void *root = build_dcp_base_msg(EVENT_AUDIO_RECEIVE_STATS);
+    void* params = adapter_create_json_object();
+    adapter_put_json_object_value(root, "params", params);
+    adapter_put_json_string_value(params, "network", param->network);
+    adapter_put_json_object_value(params, "received", adapter_json_object_new_int((int)param->received));
+    adapter_put_json_object_value(params, "lost", adapter_json_object_new_int((int)param->lost));
+    adapter_put_json_object_value(params, "duplicates", adapter_json_object_new_int((int)param->duplicates));
+    adapter_put_json_object_value(params, "too_old", adapter_json_object_new_int((int)param->too_old));
+    adapter_put_json_object_value(params, "reordered", adapter_json_object_new_int((int)param->reordered));
+    adapter_put_json_object_value(params, "max_reorder_depth", adapter_json_object_new_int((int)param->max_reorder_depth));
+    adapter_put_json_object_value(params, "jitter_ms", adapter_json_object_new_int((int)param->jitter_ms));
+
+    char* json_string = adapter_serialize_json_to_string(root);
+    if (!json_string) {
+        goto fail;
+    }
+
+    // osip_message_set_body 会复制消息体
+    int json_len = (int)strlen(json_string);
+    int body_ret = osip_message_set_body(msg, json_string, (size_t)json_len);
+    free(json_string);
+    CHECK_RET(body_ret);
+
+    // Content-Length: 自动计算设置
+    char buf[64] = {0};
+    snprintf(buf, sizeof(buf), "%d", json_len);
+    CHECK_RET(osip_message_set_content_length(msg, buf));
+
+    // 序列化为最终字符串
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
     osip_message_free(msg);
     adapter_delete_json_object(root);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (msg) osip_message_free(msg);
+    adapter_delete_json_object(root);
+    sip_arena_end();
     return RET_ERROR;
 }
 
@@ -1203,6 +1466,7 @@ sip_ret_t build_session_barge_in(
         return RET_ERROR;
     }
 
+    sip_arena_begin();
     osip_message_t *msg = build_info(response, uid, device_ip, cseq_num);
     // Body: JSON 内容
     void *root = build_dcp_base_msg(EVENT_SESSION_BARGE_IN);
@@ -1235,13 +1499,15 @@ sip_ret_t build_session_barge_in(
     CHECK_RET(osip_message_set_content_length(msg, buf));
 
     // 序列化为最终字符串
-    CHECK_RET(osip_message_to_str(msg, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(msg, out_msg, out_len));
     osip_message_free(msg);
     adapter_delete_json_object(root);
+    sip_arena_end();
     return RET_OK;
 
 fail:
     if (msg) osip_message_free(msg);
+    sip_arena_end();
     return RET_ERROR;   
 
 }
@@ -1257,6 +1523,7 @@ sip_ret_t build_bye(received_sip_message_ptr invite, char* uid, char* device_ip,
     snprintf(req_uri_str, sizeof(req_uri_str), "sip:server@%s", SERVER_HOST);
 
     // 开始组装 BYE
+    sip_arena_begin();
     CHECK_RET(osip_message_init(&bye));
 
     // 请求行：BYE {request-uri} SIP/2.0
@@ -1326,13 +1593,14 @@ sip_ret_t build_bye(received_sip_message_ptr invite, char* uid, char* device_ip,
     CHECK_RET(osip_message_set_content_length(bye, osip_strdup("0")));
 
     // 序列化
-    CHECK_RET(osip_message_to_str(bye, out_msg, out_len));
+    CHECK_RET(sip_message_to_str(bye, out_msg, out_len));
     osip_message_free(bye);
     bye = NULL;
     ret = RET_OK;
 
 cleanup:
     if (bye) osip_message_free(bye);
+    sip_arena_end();
     return ret;
 
 fail:
@@ -1341,301 +1609,86 @@ fail:
 }
 
 
-static void *alloc_zeroed(size_t size)
+static void copy_span(char *dst, size_t dst_sz, const sip_span_t *span)
 {
-    void *ptr = malloc(size);
-    if (ptr) {
-        memset(ptr, 0, size);
-    }
-    return ptr;
-}
-
-static system_notification_level_t parse_system_notification_level_value(const char *level)
-{
-    if (!level || level[0] == '\0') {
-        return _INFO_;
-    }
-    if (strcmp(level, "warning") == 0) {
-        return _WARNING_;
-    }
-    if (strcmp(level, "critical") == 0) {
-        return _CRITICAL_;
-    }
-    return _INFO_;
-}
-
-static subscription_status_t parse_subscription_status_value(const char *status)
-{
-    if (!status || status[0] == '\0') {
-        return ACTIVE;
-    }
-    if (strcmp(status, "expired") == 0) {
-        return EXIPIRED;
-    }
-    if (strcmp(status, "trial") == 0) {
-        return TRIAL;
-    }
-    if (strcmp(status, "blocked") == 0) {
-        return BLOCKED;
-    }
-    return ACTIVE;
-}
-
-static device_working_mode_t parse_device_mode_value(const char *mode)
-{
-    if (!mode || mode[0] == '\0') {
-        return EXPLANATION;
-    }
-    if (strcmp(mode, "interaction") == 0) {
-        return INTERACTION;
-    }
-    if (strcmp(mode, "duo") == 0) {
-        return DUO;
-    }
-    if (strcmp(mode, "human_agent") == 0) {
-        return HUMAN_AGENT;
+    size_t n = span->len < dst_sz - 1 ? span->len : dst_sz - 1;
+    if (n > 0) {
+        memcpy(dst, span->ptr, n);
     }
-    return EXPLANATION;
+    dst[n] = '\0';
 }
 
-static device_motion_t parse_device_motion_value(const char *action)
-{
-    if (!action || action[0] == '\0') {
-        return IDLE;
-    }
-    if (strcmp(action, "nod") == 0) {
-        return NOD;
-    }
-    if (strcmp(action, "shake_head") == 0) {
-        return SHAKE_HEAD;
-    }
-    if (strcmp(action, "dance") == 0) {
-        return DANCE;
-    }
-    if (strcmp(action, "wave") == 0) {
-        return WAVE;
-    }
-    if (strcmp(action, "emotion") == 0) {
-        return EMOTION;
-    }
-    if (strcmp(action, "custom") == 0) {
-        return CUSTOM;
-    }
-    if (strcmp(action, "idle") == 0) {
-        return IDLE;
-    }
-    return IDLE;
-}
-
-static device_motion_priority_t parse_device_motion_priority_value(const char *priority)
-{
-    if (!priority || priority[0] == '\0') {
-        return _NORMAL_;
-    }
-    if (strcmp(priority, "low") == 0) {
-        return _LOW_;
-    }
-    if (strcmp(priority, "high") == 0) {
-        return _HIGH_;
-    }
-    if (strcmp(priority, "interrupt") == 0) {
-        return _INTERRUPT_;
-    }
-    return _NORMAL_;
-}
-
-static device_motion_stop_scope_t parse_device_motion_stop_scope_value(const char *scope)
-{
-    if (!scope || scope[0] == '\0') {
-        return ALL;
-    }
-    if (strcmp(scope, "current") == 0) {
-        return CURRENT;
-    }
-    if (strcmp(scope, "type") == 0) {
-        return TYPE;
-    }
-    return ALL;
-}
-
-static float parse_float_value(void *obj, const char *key, float default_value)
+/**
+ * 轻量级解析，头部直接从原始报文拷贝到固定字段，不经过 osip 的解析和重新序列化
+ */
+static sip_ret_t sip_parse_incoming_message_lite(const char *raw_msg, size_t msg_len, received_sip_message_ptr *msg_info)
 {
-    const char *value = adapter_get_json_string_value(obj, key);
-    if (!value || value[0] == '\0') {
-        return default_value;
-    }
-
-    char *end = NULL;
-    float parsed = strtof(value, &end);
-    if (end == value) {
-        return default_value;
-    }
-    return parsed;
-}
-
-
-dcp_cmd_type_t parse_dcp_message(char* data, void** out_param){
-    dcp_cmd_type_t cmd_type = INVALID_CMD;
-    void *parse = NULL;
-    void *params = NULL;
-    const char *name = NULL;
-
-    if (!data || data[0] == '\0' || !out_param) {
-        return INVALID_CMD;
-    }
-
-    *out_param = NULL;
-    parse = adapter_parse_json_string(data);
-    if (!parse) {
-        return INVALID_CMD;
-    }
-
-    name = adapter_get_json_string_value(parse, "name");
-    if (!name || name[0] == '\0') {
-        goto cleanup;
-    }
-    params = adapter_get_json_node_value(parse, "params");
-
-    if (strcmp(name, DCP_AUDIO_INPUT_TEXT) == 0) {
-        data_audio_input_text_ptr text_param = alloc_zeroed(sizeof(data_audio_input_text_t));
-        const char *text = params ? adapter_get_json_string_value(params, "text") : NULL;
-        if (!text_param) {
-            goto cleanup;
-        }
-        if (text) {
-            strncpy(text_param->text, text, sizeof(text_param->text) - 1);
-        }
-        *out_param = text_param;
-        cmd_type = DATA_AUDIO_INPUT_TEXT;
-    } else if (strcmp(name, DCP_AUDIO_OUTPUT_START) == 0) {
-        control_audio_output_state_ptr output_state = alloc_zeroed(sizeof(control_audio_output_state_t));
-        if (!output_state) {
-            goto cleanup;
-        }
-        output_state->state = ON;
-        *out_param = output_state;
-        cmd_type = CONTROL_AUDIO_OUTPUT_STATE;
-    } else if (strcmp(name, DCP_AUDIO_OUTPUT_TEXT) == 0) {
-        data_audio_output_text_ptr output_text = alloc_zeroed(sizeof(data_audio_output_text_t));
-        const char *text = params ? adapter_get_json_string_value(params, "text") : NULL;
-        const char *emotion = params ? adapter_get_json_string_value(params, "emotion") : NULL;
-        if (!output_text) {
-            goto cleanup;
-        }
-        if (text) {
-            strncpy(output_text->text, text, sizeof(output_text->text) - 1);
-        }
-        if (emotion) {
-            strncpy(output_text->emotion, emotion, sizeof(output_text->emotion) - 1);
-        }
-        *out_param = output_text;
-        cmd_type = DATA_AUDIO_OUTPUT_TEXT;
-    } else if (strcmp(name, DCP_AUDIO_OUTPUT_STOP) == 0) {
-        control_audio_output_state_ptr output_state = alloc_zeroed(sizeof(control_audio_output_state_t));
-        if (!output_state) {
-            goto cleanup;
-        }
-        output_state->state = OFF;
-        *out_param = output_state;
-        cmd_type = CONTROL_AUDIO_OUTPUT_STATE;
-    } else if (strcmp(name, DCP_SYSTEM_NOTIFICATION) == 0) {
-        event_system_notification_ptr notification = alloc_zeroed(sizeof(event_system_notification_t));
-        const char *level = params ? adapter_get_json_string_value(params, "level") : NULL;
-        const char *emotion = params ? adapter_get_json_string_value(params, "emotion") : NULL;
-        const char *message = params ? adapter_get_json_string_value(params, "message") : NULL;
-        if (!notification) {
-            goto cleanup;
-        }
-        notification->level = parse_system_notification_level_value(level);
-        if (emotion) {
-            strncpy(notification->emotion, emotion, sizeof(notification->emotion) - 1);
-        }
-        if (message) {
-            strncpy(notification->message, message, sizeof(notification->message) - 1);
-        }
-        *out_param = notification;
-        cmd_type = EVENT_SYSTEM_NOTIFICATION;
-    } else if (strcmp(name, DCP_DEVICE_LIFECYCLE) == 0) {
-        event_device_lifecycle_ptr lifecycle = alloc_zeroed(sizeof(event_device_lifecycle_t));
-        void *capabilities = params ? adapter_get_json_node_value(params, "capabilities") : NULL;
-        const char *subscription = params ? adapter_get_json_string_value(params, "subscription") : NULL;
-        if (!lifecycle) {
-            goto cleanup;
-        }
-        lifecycle->activated = params ? adapter_get_json_int_value(params, "activated", 0) : 0;
-        if (params && lifecycle->activated == 0 && adapter_get_json_boolean_value(params, "activated", false)) {
-            lifecycle->activated = 1;
-        }
-        lifecycle->subscription = parse_subscription_status_value(subscription);
-        if (capabilities) {
-            lifecycle->capabilities.chat = adapter_get_json_int_value(capabilities, "chat", 0);
-            lifecycle->capabilities.vision = adapter_get_json_int_value(capabilities, "vision", 0);
-        }
-        *out_param = lifecycle;
-        cmd_type = EVENT_DEVICE_LIFECYCLE;
-    } else if (strcmp(name, DCP_DEVICE_MODE_SET) == 0) {
-        control_device_mode_set_ptr mode_set = alloc_zeroed(sizeof(control_device_mode_set_t));
-        const char *mode = params ? adapter_get_json_string_value(params, "mode") : NULL;
-        if (!mode_set) {
-            goto cleanup;
-        }
-        mode_set->mode = parse_device_mode_value(mode);
-        *out_param = mode_set;
-        cmd_type = CONTROL_DEVICE_MODE_SET;
-    } else if (strcmp(name, DCP_DEVICE_MOTION_EXECUTE) == 0) {
-        control_device_motion_execute_ptr motion_execute = alloc_zeroed(sizeof(control_device_motion_execute_t));
-        const char *action = params ? adapter_get_json_string_value(params, "action") : NULL;
-        const char *priority = params ? adapter_get_json_string_value(params, "priority") : NULL;
-        if (!motion_execute) {
-            goto cleanup;
-        }
-        motion_execute->action = parse_device_motion_value(action);
-        motion_execute->priority = parse_device_motion_priority_value(priority);
-        motion_execute->repeat = params ? adapter_get_json_int_value(params, "repeat", 0) : 0;
-        motion_execute->speed = params ? parse_float_value(params, "speed", 1.0f) : 1.0f;
-        *out_param = motion_execute;
-        cmd_type = CONTROL_DEVICE_MOTION_EXECUTE;
-    } else if (strcmp(name, DCP_DEVICE_MOTION_STOP) == 0) {
-        control_device_motion_stop_ptr motion_stop = alloc_zeroed(sizeof(control_device_motion_stop_t));
-        const char *scope = params ? adapter_get_json_string_value(params, "scope") : NULL;
-        const char *type = params ? adapter_get_json_string_value(params, "type") : NULL;
-        if (!motion_stop) {
-            goto cleanup;
-        }
-        motion_stop->scope = parse_device_motion_stop_scope_value(scope);
-        motion_stop->type = parse_device_motion_value(type);
-        *out_param = motion_stop;
-        cmd_type = CONTROL_DEVICE_MOTION_STOP;
+    sip_lite_message_t lite;
+    if (sip_lite_parse(raw_msg, msg_len, &lite) != RET_OK) {
+        return RET_ERROR;
     }
 
-cleanup:
-    if (parse) {
-        adapter_delete_json_object(parse);
-    }
-    if (cmd_type == INVALID_CMD && *out_param) {
-        free(*out_param);
-        *out_param = NULL;
+    size_t body_length = lite.body.len;
+    received_sip_message_ptr message = malloc(sizeof(received_sip_message_t) + body_length + 1);
+    if (!message) {
+        return RET_ERROR;
     }
-    return cmd_type;
+    memset(message, 0, sizeof(received_sip_message_t));
+    message->body_length = body_length;
+    memcpy(message->message_body, lite.body.ptr, body_length);
+    message->message_body[body_length] = '\0';
+
+    // 与 osip 路径保持一致: method 取自 CSeq
+    copy_span(message->method, sizeof(message->method), &lite.cseq_method);
+    message->status_code = lite.status_code;
+    copy_span(message->reason_phrase, sizeof(message->reason_phrase), &lite.reason_phrase);
+    copy_span(message->from_header, sizeof(message->from_header), &lite.from);
+    copy_span(message->to_header, sizeof(message->to_header), &lite.to);
+    copy_span(message->via_header, sizeof(message->via_header), &lite.via);
+    copy_span(message->call_id_header, sizeof(message->call_id_header), &lite.call_id);
+    copy_span(message->cseq_header, sizeof(message->cseq_header), &lite.cseq);
+    copy_span(message->contact_header, sizeof(message->contact_header), &lite.contact);
+    message->cseq_num = lite.cseq_num;
+
+    // Call-ID 的 number 部分，即 '@' 之前的内容
+    sip_span_t call_id = lite.call_id;
+    const char *at = memchr(call_id.ptr, '@', call_id.len);
+    if (at) {
+        call_id.len = (size_t)(at - call_id.ptr);
+    }
+    copy_span(message->call_id, sizeof(message->call_id), &call_id);
+
+    // Content-Type 只保留主类型，与 osip 的 content_type->type 一致
+    sip_span_t content_type = lite.content_type;
+    const char *slash = content_type.len ? memchr(content_type.ptr, '/', content_type.len) : NULL;
+    if (slash) {
+        content_type.len = (size_t)(slash - content_type.ptr);
+    }
+    copy_span(message->content_type, sizeof(message->content_type), &content_type);
+
+    if (lite.x_reason_code.len > 0) {
+        char reason[16] = {0};
+        copy_span(reason, sizeof(reason), &lite.x_reason_code);
+        message->x_reason_code = atoi(reason);
+    }
+    copy_span(message->x_envelope, sizeof(message->x_envelope), &lite.x_envelope);
+
+    *msg_info = message;
+    return RET_OK;
 }
 
-
-
-// 收到 SIP 消息时的第一步处理函数
-// 参数：
-//   raw_msg:     原始消息缓冲区
-//   msg_len:     消息长度
-//   msg_info:    输出解析后的消息信息（可为 NULL）
-// 返回：解析结果
-sip_ret_t sip_parse_incoming_message(const char *raw_msg,  size_t msg_len, received_sip_message_ptr *msg_info)
+/**
+ * osip 完整解析，头部经 osip 解析后重新序列化到固定字段，可处理任意合法报文
+ */
+static sip_ret_t sip_parse_incoming_message_osip(const char *raw_msg, size_t msg_len, received_sip_message_ptr *msg_info)
 {
-    if (!raw_msg || msg_len == 0 || !msg_info) {
-        return RET_ERROR;
-    }
+    *msg_info = NULL;
 
+    sip_arena_begin();
     // 初始化 osip 消息结构
     osip_message_t* sip = NULL;
     if (0 != osip_message_init(&sip)) {
+        sip_arena_end();
         return RET_ERROR;
     }
 
@@ -1779,7 +1832,15 @@ sip_ret_t sip_parse_incoming_message(const char *raw_msg,  size_t msg_len, recei
             message->x_reason_code = atoi(reason_header->hvalue);
         }
     } 
+
+    osip_header_t *envelope_header = NULL;
+    if (osip_message_header_get_byname(sip, "x-envelope", 0, &envelope_header) >= 0 &&
+        envelope_header && envelope_header->hvalue) {
+        strncpy(message->x_envelope, envelope_header->hvalue, sizeof(message->x_envelope) - 1);
+    }
     
+    osip_message_free(sip);
+    sip_arena_end();
     return RET_OK;
 
 cleanup:
@@ -1790,11 +1851,34 @@ cleanup:
         free(*msg_info);
         *msg_info = NULL;
     }
+    sip_arena_end();
     return RET_ERROR;
 }
 
+// 收到 SIP 消息时的第一步处理函数
+// 参数：
+//   raw_msg:     原始消息缓冲区
+//   msg_len:     消息长度
+//   msg_info:    输出解析后的消息信息（可为 NULL）
+// 返回：解析结果
+sip_ret_t sip_parse_incoming_message(const char *raw_msg,  size_t msg_len, received_sip_message_ptr *msg_info)
+{
+    if (!raw_msg || msg_len == 0 || !msg_info) {
+        return RET_ERROR;
+    }
+
+#ifdef SIP_USE_LITE_PARSER
+    if (sip_parse_incoming_message_lite(raw_msg, msg_len, msg_info) == RET_OK) {
+        return RET_OK;
+    }
+    LOG_INFO("Lite SIP parser rejected message, falling back to osip");
+#endif
+    return sip_parse_incoming_message_osip(raw_msg, msg_len, msg_info);
+}
+
 void init_sip(void) {
     parser_init();
+    sip_arena_init(SIP_ARENA_SIZE);
 }
 
 
@@ -15,6 +15,8 @@
 #define DCP_REGISTER              "register"
 #define DCP_AUDIO_INPUT_STATE     "audio.input.state"
 #define DCP_AUDIO_INPUT_TEXT      "audio.input.text"
+#define DCP_AUDIO_INPUT_VAD       "audio.input.vad"
+#define DCP_AUDIO_RECEIVE_STATS   "audio.receive.stats"
 #define DCP_AUDIO_OUTPUT_START    "audio.output.start"
 #define DCP_AUDIO_OUTPUT_TEXT     "audio.output.text"
 #define DCP_AUDIO_OUTPUT_STOP     "audio.output.stop"
@@ -50,6 +52,8 @@ typedef struct sip_register_param{
   int cseq_num;
 
   register_param_t register_param; // 注册参数, 包含网络状态、电池状态等, 供build_register构建消息时使用
+
+  int support_binary_envelope; // 是否在 X-Envelope 头部中申请二进制信封
   
 }sip_register_param_t, *sip_register_param_ptr;
 
@@ -107,6 +111,18 @@ typedef struct uplink_sdp_parameter {
   int support_frame_aggregation;
 
   int support_redundant; // 是否支持冗余发送，0表示不支持，1表示支持
+  /**
+   * 上行帧聚合，每个UDP包最多打包的帧数，1表示不聚合
+   */
+  int uplink_aggregation;
+  /**
+   * 是否请求服务端在通话结束后停放媒体会话，0表示不请求，1表示请求
+   */
+  int standby;
+  /**
+   * 恢复的停放通话 Call-ID，没有时传NULL
+   */
+  const char *resume_call_id;
 } uplink_sdp_parameter_t, *uplink_sdp_parameter_ptr;
 
 
@@ -157,6 +173,14 @@ typedef struct downlink_sdp_parameter{
    * AES 128位密钥
    */ 
   uint8_t aes_key[16];
+  /**
+   * 服务端确认的上行帧聚合数，0表示未确认（不聚合）
+   */
+  int uplink_aggregation;
+  /**
+   * 通话结束后服务端停放媒体会话的秒数，0表示不停放
+   */
+  int standby;
 }downlink_sdp_parameter_t, *downlink_sdp_parameter_ptr;
 
 
@@ -201,6 +225,11 @@ typedef struct received_sip_message{
    */
   int x_reason_code;
 
+  /**
+   * X-Envelope 头部，REGISTER 响应中服务端确认的信封格式（如 "binary"），未携带时为空字符串
+   */
+  char x_envelope[16];
+
   /**
    * 原因短语 如 OK, Not Found 等, 如果是request消息则该字段为空字符串
    */
@@ -303,6 +332,13 @@ sip_ret_t build_invite(sip_invite_param_ptr param, char **out_msg, size_t *out_l
 
 sip_ret_t build_ack(received_sip_message_ptr response, const char *uid, const char *device_ip, char **out_msg, size_t *out_len);
 
+/**
+ * INVITE 非 2xx 最终响应的 ACK，属于 INVITE 事务本身，沿用响应中的 Via（RFC 3261 17.1.1.3）
+ */
+sip_ret_t build_non_2xx_ack(received_sip_message_ptr response, const char *uid, const char *device_ip, char **out_msg, size_t *out_len);
+
+sip_ret_t build_cancel(received_sip_message_ptr invite, char **out_msg, size_t *out_len);
+
 sip_ret_t build_bye(received_sip_message_ptr invite, char* uid, char* device_ip, int cseq_num, char** out_msg, size_t* out_len); 
 
 sip_ret_t build_audio_input_state_start(
@@ -323,6 +359,24 @@ sip_ret_t build_audio_input_state_stop(
                char **out_msg,
                size_t *out_len);    
 
+sip_ret_t build_audio_input_vad(
+               received_sip_message_ptr response,
+               const char *uid,
+               const char *device_ip,
+               int cseq_num,
+               event_audio_input_vad_ptr param,
+               char **out_msg,
+               size_t *out_len);
+
+sip_ret_t build_audio_receive_stats(
+               received_sip_message_ptr response,
+               const char *uid,
+               const char *device_ip,
+               int cseq_num,
+               event_audio_receive_stats_ptr param,
+               char **out_msg,
+               size_t *out_len);
+
 sip_ret_t build_session_barge_in(
                received_sip_message_ptr response,
                const char *uid,
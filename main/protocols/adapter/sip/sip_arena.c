@@ -0,0 +1,132 @@
+#include "osipparser2/osip_port.h"
+#include "sip_arena.h"
+#include "string.h"
+#include "stdlib.h"
+
+#define ADAPTER_LOG_TAG    "[SIP-ARENA]"
+#define LOG_LEVEL_ENABLED  LOG_INFO_LEVEL
+#include "adapter/adapter.h"
+
+
+#define ARENA_ALIGN(n)     (((n) + 7) & ~(size_t)7)
+#define ARENA_HEADER_SIZE  ARENA_ALIGN(sizeof(size_t))
+
+static uint8_t *s_arena = NULL;
+static size_t s_arena_size = 0;
+static size_t s_arena_used = 0;
+static void *s_owner = NULL;   // 当前占用内存池的任务
+static int s_depth = 0;        // 只由 s_owner 修改
+static sip_arena_stats_t s_stats = {0};
+
+
+int sip_arena_contains(const void *ptr){
+    return s_arena && (const uint8_t*)ptr >= s_arena && (const uint8_t*)ptr < s_arena + s_arena_size;
+}
+
+static int arena_is_mine(void){
+    void *owner = __atomic_load_n(&s_owner, __ATOMIC_ACQUIRE);
+    return owner != NULL && owner == adapter_get_current_task();
+}
+
+static void *arena_malloc(size_t size){
+    if (arena_is_mine()) {
+        size_t need = ARENA_HEADER_SIZE + ARENA_ALIGN(size);
+        if (s_arena_used + need <= s_arena_size) {
+            uint8_t *block = s_arena + s_arena_used;
+            *(size_t*)block = size;
+            s_arena_used += need;
+            if (s_arena_used > s_stats.high_water_mark) {
+                s_stats.high_water_mark = s_arena_used;
+            }
+            return block + ARENA_HEADER_SIZE;
+        }
+        s_stats.fallback_allocs++;
+    }
+    return malloc(size);
+}
+
+static void arena_free(void *ptr){
+    if (!sip_arena_contains(ptr)) {
+        free(ptr);
+        return;
+    }
+    // 释放的是最后一块时回收，其余等作用域结束统一复位
+    uint8_t *block = (uint8_t*)ptr - ARENA_HEADER_SIZE;
+    size_t size = *(size_t*)block;
+    if (arena_is_mine() && (uint8_t*)ptr + ARENA_ALIGN(size) == s_arena + s_arena_used) {
+        s_arena_used = (size_t)(block - s_arena);
+    }
+}
+
+static void *arena_realloc(void *ptr, size_t size){
+    if (!ptr) {
+        return arena_malloc(size);
+    }
+    if (!sip_arena_contains(ptr)) {
+        return realloc(ptr, size);
+    }
+    size_t old_size = *(size_t*)((uint8_t*)ptr - ARENA_HEADER_SIZE);
+    if (size <= old_size) {
+        return ptr;
+    }
+    // 最后一块且空间足够时原地扩展
+    if (arena_is_mine() && (uint8_t*)ptr + ARENA_ALIGN(old_size) == s_arena + s_arena_used &&
+        (size_t)((uint8_t*)ptr - s_arena) + ARENA_ALIGN(size) <= s_arena_size) {
+        *(size_t*)((uint8_t*)ptr - ARENA_HEADER_SIZE) = size;
+        s_arena_used = (size_t)((uint8_t*)ptr - s_arena) + ARENA_ALIGN(size);
+        if (s_arena_used > s_stats.high_water_mark) {
+            s_stats.high_water_mark = s_arena_used;
+        }
+        return ptr;
+    }
+    void *new_ptr = arena_malloc(size);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, old_size);
+    }
+    return new_ptr;
+}
+
+void sip_arena_init(size_t size){
+    if (s_arena) {
+        return;
+    }
+    s_arena = (uint8_t*)adapter_malloc_large(size);
+    if (!s_arena) {
+        LOG_WARN("Failed to allocate %d bytes for SIP arena, osip uses heap", (int)size);
+        return;
+    }
+    s_arena_size = size;
+    osip_set_allocators(arena_malloc, arena_realloc, arena_free);
+}
+
+void sip_arena_begin(void){
+    if (!s_arena) {
+        return;
+    }
+    void *self = adapter_get_current_task();
+    void *expected = NULL;
+    if (__atomic_compare_exchange_n(&s_owner, &expected, self, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        s_depth = 1;
+        s_arena_used = 0;
+    } else if (expected == self) {
+        s_depth++;
+    }
+}
+
+void sip_arena_end(void){
+    if (!arena_is_mine()) {
+        return;
+    }
+    if (--s_depth > 0) {
+        return;
+    }
+    s_stats.scopes++;
+    s_arena_used = 0;
+    __atomic_store_n(&s_owner, NULL, __ATOMIC_RELEASE);
+}
+
+void get_sip_arena_statistics(sip_arena_stats_ptr stats){
+    if (stats) {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef __SIP_ARENA_H__
+#define __SIP_ARENA_H__
+
+#include "adapter/adapter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * osip 内存池：通过 osip_set_allocators 接管 osip 的内存分配。
+ * 在 sip_arena_begin/sip_arena_end 之间，调用任务的 osip 分配都从内存池中顺序分配，
+ * osip_free 为空操作，sip_arena_end 时整体 O(1) 复位。
+ * 其他任务、作用域之外以及内存池不够时的分配仍走堆，osip_free 按地址区分。
+ */
+void sip_arena_init(size_t size);
+
+/**
+ * 开始一个作用域，可嵌套。内存池已被其他任务占用时本次调用不使用内存池
+ */
+void sip_arena_begin(void);
+
+/**
+ * 结束作用域，最外层结束时复位内存池。作用域内分配的内存在此之后全部失效
+ */
+void sip_arena_end(void);
+
+/**
+ * 判断指针是否位于内存池中
+ */
+int sip_arena_contains(const void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,241 @@
+#include "sip_lite_parser.h"
+#include "string.h"
+#include "strings.h"
+
+
+#define SIP_VERSION_STR     "SIP/2.0"
+#define SIP_VERSION_LEN     7
+
+static const char *s_supported_methods[] = {"INVITE", "MESSAGE", "INFO", "BYE", "REGISTER"};
+
+
+static int span_equals(const sip_span_t *span, const char *str){
+    size_t len = strlen(str);
+    return span->len == len && strncasecmp(span->ptr, str, len) == 0;
+}
+
+static int is_supported_method(const sip_span_t *method){
+    for (size_t i = 0; i < sizeof(s_supported_methods) / sizeof(s_supported_methods[0]); i++) {
+        if (method->len == strlen(s_supported_methods[i]) &&
+            strncmp(method->ptr, s_supported_methods[i], method->len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void span_trim(sip_span_t *span){
+    while (span->len > 0 && (span->ptr[0] == ' ' || span->ptr[0] == '\t')) {
+        span->ptr++;
+        span->len--;
+    }
+    while (span->len > 0 && (span->ptr[span->len - 1] == ' ' || span->ptr[span->len - 1] == '\t')) {
+        span->len--;
+    }
+}
+
+/**
+ * 解析非负十进制整数，整个片段都必须是数字
+ */
+static int span_to_int(const sip_span_t *span, int *out){
+    if (span->len == 0 || span->len > 9) {
+        return 0;
+    }
+    int val = 0;
+    for (size_t i = 0; i < span->len; i++) {
+        if (span->ptr[i] < '0' || span->ptr[i] > '9') {
+            return 0;
+        }
+        val = val * 10 + (span->ptr[i] - '0');
+    }
+    *out = val;
+    return 1;
+}
+
+/**
+ * 查找下一个 CRLF，返回行长度（不含 CRLF），找不到返回 -1
+ */
+static long find_line_end(const char *p, const char *end){
+    const char *cr = p;
+    while (cr + 1 < end) {
+        cr = memchr(cr, '\r', (size_t)(end - cr - 1));
+        if (!cr) {
+            return -1;
+        }
+        if (cr[1] == '\n') {
+            return (long)(cr - p);
+        }
+        cr++;
+    }
+    return -1;
+}
+
+/**
+ * 行内出现单独的 CR 或 LF 时 osip 会按行尾处理，交给 osip
+ */
+static int has_bare_line_break(const char *p, size_t len){
+    return memchr(p, '\r', len) != NULL || memchr(p, '\n', len) != NULL;
+}
+
+/**
+ * Via 头部中逗号分隔的多个值需要 osip 处理，引号内的逗号除外
+ */
+static int has_multiple_values(const sip_span_t *span){
+    int quoted = 0;
+    for (size_t i = 0; i < span->len; i++) {
+        if (span->ptr[i] == '"') {
+            quoted = !quoted;
+        } else if (span->ptr[i] == ',' && !quoted) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static sip_ret_t parse_start_line(const char *line, size_t len, sip_lite_message_ptr out){
+    sip_span_t first = {line, 0};
+    const char *sp = memchr(line, ' ', len);
+    if (!sp) {
+        return RET_ERROR;
+    }
+    first.len = (size_t)(sp - line);
+
+    if (first.len == SIP_VERSION_LEN && strncmp(line, SIP_VERSION_STR, SIP_VERSION_LEN) == 0) {
+        // 响应: SIP/2.0 200 OK
+        const char *code = sp + 1;
+        size_t rest = len - (size_t)(code - line);
+        const char *sp2 = memchr(code, ' ', rest);
+        sip_span_t code_span = {code, sp2 ? (size_t)(sp2 - code) : rest};
+        if (code_span.len != 3 || !span_to_int(&code_span, &out->status_code) || out->status_code < 100) {
+            return RET_ERROR;
+        }
+        if (sp2) {
+            out->reason_phrase.ptr = sp2 + 1;
+            out->reason_phrase.len = len - (size_t)(sp2 + 1 - line);
+        }
+        return RET_OK;
+    }
+
+    // 请求: METHOD uri SIP/2.0
+    if (len < first.len + 1 + SIP_VERSION_LEN + 1 ||
+        strncmp(line + len - SIP_VERSION_LEN, SIP_VERSION_STR, SIP_VERSION_LEN) != 0 ||
+        line[len - SIP_VERSION_LEN - 1] != ' ') {
+        return RET_ERROR;
+    }
+    out->method = first;
+    out->status_code = 0;
+    return is_supported_method(&out->method) ? RET_OK : RET_ERROR;
+}
+
+sip_ret_t sip_lite_parse(const char *raw_msg, size_t msg_len, sip_lite_message_ptr out){
+    if (!raw_msg || msg_len == 0 || !out) {
+        return RET_ERROR;
+    }
+    memset(out, 0, sizeof(*out));
+
+    const char *p = raw_msg;
+    const char *end = raw_msg + msg_len;
+
+    long line_len = find_line_end(p, end);
+    if (line_len <= 0 || has_bare_line_break(p, (size_t)line_len) ||
+        parse_start_line(p, (size_t)line_len, out) != RET_OK) {
+        return RET_ERROR;
+    }
+    p += line_len + 2;
+
+    int content_length = -1;
+    while (1) {
+        line_len = find_line_end(p, end);
+        if (line_len < 0) {
+            return RET_ERROR;
+        }
+        if (line_len == 0) {
+            // 空行，头部结束
+            p += 2;
+            break;
+        }
+        // 头部折行需要 osip 处理
+        if (p[0] == ' ' || p[0] == '\t' || has_bare_line_break(p, (size_t)line_len)) {
+            return RET_ERROR;
+        }
+        const char *colon = memchr(p, ':', (size_t)line_len);
+        if (!colon) {
+            return RET_ERROR;
+        }
+        sip_span_t name = {p, (size_t)(colon - p)};
+        sip_span_t value = {colon + 1, (size_t)(p + line_len - colon - 1)};
+        span_trim(&name);
+        span_trim(&value);
+
+        if (span_equals(&name, "Via") || span_equals(&name, "v")) {
+            if (has_multiple_values(&value)) {
+                return RET_ERROR;
+            }
+            // 只保留第一个 Via
+            if (!out->via.ptr) {
+                out->via = value;
+            }
+        } else if (span_equals(&name, "From") || span_equals(&name, "f")) {
+            out->from = value;
+        } else if (span_equals(&name, "To") || span_equals(&name, "t")) {
+            out->to = value;
+        } else if (span_equals(&name, "Call-ID") || span_equals(&name, "i")) {
+            out->call_id = value;
+        } else if (span_equals(&name, "CSeq")) {
+            out->cseq = value;
+        } else if (span_equals(&name, "Contact") || span_equals(&name, "m")) {
+            if (!out->contact.ptr) {
+                out->contact = value;
+            }
+        } else if (span_equals(&name, "Content-Type") || span_equals(&name, "c")) {
+            out->content_type = value;
+        } else if (span_equals(&name, "Content-Length") || span_equals(&name, "l")) {
+            if (!span_to_int(&value, &content_length)) {
+                return RET_ERROR;
+            }
+        } else if (span_equals(&name, "x-reason-code")) {
+            out->x_reason_code = value;
+        } else if (span_equals(&name, "x-envelope")) {
+            out->x_envelope = value;
+        }
+        p += line_len + 2;
+    }
+
+    if (!out->call_id.len || !out->cseq.len || !out->from.len || !out->to.len) {
+        return RET_ERROR;
+    }
+    // Call-ID 不允许空白，带空白的非法值按 osip 的规则处理
+    if (memchr(out->call_id.ptr, ' ', out->call_id.len) || memchr(out->call_id.ptr, '\t', out->call_id.len)) {
+        return RET_ERROR;
+    }
+
+    // CSeq: 序号 方法
+    const char *sp = memchr(out->cseq.ptr, ' ', out->cseq.len);
+    if (!sp) {
+        return RET_ERROR;
+    }
+    sip_span_t num = {out->cseq.ptr, (size_t)(sp - out->cseq.ptr)};
+    out->cseq_method.ptr = sp + 1;
+    out->cseq_method.len = out->cseq.len - num.len - 1;
+    span_trim(&out->cseq_method);
+    if (!span_to_int(&num, &out->cseq_num) || !is_supported_method(&out->cseq_method)) {
+        return RET_ERROR;
+    }
+    // 请求行与 CSeq 的方法必须一致
+    if (out->status_code == 0 &&
+        (out->method.len != out->cseq_method.len ||
+         strncmp(out->method.ptr, out->cseq_method.ptr, out->method.len) != 0)) {
+        return RET_ERROR;
+    }
+
+    size_t remain = (size_t)(end - p);
+    if (content_length >= 0) {
+        if ((size_t)content_length > remain) {
+            return RET_ERROR;
+        }
+        remain = (size_t)content_length;
+    }
+    out->body.ptr = p;
+    out->body.len = remain;
+    return RET_OK;
+}
@@ -0,0 +1,65 @@
+#ifndef __SIP_LITE_PARSER_H__
+#define __SIP_LITE_PARSER_H__
+
+#include "adapter/adapter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 指向原始报文的只读片段，不以'\0'结尾
+ */
+typedef struct {
+  const char *ptr;
+  size_t len;
+} sip_span_t;
+
+/**
+ * 轻量级解析结果，所有字段都指向原始报文，原始报文在使用期间必须保持有效
+ */
+typedef struct {
+  /**
+   * 请求方法，响应消息为空
+   */
+  sip_span_t method;
+  /**
+   * 状态码，请求消息为0
+   */
+  int status_code;
+  sip_span_t reason_phrase;
+
+  sip_span_t from;
+  sip_span_t to;
+  /**
+   * 第一个 Via 头部
+   */
+  sip_span_t via;
+  sip_span_t call_id;
+  sip_span_t cseq;
+  sip_span_t contact;
+  sip_span_t content_type;
+  sip_span_t x_reason_code;
+  sip_span_t x_envelope;
+
+  /**
+   * CSeq 中的序号和方法
+   */
+  int cseq_num;
+  sip_span_t cseq_method;
+
+  sip_span_t body;
+} sip_lite_message_t, *sip_lite_message_ptr;
+
+/**
+ * 只解析设备实际处理的 INVITE/MESSAGE/INFO/BYE/REGISTER 请求及其响应，
+ * 不复制、不分配内存。遇到不支持的写法（头部折行、多值 Via、其他方法等）返回 RET_ERROR，
+ * 由调用方退回到 osip 完整解析
+ */
+sip_ret_t sip_lite_parse(const char *raw_msg, size_t msg_len, sip_lite_message_ptr out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,14 +5,13 @@
 
 #include <esp_log.h>
 #include <cstring>
+#include <algorithm>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
 #define TAG "MQTT"
 
 MqttProtocol::MqttProtocol() {
-    event_group_handle_ = xEventGroupCreate();
-
     // Initialize reconnect timer
     esp_timer_create_args_t reconnect_timer_args = {
         .callback = [](void* arg) {
@@ -31,6 +30,55 @@ MqttProtocol::MqttProtocol() {
         .arg = this,
     };
     esp_timer_create(&reconnect_timer_args, &reconnect_timer_);
+
+    // Session timer fires when the server does not answer the session request in time
+    esp_timer_create_args_t session_timer_args = {
+        .callback = [](void* arg) {
+            MqttProtocol* protocol = (MqttProtocol*)arg;
+            auto alive = protocol->alive_;  // Capture alive flag
+            Application::GetInstance().Schedule([protocol, alive]() {
+                if (*alive && protocol->session_pending_) {
+                    ESP_LOGE(TAG, "Failed to receive server hello");
+                    protocol->SendCancelCall();
+                    protocol->SetError(Lang::Strings::SERVER_TIMEOUT);
+                    protocol->FinishSession(false);
+                }
+            });
+        },
+        .arg = this,
+        .name = "session_timer",
+    };
+    esp_timer_create(&session_timer_args, &session_timer_);
+
+    // Aggregation timer caps the latency of frames waiting for a full uplink datagram
+    esp_timer_create_args_t aggregation_timer_args = {
+        .callback = [](void* arg) {
+            MqttProtocol* protocol = (MqttProtocol*)arg;
+            std::lock_guard<std::mutex> lock(protocol->channel_mutex_);
+            if (protocol->pending_frames_ > 0) {
+                protocol->FlushAudio();
+            }
+        },
+        .arg = this,
+        .name = "aggregation_timer",
+    };
+    esp_timer_create(&aggregation_timer_args, &aggregation_timer_);
+
+    // Stats timer reports the incoming audio quality periodically while the channel is open
+    esp_timer_create_args_t stats_timer_args = {
+        .callback = [](void* arg) {
+            MqttProtocol* protocol = (MqttProtocol*)arg;
+            auto alive = protocol->alive_;  // Capture alive flag
+            Application::GetInstance().Schedule([protocol, alive]() {
+                if (*alive) {
+                    protocol->ReportAudioStatistics();
+                }
+            });
+        },
+        .arg = this,
+        .name = "audio_stats_timer",
+    };
+    esp_timer_create(&stats_timer_args, &stats_timer_);
 }
 
 MqttProtocol::~MqttProtocol() {
@@ -43,13 +91,21 @@ MqttProtocol::~MqttProtocol() {
         esp_timer_stop(reconnect_timer_);
         esp_timer_delete(reconnect_timer_);
     }
+    if (session_timer_ != nullptr) {
+        esp_timer_stop(session_timer_);
+        esp_timer_delete(session_timer_);
+    }
+    if (aggregation_timer_ != nullptr) {
+        esp_timer_stop(aggregation_timer_);
+        esp_timer_delete(aggregation_timer_);
+    }
+    if (stats_timer_ != nullptr) {
+        esp_timer_stop(stats_timer_);
+        esp_timer_delete(stats_timer_);
+    }
 
     udp_.reset();
     mqtt_.reset();
-    
-    if (event_group_handle_ != nullptr) {
-        vEventGroupDelete(event_group_handle_);
-    }
 }
 
 bool MqttProtocol::Start(bool report_error) {
@@ -131,7 +187,7 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
                 if (event == DEVICE_STATUS_MEMBER_SHIP_EXPIRED) {
                     ESP_LOGW(TAG, "Received server alert event");
                     SetError(Lang::Strings::DEVICE_MEMBERSHIP_EXPIRED);
-                    xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_ALERT_EVENT);
+                    OnSessionAnswered(false);
                 }
                 
             }
@@ -184,28 +240,73 @@ bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         return false;
     }
 
-    std::string nonce(aes_nonce_);
+    uint8_t nonce[16];
+    memcpy(nonce, aes_nonce_.data(), sizeof(nonce));
     *(uint16_t*)&nonce[2] = htons(packet->payload.size());
     //*(uint32_t*)&nonce[8] = htonl(packet.timestamp);
     *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
 
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + packet->payload.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
+    // The header goes into the reused datagram buffer, and the payload is encrypted right behind it,
+    // so no heap allocation is needed once the buffer has grown to the frame size.
+    // With uplink aggregation, several [header|payload] frames are appended to the same datagram.
+    if (pending_frames_ == 0) {
+        send_buffer_.clear();
+    }
+    size_t offset = send_buffer_.size();
+    send_buffer_.resize(offset + sizeof(nonce) + packet->payload.size());
+    memcpy(&send_buffer_[offset], nonce, sizeof(nonce));
 
     size_t nc_off = 0;
     uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet->payload.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)packet->payload.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, packet->payload.size(), &nc_off, nonce, stream_block,
+        packet->payload.data(), (uint8_t*)&send_buffer_[offset + sizeof(nonce)]);
+    AudioPacketPool::Release(std::move(packet));
+    if (ret != 0) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
+        send_buffer_.resize(offset);
         return false;
     }
-    return udp_->Send(encrypted) > 0;
+
+    // Never hold more frames than the latency cap allows, whatever the server accepted
+    int max_frames = std::min(uplink_aggregation_, 1 + MQTT_UPLINK_AGGREGATION_MAX_DELAY_MS / OPUS_FRAME_DURATION_MS);
+    if (++pending_frames_ < max_frames) {
+        if (pending_frames_ == 1) {
+            esp_timer_start_once(aggregation_timer_, MQTT_UPLINK_AGGREGATION_MAX_DELAY_MS * 1000);
+        }
+        return true;
+    }
+    return FlushAudio();
+}
+
+// Must be called with channel_mutex_ held
+bool MqttProtocol::FlushAudio() {
+    esp_timer_stop(aggregation_timer_);
+    pending_frames_ = 0;
+    if (udp_ == nullptr || send_buffer_.empty()) {
+        return false;
+    }
+    if (udp_->Send(send_buffer_) <= 0) {
+        return false;
+    }
+    if (first_uplink_pending_) {
+        first_uplink_pending_ = false;
+        ESP_LOGI(TAG, "First uplink packet %d ms after wake",
+            (int)((esp_timer_get_time() - session_start_time_) / 1000));
+    }
+    return true;
 }
 
 void MqttProtocol::CloseAudioChannel(bool notify_server) {
+    esp_timer_stop(stats_timer_);
+    if (notify_server) {
+        // Final report of the session, must go out before the call is finished
+        ReportAudioStatistics();
+    }
     {
         std::lock_guard<std::mutex> lock(channel_mutex_);
+        if (pending_frames_ > 0) {
+            FlushAudio();
+        }
         udp_.reset();
     }
     
@@ -221,6 +322,15 @@ void MqttProtocol::CloseAudioChannel(bool notify_server) {
 
 bool MqttProtocol::OpenAudioChannel() {
     std::lock_guard<std::mutex> lock(channel_mutex_);
+    esp_timer_stop(aggregation_timer_);
+    pending_frames_ = 0;
+    {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        replay_window_ = 0;
+        receive_statistics_ = AudioReceiveStatistics();
+        last_transit_ms_ = 0;
+        jitter_q4_ = 0;
+    }
     auto network = Board::GetInstance().GetNetwork();
     udp_ = network->CreateUdp(2);
     udp_->OnMessage([this](const std::string& data) {
@@ -249,20 +359,16 @@ bool MqttProtocol::OpenAudioChannel() {
                 break;
             }
 
-            if (sequence < remote_sequence_) {
-                ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
+            if (!AcceptRemoteSequence(sequence)) {
                 offset += aes_nonce_.size() + payload_len;
                 continue;
             }
-            if (sequence != remote_sequence_ + 1) {
-                ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
-            }
 
             size_t nc_off = 0;
             uint8_t stream_block[16] = {0};
             auto nonce = (uint8_t*)data.data() + offset;
             auto encrypted = (uint8_t*)data.data() + offset + aes_nonce_.size();
-            auto packet = std::make_unique<AudioStreamPacket>();
+            auto packet = AudioPacketPool::Acquire();
             packet->sample_rate = server_sample_rate_;
             packet->frame_duration = server_frame_duration_;
             packet->timestamp = timestamp;
@@ -287,13 +393,14 @@ bool MqttProtocol::OpenAudioChannel() {
             if (on_incoming_audio_ != nullptr) {
                 on_incoming_audio_(std::move(packet));
             }
-            remote_sequence_ = sequence;
             last_incoming_time_ = std::chrono::steady_clock::now();
             offset += aes_nonce_.size() + payload_len;
         }
     });
 
     udp_->Connect(udp_server_, udp_port_);
+    esp_timer_stop(stats_timer_);
+    esp_timer_start_periodic(stats_timer_, (uint64_t)MQTT_AUDIO_STATS_INTERVAL_SECONDS * 1000000);
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
@@ -302,6 +409,101 @@ bool MqttProtocol::OpenAudioChannel() {
     return true;
 }
 
+// New keys restart the incoming sequence, the UDP task may be checking frames concurrently
+void MqttProtocol::ResetRemoteSequence() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    remote_sequence_ = 0;
+    replay_window_ = 0;
+}
+
+// Called from the UDP receive task, returns false for duplicated or too old frames
+bool MqttProtocol::AcceptRemoteSequence(uint32_t sequence) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    auto& stats = receive_statistics_;
+    if (replay_window_ == 0 || sequence > remote_sequence_) {
+        uint32_t shift = replay_window_ == 0 ? 1 : sequence - remote_sequence_;
+        if (replay_window_ != 0 && shift > 1) {
+            ESP_LOGD(TAG, "Audio sequence gap: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            stats.lost += shift - 1;
+        }
+        replay_window_ = shift >= MQTT_REPLAY_WINDOW_SIZE ? 1 : (replay_window_ << shift) | 1;
+        remote_sequence_ = sequence;
+
+        // RFC 3550 jitter, the expected send time of a frame is derived from its sequence
+        int32_t arrival_ms = (int32_t)(esp_timer_get_time() / 1000);
+        int32_t transit_ms = arrival_ms - (int32_t)(sequence * server_frame_duration_);
+        if (stats.received > 0) {
+            int32_t d = transit_ms - last_transit_ms_;
+            if (d < 0) {
+                d = -d;
+            }
+            jitter_q4_ += d - ((jitter_q4_ + 8) >> 4);
+            stats.jitter_ms = jitter_q4_ >> 4;
+        }
+        last_transit_ms_ = transit_ms;
+        stats.received++;
+        return true;
+    }
+
+    uint32_t depth = remote_sequence_ - sequence;
+    if (depth >= MQTT_REPLAY_WINDOW_SIZE) {
+        ESP_LOGD(TAG, "Audio packet too old: %lu, newest: %lu", sequence, remote_sequence_);
+        stats.too_old++;
+        return false;
+    }
+    uint64_t bit = 1ULL << depth;
+    if (replay_window_ & bit) {
+        ESP_LOGD(TAG, "Duplicated audio packet: %lu", sequence);
+        stats.duplicates++;
+        return false;
+    }
+    // Late but unseen, it fills a gap counted as lost before
+    replay_window_ |= bit;
+    stats.reordered++;
+    if (stats.lost > 0) {
+        stats.lost--;
+    }
+    if (depth > stats.max_reorder_depth) {
+        stats.max_reorder_depth = depth;
+    }
+    stats.received++;
+    return true;
+}
+
+void MqttProtocol::ReportAudioStatistics() {
+    AudioReceiveStatistics stats;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats = receive_statistics_;
+    }
+    if (stats.received == 0 || session_id_.empty()) {
+        return;
+    }
+    ESP_LOGI(TAG, "Audio rx: received %lu, lost %lu, dup %lu, too old %lu, reordered %lu (max %lu), jitter %lu ms",
+        stats.received, stats.lost, stats.duplicates, stats.too_old, stats.reordered,
+        stats.max_reorder_depth, stats.jitter_ms);
+    SendAudioStatistics(stats);
+}
+
+void MqttProtocol::SendAudioStatistics(const AudioReceiveStatistics& stats) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "session_id", session_id_.c_str());
+    cJSON_AddStringToObject(root, "type", "audio_stats");
+    cJSON_AddStringToObject(root, "network", Board::GetInstance().GetBoardType().c_str());
+    cJSON_AddNumberToObject(root, "received", stats.received);
+    cJSON_AddNumberToObject(root, "lost", stats.lost);
+    cJSON_AddNumberToObject(root, "duplicates", stats.duplicates);
+    cJSON_AddNumberToObject(root, "too_old", stats.too_old);
+    cJSON_AddNumberToObject(root, "reordered", stats.reordered);
+    cJSON_AddNumberToObject(root, "max_reorder_depth", stats.max_reorder_depth);
+    cJSON_AddNumberToObject(root, "jitter_ms", stats.jitter_ms);
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string message(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    SendText(message);
+}
+
 bool MqttProtocol::OriginateSession(const std::string& wakeWord) {
     if (mqtt_ == nullptr || !mqtt_->IsConnected()) {
         ESP_LOGI(TAG, "MQTT is not connected, try to connect now");
@@ -312,30 +514,65 @@ bool MqttProtocol::OriginateSession(const std::string& wakeWord) {
 
     error_occurred_ = false;
     session_id_ = "";
-
-    xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT|MQTT_PROTOCOL_SERVER_ALERT_EVENT);
+    session_start_time_ = esp_timer_get_time();
+    session_pending_ = true;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        first_uplink_pending_ = true;
+    }
 
     if (!SendInitCall(wakeWord)) {
+        session_pending_ = false;
         return false;
     }
 
-    // 等待服务器响应
-    EventBits_t bits = xEventGroupWaitBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT|MQTT_PROTOCOL_SERVER_ALERT_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
-    if (bits & MQTT_PROTOCOL_SERVER_ALERT_EVENT) {
-        ESP_LOGE(TAG, "Received server alert");
-        return false;
+    // 不在此处等待服务器响应，结果由 OnSessionAnswered 或超时定时器通知
+    Settings settings("mqtt", false);
+    int timeout_seconds = settings.GetInt("session_timeout", MQTT_SESSION_TIMEOUT_SECONDS);
+    esp_timer_stop(session_timer_);
+    esp_timer_start_once(session_timer_, (uint64_t)timeout_seconds * 1000000);
+    return true;
+}
+
+void MqttProtocol::CancelSession() {
+    if (!session_pending_) {
+        return;
     }
-    if (!(bits & MQTT_PROTOCOL_SERVER_HELLO_EVENT)) {
-        ESP_LOGE(TAG, "Failed to receive server hello");
-        SetError(Lang::Strings::SERVER_TIMEOUT);
-        return false;
+    ESP_LOGI(TAG, "Cancel pending session");
+    session_pending_ = false;
+    esp_timer_stop(session_timer_);
+    SendCancelCall();
+}
+
+void MqttProtocol::OnSessionAnswered(bool success) {
+    // Called from the MQTT task, the audio channel is opened in the main task
+    auto alive = alive_;  // Capture alive flag
+    Application::GetInstance().Schedule([this, alive, success]() {
+        if (*alive) {
+            FinishSession(success);
+        }
+    });
+}
+
+void MqttProtocol::FinishSession(bool success) {
+    if (!session_pending_) {
+        // Cancelled or timed out
+        return;
     }
+    session_pending_ = false;
+    esp_timer_stop(session_timer_);
 
-    this->OpenAudioChannel();
-    return true;
+    if (success) {
+        success = OpenAudioChannel();
+    }
+    ESP_LOGI(TAG, "Session %s in %d ms", success ? "established" : "failed",
+        (int)((esp_timer_get_time() - session_start_time_) / 1000));
+    if (on_session_originated_ != nullptr) {
+        on_session_originated_(success);
+    }
 }
 
-std::string MqttProtocol::GetHelloMessage() {
+std::string MqttProtocol::GetHelloMessage(const std::string& ticket, uint32_t epoch) {
     // 发送 hello 消息申请 UDP 通道
     cJSON* root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "type", "hello");
@@ -346,12 +583,24 @@ std::string MqttProtocol::GetHelloMessage() {
     cJSON_AddBoolToObject(features, "aec", true);
 #endif
     cJSON_AddBoolToObject(features, "mcp", true);
+    if (MQTT_SESSION_RESUMPTION) {
+        cJSON_AddBoolToObject(features, "resume", true);
+    }
     cJSON_AddItemToObject(root, "features", features);
+    if (!ticket.empty()) {
+        cJSON* resume = cJSON_CreateObject();
+        cJSON_AddStringToObject(resume, "ticket", ticket.c_str());
+        cJSON_AddNumberToObject(resume, "epoch", epoch);
+        cJSON_AddItemToObject(root, "resume", resume);
+    }
     cJSON* audio_params = cJSON_CreateObject();
     cJSON_AddStringToObject(audio_params, "format", "opus");
     cJSON_AddNumberToObject(audio_params, "sample_rate", 16000);
     cJSON_AddNumberToObject(audio_params, "channels", 1);
     cJSON_AddNumberToObject(audio_params, "frame_duration", OPUS_FRAME_DURATION_MS);
+    if (MQTT_UPLINK_FRAME_AGGREGATION > 1) {
+        cJSON_AddNumberToObject(audio_params, "uplink_aggregation", MQTT_UPLINK_FRAME_AGGREGATION);
+    }
     cJSON_AddItemToObject(root, "audio_params", audio_params);
     auto json_str = cJSON_PrintUnformatted(root);
     std::string message(json_str);
@@ -373,7 +622,33 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
         ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
     }
 
+    ResumeState resume_state;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        resume_state = resume_state_;
+        resume_state_ = kResumeNone;
+    }
+    if (resume_state == kResumePending) {
+        if (cJSON_IsTrue(cJSON_GetObjectItem(root, "resumed"))) {
+            ESP_LOGI(TAG, "Session resumed, epoch %lu", resume_epoch_);
+            ParseResumeTicket(root);
+            return;
+        }
+        // The audio is already flowing on the cached keys, the new ones come with a full hello
+        ESP_LOGW(TAG, "Session resumption rejected, falling back to full hello");
+        if (!cJSON_IsObject(cJSON_GetObjectItem(root, "udp"))) {
+            {
+                std::lock_guard<std::mutex> lock(channel_mutex_);
+                resume_state_ = kResumeFallback;
+            }
+            SendText(GetHelloMessage());
+            return;
+        }
+        resume_state = kResumeFallback;
+    }
+
     // Get sample rate from hello message
+    uplink_aggregation_ = 1;
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
     if (cJSON_IsObject(audio_params)) {
         auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
@@ -384,6 +659,11 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
         if (cJSON_IsNumber(frame_duration)) {
             server_frame_duration_ = frame_duration->valueint;
         }
+        // 服务端确认的上行聚合帧数，不超过本端请求的值
+        auto uplink_aggregation = cJSON_GetObjectItem(audio_params, "uplink_aggregation");
+        if (cJSON_IsNumber(uplink_aggregation)) {
+            uplink_aggregation_ = std::max(1, std::min(uplink_aggregation->valueint, MQTT_UPLINK_FRAME_AGGREGATION));
+        }
     }
 
     auto udp = cJSON_GetObjectItem(root, "udp");
@@ -398,12 +678,82 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
 
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     ESP_LOGI(TAG, "UDP server: %s, port: %d", udp_server_.c_str(), udp_port_);
-    aes_nonce_ = DecodeHexString(nonce);
-    mbedtls_aes_init(&aes_ctx_);
-    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
-    local_sequence_ = 0;
-    remote_sequence_ = 0;
-    xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        aes_nonce_ = DecodeHexString(nonce);
+        mbedtls_aes_init(&aes_ctx_);
+        mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
+        local_sequence_ = 0;
+        ResetRemoteSequence();
+        resume_nonce_ = aes_nonce_;
+        resume_epoch_ = 0;
+    }
+    ParseResumeTicket(root);
+
+    if (resume_state == kResumeFallback) {
+        auto alive = alive_;  // Capture alive flag
+        Application::GetInstance().Schedule([this, alive]() {
+            if (*alive && IsAudioChannelOpened()) {
+                OpenAudioChannel();
+            }
+        });
+        return;
+    }
+    OnSessionAnswered(true);
+}
+
+void MqttProtocol::ParseResumeTicket(const cJSON* root) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    resume_ticket_.clear();
+    auto resume = cJSON_GetObjectItem(root, "resume");
+    if (!MQTT_SESSION_RESUMPTION || !cJSON_IsObject(resume)) {
+        return;
+    }
+    auto ticket = cJSON_GetObjectItem(resume, "ticket");
+    auto ttl = cJSON_GetObjectItem(resume, "ttl");
+    if (cJSON_IsString(ticket) && cJSON_IsNumber(ttl) && ttl->valueint > 0) {
+        resume_ticket_ = ticket->valuestring;
+        resume_expire_time_ = esp_timer_get_time() + (int64_t)ttl->valueint * 1000000;
+    }
+}
+
+// Reopens the channel with the keys of the last full hello and a new nonce epoch. The server
+// answers the resume hello later, a rejection falls back to a full hello and re-keys the channel
+bool MqttProtocol::ResumeSession() {
+    std::string message;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        if (resume_ticket_.empty()) {
+            return false;
+        }
+        if (esp_timer_get_time() >= resume_expire_time_) {
+            ESP_LOGI(TAG, "Resumption ticket expired");
+            resume_ticket_.clear();
+            return false;
+        }
+        resume_epoch_++;
+        message = GetHelloMessage(resume_ticket_, resume_epoch_);
+        resume_ticket_.clear();
+
+        // Sequences restart for every epoch, the epoch keeps the counter blocks unique
+        aes_nonce_ = resume_nonce_;
+        uint32_t ssrc;
+        memcpy(&ssrc, &aes_nonce_[4], sizeof(ssrc));
+        ssrc ^= htonl(resume_epoch_);
+        memcpy(&aes_nonce_[4], &ssrc, sizeof(ssrc));
+        local_sequence_ = 0;
+        ResetRemoteSequence();
+        resume_state_ = kResumePending;
+    }
+
+    ESP_LOGI(TAG, "Resuming session %s, epoch %lu", session_id_.c_str(), resume_epoch_);
+    if (!SendText(message)) {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        resume_state_ = kResumeNone;
+        return false;
+    }
+    OnSessionAnswered(true);
+    return true;
 }
 
 static const char hex_chars[] = "0123456789ABCDEF";
@@ -434,6 +784,9 @@ Mqtt& MqttProtocol::getMqtt(){
 }
 
 bool MqttProtocol::SendInitCall(const std::string& wakeWord){
+    if (ResumeSession()) {
+        return true;
+    }
     ESP_LOGI(TAG, "@@@@@@Sending init call on Hello Message@@@@@@");
     auto message = GetHelloMessage();
     if (!SendText(message)) {
@@ -449,4 +802,9 @@ bool MqttProtocol::SendFinishCall(){
     message += "\"type\":\"goodbye\"";
     message += "}";
     return SendText(message);
+}
+
+bool MqttProtocol::SendCancelCall() {
+    // The server may already have allocated a session for the hello, release it
+    return SendFinishCall();
 }
\ No newline at end of file
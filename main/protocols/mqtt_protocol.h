@@ -20,14 +20,34 @@
 
 #define MQTT_PING_INTERVAL_SECONDS 90
 #define MQTT_RECONNECT_INTERVAL_MS 60000
+// 会话建立超时，可由 mqtt 配置中的 session_timeout（秒）覆盖
+#define MQTT_SESSION_TIMEOUT_SECONDS 10
+// 上行帧聚合：每个 UDP 包最多打包的帧数（1 表示不聚合），实际帧数以服务端 hello 确认为准
+#define MQTT_UPLINK_FRAME_AGGREGATION 1
+// 聚合时首帧最长等待时间，超时后不足 N 帧也立即发送
+#define MQTT_UPLINK_AGGREGATION_MAX_DELAY_MS 150
+// 下行音频接收统计上报间隔
+#define MQTT_AUDIO_STATS_INTERVAL_SECONDS 30
+// 防重放窗口大小（位图位数）
+#define MQTT_REPLAY_WINDOW_SIZE 64
+// 会话恢复：hello 中声明支持，服务端下发票据后，有效期内的下一轮对话直接用缓存的密钥开流，不等待服务端 hello
+#define MQTT_SESSION_RESUMPTION 1
 
 #define DEVICE_STATUS_MEMBER_SHIP_EXPIRED 1
 #define DEVICE_STATUS_ACTIVATED 2
 
-#define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
-#define MQTT_PROTOCOL_SERVER_ALERT_EVENT (1 << 1)
 
 
+// Per-session statistics of the incoming UDP audio
+struct AudioReceiveStatistics {
+    uint32_t received = 0;           // Frames accepted by the replay window
+    uint32_t lost = 0;               // Sequence gaps not filled by late frames
+    uint32_t duplicates = 0;         // Frames already seen inside the window
+    uint32_t too_old = 0;            // Frames behind the window, dropped
+    uint32_t reordered = 0;          // Late frames accepted inside the window
+    uint32_t max_reorder_depth = 0;  // Largest distance of a late frame behind the newest one
+    uint32_t jitter_ms = 0;          // RFC 3550 interarrival jitter
+};
 
 class MqttProtocol : public Protocol {
 public:
@@ -37,23 +57,30 @@ public:
     bool Start(bool report_error = false) override;
     bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
     bool OriginateSession(const std::string& wakeWord = std::string("")) override;
+    void CancelSession() override;
     bool OpenAudioChannel();
     void CloseAudioChannel(bool notify_server = true) override;
     bool IsAudioChannelOpened() const override;
     Mqtt& getMqtt();
     virtual bool SendInitCall(const std::string& wakeWord);
     virtual bool SendFinishCall();
+    virtual bool SendCancelCall();
+    virtual void SendAudioStatistics(const AudioReceiveStatistics& stats);
 protected:
     bool SendText(const std::string& text) override;
+    bool IsSessionPending() const { return session_pending_; }
+    void OnSessionAnswered(bool success);
+    // Clears remote_sequence_ and the replay window under stats_mutex_
+    void ResetRemoteSequence();
 
     mbedtls_aes_context aes_ctx_;
     std::string aes_nonce_;
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
-    uint32_t remote_sequence_;
-    
-    EventGroupHandle_t event_group_handle_;
+    uint32_t remote_sequence_;    // Protected by stats_mutex_, subclasses reset it with ResetRemoteSequence()
+    int uplink_aggregation_ = 1;  // Frames per uplink datagram accepted by the server
+    std::mutex channel_mutex_;    // Guards the UDP channel and the encryption state above
 
 private:
 
@@ -62,16 +89,46 @@ private:
     
     std::string publish_topic_;
 
-    std::mutex channel_mutex_;
     std::unique_ptr<Mqtt> mqtt_;
     std::unique_ptr<Udp> udp_;
+    std::string send_buffer_;  // Reused datagram buffer for SendAudio, protected by channel_mutex_
+    int pending_frames_ = 0;   // Frames in send_buffer_ not yet sent, protected by channel_mutex_
+    bool first_uplink_pending_ = false;  // Wake to first uplink datagram not reported yet, protected by channel_mutex_
+    esp_timer_handle_t aggregation_timer_;
+
+    // Replay window of the incoming audio, remote_sequence_ is the newest accepted sequence
+    // and bit i of replay_window_ marks remote_sequence_ - i as seen. Protected by stats_mutex_
+    std::mutex stats_mutex_;
+    uint64_t replay_window_ = 0;
+    AudioReceiveStatistics receive_statistics_;
+    int32_t last_transit_ms_ = 0;
+    uint32_t jitter_q4_ = 0;  // Jitter in 1/16 ms
+    esp_timer_handle_t stats_timer_;
     
+    // Session resumption, protected by channel_mutex_. The ticket is single use, every resumed
+    // turn XORs a new epoch into the ssrc field of the server nonce
+    enum ResumeState { kResumeNone, kResumePending, kResumeFallback };
+    std::string resume_ticket_;
+    int64_t resume_expire_time_ = 0;
+    std::string resume_nonce_;  // Nonce of the last full hello, before the epoch is applied
+    uint32_t resume_epoch_ = 0;
+    ResumeState resume_state_ = kResumeNone;
+
     esp_timer_handle_t reconnect_timer_;
+    esp_timer_handle_t session_timer_;
+    std::atomic<bool> session_pending_ = false;
+    int64_t session_start_time_ = 0;
 
     bool StartMqttClient(bool report_error=false);
+    void FinishSession(bool success);
+    bool FlushAudio();
+    bool AcceptRemoteSequence(uint32_t sequence);
+    void ReportAudioStatistics();
+    bool ResumeSession();
+    void ParseResumeTicket(const cJSON* root);
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
-    std::string GetHelloMessage();
+    std::string GetHelloMessage(const std::string& ticket = std::string(), uint32_t epoch = 0);
 };
 
 
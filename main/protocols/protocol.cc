@@ -4,6 +4,37 @@
 
 #define TAG "Protocol"
 
+std::mutex AudioPacketPool::mutex_;
+std::vector<std::unique_ptr<AudioStreamPacket>> AudioPacketPool::packets_;
+
+std::unique_ptr<AudioStreamPacket> AudioPacketPool::Acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!packets_.empty()) {
+            auto packet = std::move(packets_.back());
+            packets_.pop_back();
+            return packet;
+        }
+    }
+    return std::make_unique<AudioStreamPacket>();
+}
+
+void AudioPacketPool::Release(std::unique_ptr<AudioStreamPacket> packet) {
+    if (packet == nullptr) {
+        return;
+    }
+    // Keep the payload capacity, only reset the contents
+    packet->sample_rate = 0;
+    packet->frame_duration = 0;
+    packet->timestamp = 0;
+    packet->payload.clear();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (packets_.size() < AUDIO_PACKET_POOL_SIZE) {
+        packets_.push_back(std::move(packet));
+    }
+}
+
 void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
@@ -32,6 +63,10 @@ void Protocol::OnDisconnected(std::function<void()> callback) {
     on_disconnected_ = callback;
 }
 
+void Protocol::OnSessionOriginated(std::function<void(bool success)> callback) {
+    on_session_originated_ = callback;
+}
+
 void Protocol::SetError(const std::string& message) {
     error_occurred_ = true;
     if (on_network_error_ != nullptr) {
@@ -73,6 +108,12 @@ void Protocol::SendStopListening() {
     SendText(message);
 }
 
+void Protocol::SendVoiceActivity(bool speaking) {
+    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"listen\",\"state\":\"vad\"";
+    message += speaking ? ",\"vad\":\"speech\"}" : ",\"vad\":\"silence\"}";
+    SendText(message);
+}
+
 void Protocol::SendMcpMessage(const std::string& payload) {
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":" + payload + "}";
     SendText(message);
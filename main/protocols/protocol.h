@@ -6,6 +6,10 @@
 #include <functional>
 #include <chrono>
 #include <vector>
+#include <memory>
+#include <mutex>
+
+#define AUDIO_PACKET_POOL_SIZE 16
 
 struct AudioStreamPacket {
     int sample_rate = 0;
@@ -14,6 +18,20 @@ struct AudioStreamPacket {
     std::vector<uint8_t> payload;
 };
 
+/*
+ * Recycles AudioStreamPacket objects together with their payload storage, so the encoder,
+ * the network receive path and the codec task do not allocate a packet for every frame.
+ */
+class AudioPacketPool {
+public:
+    static std::unique_ptr<AudioStreamPacket> Acquire();
+    static void Release(std::unique_ptr<AudioStreamPacket> packet);
+
+private:
+    static std::mutex mutex_;
+    static std::vector<std::unique_ptr<AudioStreamPacket>> packets_;
+};
+
 struct BinaryProtocol2 {
     uint16_t version;
     uint16_t type;          // Message type (0: OPUS, 1: JSON)
@@ -62,15 +80,20 @@ public:
     void OnNetworkError(std::function<void(const std::string& message)> callback);
     void OnConnected(std::function<void()> callback);
     void OnDisconnected(std::function<void()> callback);
+    void OnSessionOriginated(std::function<void(bool success)> callback);
 
     virtual bool Start(bool report_error = false) = 0;
+    // Starts the session setup without blocking, the result is reported through OnSessionOriginated
+    // on the main task. Returns false if the request could not be sent.
     virtual bool OriginateSession(const std::string& wakeWord = std::string("")) = 0;
+    virtual void CancelSession() {}
     virtual void CloseAudioChannel(bool notify_server = true) = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) = 0;
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
+    virtual void SendVoiceActivity(bool speaking);
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendMcpMessage(const std::string& message);
 
@@ -82,6 +105,7 @@ protected:
     std::function<void(const std::string& message)> on_network_error_;
     std::function<void()> on_connected_;
     std::function<void()> on_disconnected_;
+    std::function<void(bool success)> on_session_originated_;
 
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
@@ -1,7 +1,9 @@
 #include <esp_log.h>
+#include <cstring>
 #include "sip_mqtt_protocol.h"
 #include "adapter/protocol.h"
 #include "application.h"
+#include "board.h"
 #include <wifi_manager.h>
 #include "settings.h"
 #include "assets/lang_config.h"
@@ -54,6 +56,11 @@ bool SipMqttProtocol::SendFinishCall(){
     return (0 == finish_call());
 }
 
+bool SipMqttProtocol::SendCancelCall(){
+
+    return (0 == cancel_call());
+}
+
 
 void SipMqttProtocol::SendAbortSpeaking(AbortReason reason) {
     event_session_barge_in_t param = {
@@ -85,6 +92,25 @@ void SipMqttProtocol::SendStopListening() {
     send_stop_listening(AUDIO_INPUT_STOP_REASON_NONE);
 }
 
+void SipMqttProtocol::SendVoiceActivity(bool speaking) {
+    send_voice_activity(speaking);
+}
+
+void SipMqttProtocol::SendAudioStatistics(const AudioReceiveStatistics& stats) {
+    event_audio_receive_stats_t param = {
+        .network = {0},
+        .received = stats.received,
+        .lost = stats.lost,
+        .duplicates = stats.duplicates,
+        .too_old = stats.too_old,
+        .reordered = stats.reordered,
+        .max_reorder_depth = stats.max_reorder_depth,
+        .jitter_ms = stats.jitter_ms
+    };
+    strncpy(param.network, Board::GetInstance().GetBoardType().c_str(), sizeof(param.network) - 1);
+    send_audio_statistics(&param);
+}
+
 
 void SipMqttProtocol::TransmitSIPMessage(const std::string& message) {
     SendText(message);
@@ -94,8 +120,8 @@ void SipMqttProtocol::ShowErrorMessage(const std::string& message) {
     SetError(message);
 }
 
-void SipMqttProtocol::OnCallEstablished(std::string sessionId,  media_parameter_ptr mediaParam) {
-    auto& app = Application::GetInstance();
+// Must be called with channel_mutex_ held, the sequences are left to the caller
+void SipMqttProtocol::ApplyMediaParameters(const std::string& sessionId, media_parameter_ptr mediaParam) {
     session_id_ = sessionId;
     server_sample_rate_ = mediaParam->sample_rate;
     server_frame_duration_ = mediaParam->frame_duration;
@@ -106,11 +132,50 @@ void SipMqttProtocol::OnCallEstablished(std::string sessionId,  media_parameter_
 
     mbedtls_aes_init(&aes_ctx_);
     mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)mediaParam->aes_key, 128);
-    local_sequence_ = 0;
-    remote_sequence_ = 0;
+    uplink_aggregation_ = mediaParam->uplink_aggregation > 1 ? mediaParam->uplink_aggregation : 1;
+}
 
-    if (app.GetDeviceState() == kDeviceStateConnecting) {
-        xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
+void SipMqttProtocol::OnCallEstablished(std::string sessionId,  media_parameter_ptr mediaParam) {
+    auto& app = Application::GetInstance();
+    bool rekey = warm_session_;
+    warm_session_ = false;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        ApplyMediaParameters(sessionId, mediaParam);
+        local_sequence_ = 0;
+        ResetRemoteSequence();
+    }
+
+    sip_dispatch_stats_t dispatch_stats;
+    get_sip_dispatch_statistics(&dispatch_stats);
+    ESP_LOGI(TAG, "SIP dispatch latency: last %lu ms, max %lu ms, avg %lu ms over %lu messages, %lu dropped",
+        dispatch_stats.last_latency_ms, dispatch_stats.max_latency_ms,
+        dispatch_stats.dispatched > 0 ? dispatch_stats.total_latency_ms / dispatch_stats.dispatched : 0,
+        dispatch_stats.dispatched, dispatch_stats.dropped);
+    sip_arena_stats_t arena_stats;
+    get_sip_arena_statistics(&arena_stats);
+    ESP_LOGI(TAG, "SIP arena: high water mark %lu bytes, %lu heap fallbacks over %lu calls",
+        arena_stats.high_water_mark, arena_stats.fallback_allocs, arena_stats.scopes);
+    sip_timer_stats_t timer_stats;
+    get_sip_timer_statistics(&timer_stats);
+    ESP_LOGI(TAG, "Adapter timers: lateness last %lu ms, max %lu ms, avg %lu ms over %lu callbacks",
+        timer_stats.last_lateness_ms, timer_stats.max_lateness_ms,
+        timer_stats.fired > 0 ? timer_stats.total_lateness_ms / timer_stats.fired : 0,
+        timer_stats.fired);
+
+    if (rekey) {
+        // The server did not keep the parked media, reconnect with the new parameters
+        ESP_LOGW(TAG, "Parked media replaced by server, reopening audio channel");
+        app.Schedule([this]() {
+            if (IsAudioChannelOpened()) {
+                OpenAudioChannel();
+            }
+        });
+        return;
+    }
+
+    if (IsSessionPending()) {
+        OnSessionAnswered(true);
         ESP_LOGI(TAG, "@@@@@@@@@@@@SIP call established,UDP server: %s, port: %d", udp_server_.c_str(), udp_port_);
     }else{
         ESP_LOGI(TAG, "@@@@@@@@@@@@SIP call established, now to open audio channel");
@@ -122,16 +187,44 @@ void SipMqttProtocol::OnCallEstablished(std::string sessionId,  media_parameter_
     
 }
 
+uint32_t SipMqttProtocol::GetLocalSequence() {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    return local_sequence_;
+}
+
+void SipMqttProtocol::OnCallResumed(std::string sessionId, media_parameter_ptr mediaParam, uint32_t sequence) {
+    // Called while the INVITE is pending, the sequence continues from where the parked call stopped
+    // so the parked key and nonce never encrypt two frames with the same counter block
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        ApplyMediaParameters(sessionId, mediaParam);
+        local_sequence_ = sequence;
+    }
+    warm_session_ = true;
+    ESP_LOGI(TAG, "Resuming parked media, UDP server: %s, port: %d, sequence: %lu",
+        udp_server_.c_str(), udp_port_, local_sequence_);
+    if (IsSessionPending()) {
+        OnSessionAnswered(true);
+    }
+}
+
+void SipMqttProtocol::OnCallConfirmed(std::string sessionId) {
+    warm_session_ = false;
+    session_id_ = sessionId;
+    ESP_LOGI(TAG, "Resumed call confirmed, session: %s", session_id_.c_str());
+}
+
 void SipMqttProtocol::OnCallAckError(session_call_error_t error_code) {
     if (error_code == CALL_ERROR_MEMBERSHIP_INVALID){
         ESP_LOGW(TAG, "Received call ack error: membership invalid");
         ShowErrorMessage(Lang::Strings::DEVICE_MEMBERSHIP_EXPIRED);
-        xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_ALERT_EVENT);
+        OnSessionAnswered(false);
     }
 }
 
 void SipMqttProtocol::OnCallTerminatedByServer() {
     ESP_LOGI(TAG, "SIP call terminated by server");
+    warm_session_ = false;
     Application::GetInstance().Schedule([this]() {
         CloseAudioChannel(false);
     });
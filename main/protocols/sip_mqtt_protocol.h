@@ -12,18 +12,29 @@ public:
 
     bool Start(bool report_error = false) override;
     void OnCallEstablished(std::string sessionId,  media_parameter_ptr mediaParam);
+    void OnCallResumed(std::string sessionId, media_parameter_ptr mediaParam, uint32_t sequence);
+    void OnCallConfirmed(std::string sessionId);
     void OnCallAckError(session_call_error_t error_code);
     void OnCallTerminatedByServer();
     void OnCallTerminatedAck();
     virtual bool SendInitCall(const std::string& wakeWord) override;
     virtual void SendMcpMessage(const std::string& message) override;
     bool SendFinishCall() override;
+    bool SendCancelCall() override;
     void SendWakeWordDetected(const std::string& wake_word) override;
     void SendStartListening(ListeningMode mode) override;
     void SendStopListening() override;
+    void SendVoiceActivity(bool speaking) override;
+    void SendAudioStatistics(const AudioReceiveStatistics& stats) override;
     void SendAbortSpeaking(AbortReason reason) override;
     void TransmitSIPMessage(const std::string& message);
     void ShowErrorMessage(const std::string& message);
+    uint32_t GetLocalSequence();
+
+private:
+    bool warm_session_ = false;  // Streaming on parked media, the INVITE is not answered yet
+
+    void ApplyMediaParameters(const std::string& sessionId, media_parameter_ptr mediaParam);
 };
 
 
@@ -30,31 +30,77 @@ bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
         return false;
     }
 
+    if (version_ != 2 && version_ != 3) {
+        bool success = websocket_->Send(packet->payload.data(), packet->payload.size(), true);
+        AudioPacketPool::Release(std::move(packet));
+        return success;
+    }
+
+    // The transport takes a single buffer, so the header and the payload are gathered into
+    // a reused buffer, no allocation is needed once it has grown to the frame size
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    size_t header_size = version_ == 2 ? sizeof(BinaryProtocol2) : sizeof(BinaryProtocol3);
+    send_buffer_.resize(header_size + packet->payload.size());
     if (version_ == 2) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol2) + packet->payload.size());
-        auto bp2 = (BinaryProtocol2*)serialized.data();
-        bp2->version = htons(version_);
-        bp2->type = 0;
-        bp2->reserved = 0;
-        bp2->timestamp = htonl(packet->timestamp);
-        bp2->payload_size = htonl(packet->payload.size());
-        memcpy(bp2->payload, packet->payload.data(), packet->payload.size());
-
-        return websocket_->Send(serialized.data(), serialized.size(), true);
-    } else if (version_ == 3) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol3) + packet->payload.size());
-        auto bp3 = (BinaryProtocol3*)serialized.data();
-        bp3->type = 0;
-        bp3->reserved = 0;
-        bp3->payload_size = htons(packet->payload.size());
-        memcpy(bp3->payload, packet->payload.data(), packet->payload.size());
-
-        return websocket_->Send(serialized.data(), serialized.size(), true);
+        BinaryProtocol2 bp2;
+        bp2.version = htons(version_);
+        bp2.type = 0;
+        bp2.reserved = 0;
+        bp2.timestamp = htonl(packet->timestamp);
+        bp2.payload_size = htonl(packet->payload.size());
+        memcpy(&send_buffer_[0], &bp2, sizeof(bp2));
     } else {
-        return websocket_->Send(packet->payload.data(), packet->payload.size(), true);
+        BinaryProtocol3 bp3;
+        bp3.type = 0;
+        bp3.reserved = 0;
+        bp3.payload_size = htons(packet->payload.size());
+        memcpy(&send_buffer_[0], &bp3, sizeof(bp3));
     }
+    memcpy(&send_buffer_[header_size], packet->payload.data(), packet->payload.size());
+    AudioPacketPool::Release(std::move(packet));
+
+    return websocket_->Send(send_buffer_.data(), send_buffer_.size(), true);
+}
+
+// Decodes a binary frame into a pooled packet, the header is read from a copy so the
+// transport buffer is left untouched. Returns nullptr for truncated frames
+std::unique_ptr<AudioStreamPacket> WebsocketProtocol::DecodeAudioPacket(const uint8_t* data, size_t len) {
+    const uint8_t* payload = data;
+    size_t payload_size = len;
+    uint32_t timestamp = 0;
+    if (version_ == 2) {
+        BinaryProtocol2 bp2;
+        if (len < sizeof(bp2)) {
+            ESP_LOGE(TAG, "Invalid audio frame size: %u", len);
+            return nullptr;
+        }
+        memcpy(&bp2, data, sizeof(bp2));
+        timestamp = ntohl(bp2.timestamp);
+        payload_size = ntohl(bp2.payload_size);
+        payload = data + sizeof(bp2);
+        len -= sizeof(bp2);
+    } else if (version_ == 3) {
+        BinaryProtocol3 bp3;
+        if (len < sizeof(bp3)) {
+            ESP_LOGE(TAG, "Invalid audio frame size: %u", len);
+            return nullptr;
+        }
+        memcpy(&bp3, data, sizeof(bp3));
+        payload_size = ntohs(bp3.payload_size);
+        payload = data + sizeof(bp3);
+        len -= sizeof(bp3);
+    }
+    if (payload_size > len) {
+        ESP_LOGE(TAG, "Incomplete audio frame: need %u, have %u", payload_size, len);
+        return nullptr;
+    }
+
+    auto packet = AudioPacketPool::Acquire();
+    packet->sample_rate = server_sample_rate_;
+    packet->frame_duration = server_frame_duration_;
+    packet->timestamp = timestamp;
+    packet->payload.assign(payload, payload + payload_size);
+    return packet;
 }
 
 bool WebsocketProtocol::SendText(const std::string& text) {
@@ -111,37 +157,9 @@ bool WebsocketProtocol::OriginateSession(std::string const& wakeWord) {
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
         if (binary) {
             if (on_incoming_audio_ != nullptr) {
-                if (version_ == 2) {
-                    BinaryProtocol2* bp2 = (BinaryProtocol2*)data;
-                    bp2->version = ntohs(bp2->version);
-                    bp2->type = ntohs(bp2->type);
-                    bp2->timestamp = ntohl(bp2->timestamp);
-                    bp2->payload_size = ntohl(bp2->payload_size);
-                    auto payload = (uint8_t*)bp2->payload;
-                    on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = bp2->timestamp,
-                        .payload = std::vector<uint8_t>(payload, payload + bp2->payload_size)
-                    }));
-                } else if (version_ == 3) {
-                    BinaryProtocol3* bp3 = (BinaryProtocol3*)data;
-                    bp3->type = bp3->type;
-                    bp3->payload_size = ntohs(bp3->payload_size);
-                    auto payload = (uint8_t*)bp3->payload;
-                    on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = 0,
-                        .payload = std::vector<uint8_t>(payload, payload + bp3->payload_size)
-                    }));
-                } else {
-                    on_incoming_audio_(std::make_unique<AudioStreamPacket>(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = 0,
-                        .payload = std::vector<uint8_t>((uint8_t*)data, (uint8_t*)data + len)
-                    }));
+                auto packet = DecodeAudioPacket((const uint8_t*)data, len);
+                if (packet != nullptr) {
+                    on_incoming_audio_(std::move(packet));
                 }
             }
         } else {
@@ -195,6 +213,9 @@ bool WebsocketProtocol::OriginateSession(std::string const& wakeWord) {
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
     }
+    if (on_session_originated_ != nullptr) {
+        on_session_originated_(true);
+    }
 
     return true;
 }
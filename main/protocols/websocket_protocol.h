@@ -25,7 +25,10 @@ private:
     EventGroupHandle_t event_group_handle_;
     std::unique_ptr<WebSocket> websocket_;
     int version_ = 1;
+    std::mutex send_mutex_;
+    std::string send_buffer_;  // Reused frame buffer for SendAudio, protected by send_mutex_
 
+    std::unique_ptr<AudioStreamPacket> DecodeAudioPacket(const uint8_t* data, size_t len);
     void ParseServerHello(const cJSON* root);
     bool SendText(const std::string& text) override;
     std::string GetHelloMessage();
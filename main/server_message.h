@@ -0,0 +1,79 @@
+#ifndef SERVER_MESSAGE_H
+#define SERVER_MESSAGE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Server JSON message types, looked up by a perfect hash of the first two characters and the length
+enum ServerMessageType {
+    kServerMessageUnknown,
+    kServerMessageTts,
+    kServerMessageStt,
+    kServerMessageLlm,
+    kServerMessageMcp,
+    kServerMessageSystem,
+    kServerMessageAlert,
+    kServerMessageCustom,
+};
+
+struct ServerMessageName {
+    const char* name;
+    ServerMessageType type;
+};
+
+static constexpr ServerMessageName kServerMessageNames[] = {
+    {"tts", kServerMessageTts},
+    {"stt", kServerMessageStt},
+    {"llm", kServerMessageLlm},
+    {"mcp", kServerMessageMcp},
+    {"system", kServerMessageSystem},
+    {"alert", kServerMessageAlert},
+    {"custom", kServerMessageCustom},
+};
+
+static constexpr size_t kServerMessageTableSize = 16;
+
+static constexpr size_t ServerMessageHash(const char* name, size_t len) {
+    return (2 * (uint8_t)name[0] + (uint8_t)name[1] + len) & (kServerMessageTableSize - 1);
+}
+
+static constexpr size_t ConstStrlen(const char* str) {
+    size_t len = 0;
+    while (str[len] != '\0') {
+        len++;
+    }
+    return len;
+}
+
+static constexpr auto kServerMessageTable = [] {
+    std::array<ServerMessageName, kServerMessageTableSize> table{};
+    for (const auto& entry : kServerMessageNames) {
+        table[ServerMessageHash(entry.name, ConstStrlen(entry.name))] = entry;
+    }
+    return table;
+}();
+
+static constexpr bool ServerMessageHashIsPerfect() {
+    size_t used = 0;
+    for (const auto& entry : kServerMessageTable) {
+        used += entry.name != nullptr;
+    }
+    return used == sizeof(kServerMessageNames) / sizeof(kServerMessageNames[0]);
+}
+static_assert(ServerMessageHashIsPerfect(), "Server message types collide, change ServerMessageHash");
+
+inline ServerMessageType LookupServerMessage(const char* name) {
+    size_t len = strlen(name);
+    if (len < 2) {
+        return kServerMessageUnknown;
+    }
+    const auto& entry = kServerMessageTable[ServerMessageHash(name, len)];
+    if (entry.name == nullptr || strcmp(entry.name, name) != 0) {
+        return kServerMessageUnknown;
+    }
+    return entry.type;
+}
+
+#endif // SERVER_MESSAGE_H
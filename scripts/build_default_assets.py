@@ -272,10 +272,11 @@ def process_extra_files(extra_files_dir, assets_dir):
     return extra_files_list
 
 
-def generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files=None, multinet_model_info=None):
+def generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files=None, multinet_model_info=None, compress=False):
     """Generate index.json file"""
+    # version 2 表示可能包含压缩条目，旧固件会拒绝加载而不是读到错误数据
     index_data = {
-        "version": 1
+        "version": 2 if compress else 1
     }
     
     if srmodels:
@@ -339,14 +340,71 @@ def compute_checksum(data):
     return checksum
 
 
+# 不压缩的文件：srmodels 由 esp-sr 直接在映射地址上加载，index.json 需要旧固件也能读出版本号
+UNCOMPRESSED_FILES = ['srmodels.bin', 'index.json']
+# 压缩后不小于原大小的 90% 时保留原始数据
+COMPRESS_RATIO_LIMIT = 0.9
+
+
+def _lz4_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz4_compress_block(data):
+    """
+    LZ4 块格式的贪心压缩，设备端由 AssetCache::Lz4Decompress 解压
+    """
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    # 规范要求最后 5 个字节为字面量，最后一个匹配至少在末尾 12 字节之前开始
+    match_limit = n - 12
+    while i < match_limit:
+        key = data[i:i + 4]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > 0xFFFF:
+            i += 1
+            continue
+        match_len = 4
+        while i + match_len < n - 5 and data[candidate + match_len] == data[i + match_len]:
+            match_len += 1
+
+        literal_len = i - anchor
+        token_match = min(match_len - 4, 15)
+        out.append((min(literal_len, 15) << 4) | token_match)
+        if literal_len >= 15:
+            _lz4_length(out, literal_len - 15)
+        out += data[anchor:i]
+        out += (i - candidate).to_bytes(2, byteorder='little')
+        if match_len - 4 >= 15:
+            _lz4_length(out, match_len - 4 - 15)
+        i += match_len
+        anchor = i
+
+    literal_len = n - anchor
+    out.append(min(literal_len, 15) << 4)
+    if literal_len >= 15:
+        _lz4_length(out, literal_len - 15)
+    out += data[anchor:]
+    return bytes(out)
+
+
 def sort_key(filename):
     basename, extension = os.path.splitext(filename)
     return extension, basename
 
 
-def pack_assets_simple(target_path, include_path, out_file, assets_path, max_name_len=32):
+def pack_assets_simple(target_path, include_path, out_file, assets_path, max_name_len=32, compress=False):
     """
-    Simplified version of pack_assets that handles basic file packing
+    Simplified version of pack_assets that handles basic file packing.
+    With compress, entries are stored as 'ZL' + original size + LZ4 block
+    when that saves enough space.
     """
     merged_data = bytearray()
     file_info_list = []
@@ -368,17 +426,29 @@ def pack_assets_simple(target_path, include_path, out_file, assets_path, max_nam
         file_name = os.path.basename(file_path)
         file_size = os.path.getsize(file_path)
 
-        file_info_list.append((file_name, len(merged_data), file_size, 0, 0))
-        # Add 0x5A5A prefix to merged_data
-        merged_data.extend(b'\x5A' * 2)
-
         with open(file_path, 'rb') as bin_file:
             bin_data = bin_file.read()
 
+        if compress and file_name not in UNCOMPRESSED_FILES and len(bin_data) > 0:
+            compressed = lz4_compress_block(bin_data)
+            if len(compressed) + 4 < len(bin_data) * COMPRESS_RATIO_LIMIT:
+                print(f"Compressed {file_name}: {len(bin_data)} -> {len(compressed) + 4} bytes")
+                file_info_list.append((file_name, len(merged_data), len(compressed) + 4, 0, 0))
+                merged_data.extend(b'ZL')
+                merged_data.extend(len(bin_data).to_bytes(4, byteorder='little'))
+                merged_data.extend(compressed)
+                continue
+
+        file_info_list.append((file_name, len(merged_data), file_size, 0, 0))
+        # Add 0x5A5A prefix to merged_data
+        merged_data.extend(b'\x5A' * 2)
         merged_data.extend(bin_data)
 
     total_files = len(file_info_list)
 
+    # 文件表按名称字节序排序（数据区顺序不变），设备端直接在映射的文件表上二分查找
+    file_info_list.sort(key=lambda info: info[0].ljust(max_name_len, '\0')[:max_name_len].encode('utf-8'))
+
     mmap_table = bytearray()
     for file_name, offset, file_size, width, height in file_info_list:
         if len(file_name) > max_name_len:
@@ -507,6 +577,20 @@ def read_multinet_from_sdkconfig(sdkconfig_path):
     return models
 
 
+def read_spiram_from_sdkconfig(sdkconfig_path):
+    """
+    Read whether PSRAM is enabled from sdkconfig
+    """
+    if not os.path.exists(sdkconfig_path):
+        return False
+
+    with io.open(sdkconfig_path, "r") as f:
+        for line in f:
+            if line.strip() == 'CONFIG_SPIRAM=y':
+                return True
+    return False
+
+
 def read_wake_word_type_from_sdkconfig(sdkconfig_path):
     """
     Read wake word type configuration from sdkconfig
@@ -698,7 +782,7 @@ def get_emoji_collection_path(default_emoji_collection, xiaozhi_fonts_path):
         return None
 
 
-def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font_path, emoji_collection_path, extra_files_path, output_path, multinet_model_info=None):
+def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font_path, emoji_collection_path, extra_files_path, output_path, multinet_model_info=None, compress=False):
     """
     Build assets using integrated functions (no external dependencies)
     """
@@ -722,7 +806,7 @@ def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font
         extra_files = process_extra_files(extra_files_path, assets_dir) if extra_files_path else None
         
         # Generate index.json
-        generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files, multinet_model_info)
+        generate_index_json(assets_dir, srmodels, text_font, emoji_collection, extra_files, multinet_model_info, compress)
         
         # Generate config.json for packing
         config_path = generate_config_json(temp_build_dir, assets_dir)
@@ -734,7 +818,7 @@ def build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font
         # Use simplified packing function
         include_path = config_data['include_path']
         image_file = config_data['image_file']
-        pack_assets_simple(assets_dir, include_path, image_file, "assets", int(config_data['name_length']))
+        pack_assets_simple(assets_dir, include_path, image_file, "assets", int(config_data['name_length']), compress)
         
         # Copy final assets.bin to output location
         if os.path.exists(image_file):
@@ -768,6 +852,7 @@ def main():
     parser.add_argument('--esp_sr_model_path', help='Path to ESP-SR model directory')
     parser.add_argument('--xiaozhi_fonts_path', help='Path to xiaozhi-fonts component directory')
     parser.add_argument('--extra_files', help='Path to extra files directory to be included in assets')
+    parser.add_argument('--compress', action='store_true', help='Compress fonts and images with LZ4, decoded on first use')
     
     args = parser.parse_args()
     
@@ -789,6 +874,12 @@ def main():
     print(f"  emoji_collection: {args.emoji_collection}")
     print(f"  output: {args.output}")
     
+    # Decompressed fonts and images stay in RAM until the pack is unmapped,
+    # without PSRAM they would take the internal heap
+    if args.compress and not read_spiram_from_sdkconfig(args.sdkconfig):
+        print("Error: --compress requires PSRAM (CONFIG_SPIRAM=y) on the target")
+        sys.exit(1)
+
     # Read wake word type configuration from sdkconfig
     wake_word_config = read_wake_word_type_from_sdkconfig(args.sdkconfig)
     
@@ -870,7 +961,7 @@ def main():
     
     # Build the assets
     success = build_assets_integrated(wakenet_model_paths, multinet_model_paths, text_font_path, emoji_collection_path, 
-                                     extra_files_path, args.output, multinet_model_info)
+                                     extra_files_path, args.output, multinet_model_info, args.compress)
     
     if not success:
         sys.exit(1)
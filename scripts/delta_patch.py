@@ -0,0 +1,170 @@
+#! /usr/bin/env python3
+"""
+生成增量固件补丁，设备端由 main/delta_patcher.cc 流式还原。
+
+用法:
+    python scripts/delta_patch.py old.bin new.bin patch.bin
+
+依赖 bsdiff4 (pip install bsdiff4)。bsdiff 输出的三个 bz2 数据块需要整体解压、
+随机访问，不适合在设备上边下载边写入，这里把它们重新编排成按记录交错的流式格式，
+add 块中大量的 0 用游程编码压缩。格式说明见 main/delta_patcher.h。
+
+服务端在 OTA 检查版本的响应中下发:
+    "firmware": {
+        "version": "...", "url": "<完整固件>",
+        "delta": {"url": "<补丁>", "base": "<旧固件 elf_sha256>", "sha256": "<补丁文件 sha256>"}
+    }
+base 与设备上报的 application.elf_sha256 一致时设备才会尝试增量升级，失败则回退到完整固件。
+"""
+import argparse
+import bz2
+import hashlib
+import struct
+import sys
+
+import bsdiff4
+
+MAGIC = b"XZD1"
+# esp_image_header_t 中 hash_appended 字段的偏移
+HASH_APPENDED_OFFSET = 23
+
+
+def image_sha256(image):
+    """与 esp_partition_get_sha256() 对 app 分区的结果一致"""
+    if image[HASH_APPENDED_OFFSET] != 1:
+        sys.exit("base image has no appended SHA-256 digest")
+    return image[-32:]
+
+
+def offtin(buf):
+    value = int.from_bytes(buf[:7], "little") | ((buf[7] & 0x7F) << 56)
+    return -value if buf[7] & 0x80 else value
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def encode_add(block):
+    """add 块编码为 (0 的游程, 字面量长度, 字面量) 序列，始终成对出现"""
+    out = bytearray()
+    i, n = 0, len(block)
+    while i < n:
+        start = i
+        while i < n and block[i] == 0:
+            i += 1
+        zero_run = i - start
+        start = i
+        # 短的 0 游程并入字面量，避免频繁切换
+        while i < n and (block[i] != 0 or block[i:i + 4].count(0) < min(4, n - i)):
+            i += 1
+        out += varint(zero_run) + varint(i - start) + block[start:i]
+    return bytes(out)
+
+
+def convert(bsdiff_patch, base, new):
+    if bsdiff_patch[:8] != b"BSDIFF40":
+        sys.exit("unexpected bsdiff output")
+    ctrl_len = offtin(bsdiff_patch[8:16])
+    diff_len = offtin(bsdiff_patch[16:24])
+    new_size = offtin(bsdiff_patch[24:32])
+    pos = 32
+    ctrl = bz2.decompress(bsdiff_patch[pos:pos + ctrl_len])
+    pos += ctrl_len
+    diff = bz2.decompress(bsdiff_patch[pos:pos + diff_len])
+    pos += diff_len
+    extra = bz2.decompress(bsdiff_patch[pos:])
+
+    out = bytearray(MAGIC)
+    out += struct.pack("<III", new_size, len(base), 0)
+    out += image_sha256(base)
+
+    diff_pos = extra_pos = 0
+    for i in range(0, len(ctrl), 24):
+        add_len = offtin(ctrl[i:i + 8])
+        extra_len = offtin(ctrl[i + 8:i + 16])
+        seek = offtin(ctrl[i + 16:i + 24])
+        out += varint(add_len) + varint(extra_len) + varint(zigzag(seek))
+        out += encode_add(diff[diff_pos:diff_pos + add_len])
+        out += extra[extra_pos:extra_pos + extra_len]
+        diff_pos += add_len
+        extra_pos += extra_len
+    return bytes(out)
+
+
+def apply(patch, base):
+    """与设备端相同的还原逻辑，用于生成后自检"""
+    new_size, base_size, _ = struct.unpack_from("<III", patch, 4)
+    pos, base_pos, out = 48, 0, bytearray()
+
+    def read_varint():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = patch[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def base_byte(offset):
+        return base[offset] if 0 <= offset < base_size else 0
+
+    while len(out) < new_size:
+        add_len, extra_len, seek = read_varint(), read_varint(), read_varint()
+        seek = (seek >> 1) ^ -(seek & 1)
+        while add_len > 0:
+            zero_run = read_varint()
+            for _ in range(zero_run):
+                out.append(base_byte(base_pos))
+                base_pos += 1
+            literal_len = read_varint()
+            for b in patch[pos:pos + literal_len]:
+                out.append((base_byte(base_pos) + b) & 0xFF)
+                base_pos += 1
+            pos += literal_len
+            add_len -= zero_run + literal_len
+        out += patch[pos:pos + extra_len]
+        pos += extra_len
+        base_pos += seek
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a streaming delta firmware patch")
+    parser.add_argument("base", help="firmware currently running on the device")
+    parser.add_argument("new", help="firmware to upgrade to")
+    parser.add_argument("output", help="patch file")
+    parser.add_argument("--no-verify", action="store_true", help="skip applying the patch after generation")
+    args = parser.parse_args()
+
+    with open(args.base, "rb") as f:
+        base = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    patch = convert(bsdiff4.diff(base, new), base, new)
+    if not args.no_verify and apply(patch, base) != new:
+        sys.exit("patch verification failed")
+
+    with open(args.output, "wb") as f:
+        f.write(patch)
+    print(f"base {len(base)} bytes, new {len(new)} bytes, patch {len(patch)} bytes "
+          f"({len(patch) * 100 / len(new):.1f}%), sha256 {hashlib.sha256(patch).hexdigest()}")
+
+
+if __name__ == "__main__":
+    main()
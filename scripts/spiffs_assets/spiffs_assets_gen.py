@@ -440,6 +440,9 @@ def pack_assets(config: PackModelsConfig):
 
     total_files = len(file_info_list)
 
+    # 文件表按名称字节序排序（数据区顺序不变），设备端直接在映射的文件表上二分查找
+    file_info_list.sort(key=lambda info: info[0].ljust(int(max_name_len), '\0')[:int(max_name_len)].encode('utf-8'))
+
     mmap_table = bytearray()
     for file_name, offset, file_size, width, height in file_info_list:
         if len(file_name) > int(max_name_len):
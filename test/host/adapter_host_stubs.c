@@ -0,0 +1,40 @@
+/*
+ * Host replacements for the adapter functions used by the pure SIP code
+ * (osip_adapter.c, sip_arena.c, sip_lite_parser.c). JSON builders are not
+ * exercised by the host benchmarks and return NULL.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "adapter/adapter.h"
+
+void adatper_log(sip_log_level_t level, const char* tag, const char* format, ...){
+    (void)level;
+    (void)tag;
+    (void)format;
+}
+
+uint32_t adapter_get_system_ms(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void* adapter_get_current_task(void){
+    static int s_task;
+    return &s_task;
+}
+
+void* adapter_malloc_large(size_t size){
+    return malloc(size);
+}
+
+void* adapter_create_json_object(){ return NULL; }
+void adapter_delete_json_object(void* obj){ (void)obj; }
+void* adapter_json_object_new_int(int value){ (void)value; return NULL; }
+void* adapter_json_object_new_boolean(bool value){ (void)value; return NULL; }
+void adapter_put_json_object_value(void* root, char* key, void* obj){ (void)root; (void)key; (void)obj; }
+void* adapter_put_json_string_value(void* obj, const char* key, const char* value){ (void)key; (void)value; return obj; }
+char* adapter_serialize_json_to_string(void* obj){ (void)obj; return NULL; }
@@ -0,0 +1,148 @@
+/*
+ * Compares asset lookup on the mapped file table with the std::map index it
+ * replaced: lookup cost for a sorted table (binary search), an unsorted one
+ * from an older packer (linear scan) and the map, plus the heap the map took.
+ * The table is laid out like the packer writes it, for an emoji theme with
+ * fonts and models, at two pack sizes.
+ *
+ *   make asset_lookup_bench && ./asset_lookup_bench
+ */
+#include "assets_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BENCH_LOOKUPS   2000000
+
+static size_t s_heap_bytes;
+static long s_heap_allocs;
+
+void* operator new(size_t size) {
+    s_heap_bytes += size;
+    s_heap_allocs++;
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+// The index the strategy used to build at init
+struct Asset {
+    size_t size;
+    size_t offset;
+};
+
+static const char* const kEmotions[] = {
+    "neutral", "happy", "laughing", "funny", "sad", "angry", "crying", "loving", "embarrassed",
+    "surprised", "shocked", "thinking", "winking", "cool", "relaxed", "delicious", "kissy",
+    "confident", "sleepy", "silly", "confused",
+};
+
+static std::vector<std::string> PackNames(int variants) {
+    std::vector<std::string> names = {
+        "index.json", "srmodels.bin", "font_puhui_basic_16_4.bin", "font_puhui_basic_20_4.bin",
+        "font_awesome_20_4.bin", "background.png", "background_dark.png",
+    };
+    for (const char* emotion : kEmotions) {
+        names.push_back(std::string(emotion) + ".png");
+        for (int i = 1; i < variants; i++) {
+            names.push_back(std::string(emotion) + "_" + std::to_string(i * 32) + ".gif");
+        }
+    }
+    return names;
+}
+
+struct Pack {
+    std::vector<mmap_assets_table> table;
+    bool sorted;
+};
+
+static Pack BuildPack(const std::vector<std::string>& names, bool sorted) {
+    Pack pack{std::vector<mmap_assets_table>(names.size()), sorted};
+    uint32_t offset = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        auto& entry = pack.table[i];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.asset_name, names[i].c_str(), sizeof(entry.asset_name));
+        entry.asset_size = 1000 + i;
+        entry.asset_offset = offset;
+        offset += entry.asset_size + 2;
+    }
+    if (sorted) {
+        // Same order as the packers: the raw bytes of the NUL-padded name
+        std::sort(pack.table.begin(), pack.table.end(), [](const mmap_assets_table& a, const mmap_assets_table& b) {
+            return memcmp(a.asset_name, b.asset_name, sizeof(a.asset_name)) < 0;
+        });
+    }
+    return pack;
+}
+
+template <typename Fn>
+static double NanosecondsPerLookup(const std::vector<std::string>& queries, Fn&& lookup, size_t& found) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) {
+        found += lookup(queries[i % queries.size()]);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_LOOKUPS;
+}
+
+int main() {
+    int failures = 0;
+    printf("%-8s %12s %12s %12s %14s\n", "entries", "sorted ns", "linear ns", "map ns", "map heap");
+    for (int variants : {1, 4, 12}) {
+        auto names = PackNames(variants);
+        auto sorted = BuildPack(names, true);
+        auto unsorted = BuildPack(names, false);
+        if (!IsAssetTableSorted(sorted.table.data(), sorted.table.size()) ||
+            IsAssetTableSorted(unsorted.table.data(), unsorted.table.size())) {
+            fprintf(stderr, "%zu entries: sort detection failed\n", names.size());
+            failures++;
+        }
+
+        size_t heap_bytes = s_heap_bytes;
+        long heap_allocs = s_heap_allocs;
+        auto* index = new std::map<std::string, Asset>();
+        for (const auto& entry : unsorted.table) {
+            (*index)[entry.asset_name] = Asset{entry.asset_size, entry.asset_offset};
+        }
+        heap_bytes = s_heap_bytes - heap_bytes;
+        heap_allocs = s_heap_allocs - heap_allocs;
+
+        // Startup lookups in random order, with a few names the theme asks for but the pack lacks
+        std::vector<std::string> queries = names;
+        queries.push_back("missing.png");
+        queries.push_back("font_puhui_basic_30_4.bin");
+        std::shuffle(queries.begin(), queries.end(), std::mt19937(1));
+
+        size_t found_sorted = 0, found_linear = 0, found_map = 0;
+        double sorted_ns = NanosecondsPerLookup(queries, [&](const std::string& name) {
+            return FindAssetInTable(sorted.table.data(), sorted.table.size(), true, name) != nullptr;
+        }, found_sorted);
+        double linear_ns = NanosecondsPerLookup(queries, [&](const std::string& name) {
+            return FindAssetInTable(unsorted.table.data(), unsorted.table.size(), false, name) != nullptr;
+        }, found_linear);
+        double map_ns = NanosecondsPerLookup(queries, [&](const std::string& name) {
+            return index->find(name) != index->end();
+        }, found_map);
+        if (found_sorted != found_map || found_linear != found_map) {
+            fprintf(stderr, "%zu entries: found %zu sorted, %zu linear, %zu in the map\n",
+                names.size(), found_sorted, found_linear, found_map);
+            failures++;
+        }
+        delete index;
+
+        printf("%-8zu %12.1f %12.1f %12.1f %7zu B/%3ld\n", names.size(), sorted_ns, linear_ns, map_ns, heap_bytes, heap_allocs);
+    }
+    printf("map heap is bytes requested / allocations, allocator headers come on top\n");
+    return failures == 0 ? 0 : 1;
+}
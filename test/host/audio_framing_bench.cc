@@ -0,0 +1,217 @@
+/*
+ * Measures WebsocketProtocol audio framing for protocol versions 1, 2 and 3:
+ * frames/s and heap allocations per frame for SendAudio and for decoding
+ * received binary frames, next to the previous per-frame std::string and
+ * std::vector framing. The protocol sources are built against stubs/.
+ *
+ *   make audio_framing_bench && ./audio_framing_bench
+ */
+#include "websocket_protocol.h"
+#include "settings.h"
+#include "board.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+
+#define BENCH_FRAMES    200000
+#define PAYLOAD_MIN     40
+#define PAYLOAD_MAX     200
+
+// Heap allocations made through operator new while a measurement is running
+static long s_heap_allocs;
+
+void* operator new(size_t size) {
+    s_heap_allocs++;
+    void* ptr = malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+struct Result {
+    double frames_per_second;
+    double allocs_per_frame;
+};
+
+template <typename Fn>
+static Result Measure(Fn&& fn) {
+    long allocs = s_heap_allocs;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        fn(i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {BENCH_FRAMES / seconds, (double)(s_heap_allocs - allocs) / BENCH_FRAMES};
+}
+
+static uint8_t s_payload[PAYLOAD_MAX];
+
+static size_t PayloadSize(int i) {
+    return PAYLOAD_MIN + (i * 37) % (PAYLOAD_MAX - PAYLOAD_MIN);
+}
+
+// Previous SendAudio: a fresh packet from the encoder and a fresh serialized frame per send
+static void LegacySend(WebSocket& websocket, int version, int i) {
+    auto packet = std::make_unique<AudioStreamPacket>();
+    packet->timestamp = i;
+    packet->payload.assign(s_payload, s_payload + PayloadSize(i));
+    if (version == 2) {
+        std::string serialized;
+        serialized.resize(sizeof(BinaryProtocol2) + packet->payload.size());
+        auto bp2 = (BinaryProtocol2*)serialized.data();
+        bp2->version = htons(version);
+        bp2->type = 0;
+        bp2->reserved = 0;
+        bp2->timestamp = htonl(packet->timestamp);
+        bp2->payload_size = htonl(packet->payload.size());
+        memcpy(bp2->payload, packet->payload.data(), packet->payload.size());
+        websocket.Send(serialized.data(), serialized.size(), true);
+    } else if (version == 3) {
+        std::string serialized;
+        serialized.resize(sizeof(BinaryProtocol3) + packet->payload.size());
+        auto bp3 = (BinaryProtocol3*)serialized.data();
+        bp3->type = 0;
+        bp3->reserved = 0;
+        bp3->payload_size = htons(packet->payload.size());
+        memcpy(bp3->payload, packet->payload.data(), packet->payload.size());
+        websocket.Send(serialized.data(), serialized.size(), true);
+    } else {
+        websocket.Send(packet->payload.data(), packet->payload.size(), true);
+    }
+}
+
+// Previous receive path: a new packet and payload vector per frame. The header is read
+// in place without the old byte swap, which would corrupt the reused frame
+static std::unique_ptr<AudioStreamPacket> LegacyDecode(int version, const char* data, size_t len) {
+    if (version == 2) {
+        auto bp2 = (const BinaryProtocol2*)data;
+        auto payload = (const uint8_t*)bp2->payload;
+        return std::make_unique<AudioStreamPacket>(AudioStreamPacket{
+            .sample_rate = 24000,
+            .frame_duration = 60,
+            .timestamp = ntohl(bp2->timestamp),
+            .payload = std::vector<uint8_t>(payload, payload + ntohl(bp2->payload_size))
+        });
+    } else if (version == 3) {
+        auto bp3 = (const BinaryProtocol3*)data;
+        auto payload = (const uint8_t*)bp3->payload;
+        return std::make_unique<AudioStreamPacket>(AudioStreamPacket{
+            .sample_rate = 24000,
+            .frame_duration = 60,
+            .timestamp = 0,
+            .payload = std::vector<uint8_t>(payload, payload + ntohs(bp3->payload_size))
+        });
+    }
+    return std::make_unique<AudioStreamPacket>(AudioStreamPacket{
+        .sample_rate = 24000,
+        .frame_duration = 60,
+        .timestamp = 0,
+        .payload = std::vector<uint8_t>((const uint8_t*)data, (const uint8_t*)data + len)
+    });
+}
+
+static std::string BuildFrame(int version, size_t payload_size) {
+    std::string frame;
+    if (version == 2) {
+        BinaryProtocol2 bp2 = {htons(2), 0, 0, htonl(1234), htonl(payload_size)};
+        frame.assign((const char*)&bp2, sizeof(bp2));
+    } else if (version == 3) {
+        BinaryProtocol3 bp3 = {0, 0, htons(payload_size)};
+        frame.assign((const char*)&bp3, sizeof(bp3));
+    }
+    frame.append((const char*)s_payload, payload_size);
+    return frame;
+}
+
+int main() {
+    for (size_t i = 0; i < sizeof(s_payload); i++) {
+        s_payload[i] = (uint8_t)(i * 7);
+    }
+
+    printf("%d frames per run, payload %d-%d bytes\n", BENCH_FRAMES, PAYLOAD_MIN, PAYLOAD_MAX);
+    printf("%-8s %-10s %14s %14s\n", "version", "path", "frames/s", "allocs/frame");
+    int failures = 0;
+    for (int version = 1; version <= 3; version++) {
+        Settings("websocket").SetInt("version", version);
+        WebsocketProtocol protocol;
+        size_t received = 0;
+        protocol.OnIncomingAudio([&received](std::unique_ptr<AudioStreamPacket> packet) {
+            received += packet->payload.size();
+            AudioPacketPool::Release(std::move(packet));
+        });
+        if (!protocol.OriginateSession("")) {
+            fprintf(stderr, "version %d: session setup failed\n", version);
+            return 1;
+        }
+        WebSocket& websocket = *Board::GetInstance().GetNetwork()->last_websocket_;
+
+        // Warm up the pool and the send buffer, as after the first frames on the device
+        for (int i = 0; i < AUDIO_PACKET_POOL_SIZE; i++) {
+            auto packet = AudioPacketPool::Acquire();
+            packet->payload.reserve(PAYLOAD_MAX);
+            AudioPacketPool::Release(std::move(packet));
+        }
+
+        auto send = Measure([&](int i) {
+            auto packet = AudioPacketPool::Acquire();
+            packet->timestamp = i;
+            packet->payload.assign(s_payload, s_payload + PayloadSize(i));
+            protocol.SendAudio(std::move(packet));
+        });
+        WebSocket legacy_websocket;
+        legacy_websocket.Connect("");
+        auto legacy_send = Measure([&](int i) {
+            LegacySend(legacy_websocket, version, i);
+        });
+        if (websocket.sent_bytes_ - 2 != legacy_websocket.sent_bytes_) {
+            // 2 bytes are the "{}" hello from the stub cJSON
+            fprintf(stderr, "version %d: framed sizes differ, %zu vs %zu bytes\n",
+                version, websocket.sent_bytes_ - 2, legacy_websocket.sent_bytes_);
+            failures++;
+        }
+
+        std::string frames[8];
+        for (int i = 0; i < 8; i++) {
+            frames[i] = BuildFrame(version, PayloadSize(i));
+        }
+        auto receive = Measure([&](int i) {
+            const std::string& frame = frames[i % 8];
+            websocket.Receive(frame.data(), frame.size(), true);
+        });
+        // Same dispatch as the real OnData handler: a std::function hop and a timestamp per frame
+        size_t legacy_received = 0;
+        std::chrono::steady_clock::time_point last_incoming_time;
+        std::function<void(std::unique_ptr<AudioStreamPacket>)> legacy_on_audio =
+            [&legacy_received](std::unique_ptr<AudioStreamPacket> packet) {
+                legacy_received += packet->payload.size();
+            };
+        std::function<void(const char*, size_t, bool)> legacy_on_data =
+            [&](const char* data, size_t len, bool binary) {
+                legacy_on_audio(LegacyDecode(version, data, len));
+                last_incoming_time = std::chrono::steady_clock::now();
+            };
+        auto legacy_receive = Measure([&](int i) {
+            const std::string& frame = frames[i % 8];
+            legacy_on_data(frame.data(), frame.size(), true);
+        });
+        if (received != legacy_received) {
+            fprintf(stderr, "version %d: decoded %zu bytes, previous path %zu\n", version, received, legacy_received);
+            failures++;
+        }
+
+        printf("%-8d %-10s %14.0f %14.2f\n", version, "send", send.frames_per_second, send.allocs_per_frame);
+        printf("%-8d %-10s %14.0f %14.2f\n", version, "send-old", legacy_send.frames_per_second, legacy_send.allocs_per_frame);
+        printf("%-8d %-10s %14.0f %14.2f\n", version, "recv", receive.frames_per_second, receive.allocs_per_frame);
+        printf("%-8d %-10s %14.0f %14.2f\n", version, "recv-old", legacy_receive.frames_per_second, legacy_receive.allocs_per_frame);
+        protocol.CloseAudioChannel();
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/*
+ * Runs DownloadPipeline against a simulated link and flash and compares it with
+ * the previous OTA loop, which read 512 bytes and wrote them on the same task.
+ * The link only buffers a TCP window while nobody reads, so a sector erase on
+ * the downloading task stalls the sender. Further runs cut the connection at
+ * fixed offsets, with and without Range support, and check that the written
+ * image and its SHA-256 match.
+ *
+ * Timings are 8x a 4G link (128 KB/s) and SPI NOR flash (25 ms per 4 KB
+ * sector erase, 640 KB/s programming), so each run takes about a second.
+ *
+ *   make download_pipeline_bench && ./download_pipeline_bench
+ */
+#include "download_pipeline.h"
+#include "http_pool.h"
+#include "board.h"
+
+#include <openssl/sha.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#define IMAGE_SIZE          (1024 * 1024)
+#define NETWORK_RATE        (1024 * 1024)   // Bytes per second
+#define TCP_WINDOW          5744            // lwIP default receive window
+#define READ_SIZE_MAX       4096            // One TLS record per read at most
+#define FLASH_SECTOR_SIZE   4096
+#define FLASH_ERASE_US      3125            // Per sector
+#define FLASH_PROGRAM_RATE  (5 * 1024 * 1024)
+#define IMAGE_URL           "https://ota.example.com/firmware.bin"
+
+using Clock = std::chrono::steady_clock;
+
+// Delivers bytes at a fixed rate, at most a window ahead of the reader
+class Link {
+public:
+    void Receive(size_t bytes) {
+        auto now = Clock::now();
+        auto window_time = std::chrono::microseconds(TCP_WINDOW * 1000000ULL / NETWORK_RATE);
+        if (next_ < now - window_time) {
+            next_ = now - window_time;
+        }
+        next_ += std::chrono::microseconds(bytes * 1000000ULL / NETWORK_RATE);
+        std::this_thread::sleep_until(next_);
+    }
+
+private:
+    Clock::time_point next_;
+};
+
+// Erases each sector on first write like esp_ota_write, then programs the data
+class Flash {
+public:
+    explicit Flash(size_t size) : data_(size), erased_((size + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE) {}
+    bool Write(const uint8_t* data, size_t length, size_t offset) {
+        if (offset + length > data_.size()) {
+            return false;
+        }
+        int64_t busy_us = length * 1000000LL / FLASH_PROGRAM_RATE;
+        for (size_t sector = offset / FLASH_SECTOR_SIZE; sector <= (offset + length - 1) / FLASH_SECTOR_SIZE; sector++) {
+            if (!erased_[sector]) {
+                erased_[sector] = true;
+                busy_us += FLASH_ERASE_US;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(busy_us));
+        memcpy(data_.data() + offset, data, length);
+        return true;
+    }
+    const std::vector<uint8_t>& data() const { return data_; }
+
+private:
+    std::vector<uint8_t> data_;
+    std::vector<bool> erased_;
+};
+
+struct ServerConfig {
+    bool range_supported = true;
+    std::set<size_t> drop_at;  // Image offsets where the connection is cut, each once
+};
+
+static std::vector<uint8_t> s_image;
+static ServerConfig s_server;
+static int s_connections;
+
+class SimulatedHttp : public Http {
+public:
+    void SetTimeout(int timeout_ms) override {}
+    void SetHeader(const std::string& key, const std::string& value) override {
+        if (key == "Range") {
+            range_start_ = strtoul(value.c_str() + strlen("bytes="), nullptr, 10);
+        }
+    }
+    void SetContent(std::string&& content) override {}
+    bool Open(const std::string& method, const std::string& url) override {
+        s_connections++;
+        position_ = s_server.range_supported ? range_start_ : 0;
+        status_code_ = s_server.range_supported && range_start_ > 0 ? 206 : 200;
+        range_start_ = 0;
+        return true;
+    }
+    void Close() override {}
+    int Read(char* buffer, size_t buffer_size) override {
+        size_t length = std::min({buffer_size, (size_t)READ_SIZE_MAX, s_image.size() - position_});
+        auto drop = s_server.drop_at.lower_bound(position_);
+        if (drop != s_server.drop_at.end()) {
+            if (*drop == position_) {
+                s_server.drop_at.erase(drop);
+                return -1;
+            }
+            length = std::min(length, *drop - position_);
+        }
+        if (length == 0) {
+            return 0;
+        }
+        link_.Receive(length);
+        memcpy(buffer, s_image.data() + position_, length);
+        position_ += length;
+        return (int)length;
+    }
+    int GetStatusCode() override { return status_code_; }
+    size_t GetBodyLength() override { return s_image.size() - position_; }
+
+private:
+    Link link_;
+    size_t range_start_ = 0;
+    size_t position_ = 0;
+    int status_code_ = 0;
+};
+
+static std::string Sha256Hex(const uint8_t* data, size_t length) {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256(data, length, digest);
+    char hex[sizeof(digest) * 2 + 1];
+    for (size_t i = 0; i < sizeof(digest); i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+    return hex;
+}
+
+struct RunResult {
+    bool success;
+    double seconds;
+    bool image_matches;
+};
+
+static RunResult RunPipeline(const std::string& expected_sha256) {
+    Flash flash(s_image.size());
+    DownloadPipeline pipeline;
+    pipeline.SetExpectedSha256(expected_sha256);
+    auto start = Clock::now();
+    bool success = pipeline.Run(IMAGE_URL, [&flash](const uint8_t* data, size_t length, size_t offset) {
+        return flash.Write(data, length, offset);
+    }, nullptr);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return {success, seconds, flash.data() == s_image};
+}
+
+// The previous Ota::Upgrade loop: 512-byte reads, each written before the next read
+static RunResult RunSerial() {
+    Flash flash(s_image.size());
+    SimulatedHttp http;
+    auto start = Clock::now();
+    http.Open("GET", IMAGE_URL);
+    uint8_t buffer[512];
+    size_t offset = 0;
+    while (offset < s_image.size()) {
+        int ret = http.Read((char*)buffer, sizeof(buffer));
+        if (ret <= 0 || !flash.Write(buffer, ret, offset)) {
+            break;
+        }
+        offset += ret;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return {offset == s_image.size(), seconds, flash.data() == s_image};
+}
+
+static bool Report(const char* name, const RunResult& result, bool expect_success) {
+    bool ok = result.success == expect_success && (!expect_success || result.image_matches);
+    printf("%-32s %-7s %6.2f s %8.0f KB/s %4d connections%s\n", name, result.success ? "ok" : "failed",
+        result.seconds, IMAGE_SIZE / 1024.0 / result.seconds, s_connections, ok ? "" : "  UNEXPECTED");
+    s_connections = 0;
+    return ok;
+}
+
+int main() {
+    std::mt19937 rng(42);
+    s_image.resize(IMAGE_SIZE);
+    for (auto& byte : s_image) {
+        byte = (uint8_t)rng();
+    }
+    auto sha256 = Sha256Hex(s_image.data(), s_image.size());
+    Board::GetInstance().GetNetwork()->http_factory_ = [](int connect_id) {
+        return std::make_unique<SimulatedHttp>();
+    };
+
+    printf("%d KB image, link %d KB/s with a %d byte window, flash %d us per sector erase and %d KB/s programming\n",
+        IMAGE_SIZE / 1024, NETWORK_RATE / 1024, TCP_WINDOW, FLASH_ERASE_US, FLASH_PROGRAM_RATE / 1024);
+    int failures = 0;
+    failures += !Report("serial 512-byte loop", RunSerial(), true);
+    failures += !Report("pipeline", RunPipeline(sha256), true);
+
+    s_server.drop_at = {300 * 1024, 700 * 1024, 1000 * 1024};
+    failures += !Report("pipeline, 3 drops, Range", RunPipeline(sha256), true);
+    s_server.range_supported = false;
+    s_server.drop_at = {300 * 1024, 700 * 1024, 1000 * 1024};
+    failures += !Report("pipeline, 3 drops, no Range", RunPipeline(sha256), true);
+
+    s_server = ServerConfig();
+    failures += !Report("pipeline, wrong SHA-256", RunPipeline(std::string(64, '0')), false);
+    return failures == 0 ? 0 : 1;
+}
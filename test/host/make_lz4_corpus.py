@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Writes inputs for lz4_decode_bench: each <name>.raw is compressed with the
+asset packer's lz4_compress_block into <name>.zl, laid out like a compressed
+pack entry after the "ZL" magic (original size u32 LE + LZ4 block).
+
+Usage: make_lz4_corpus.py <output_dir> [extra files...]
+"""
+import os
+import random
+import struct
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', '..', 'scripts'))
+from build_default_assets import lz4_compress_block
+
+
+def glyphs_4bpp(size, rng):
+    # Anti-aliased glyph bitmaps: mostly blank pixels, short runs of shades
+    out = bytearray()
+    while len(out) < size:
+        out += bytes(rng.randint(2, 24))
+        out += bytes(rng.choice((0x0f, 0xf0, 0xff, 0x8f, 0xf8, 0x48)) for _ in range(rng.randint(1, 6)))
+    return bytes(out[:size])
+
+
+def rgb565_image(size, rng):
+    # Flat areas and gradients, like a rendered emoji on a solid background
+    out = bytearray()
+    color = 0
+    while len(out) < size:
+        if rng.random() < 0.6:
+            out += struct.pack('<H', color) * rng.randint(4, 64)
+        else:
+            for _ in range(rng.randint(4, 32)):
+                color = (color + rng.randint(1, 3)) & 0xffff
+                out += struct.pack('<H', color)
+    return bytes(out[:size])
+
+
+def repeats(size, rng, copy_probability):
+    # Random literals with back references, copy_probability sets the ratio
+    out = bytearray()
+    while len(out) < size:
+        if len(out) > 64 and rng.random() < copy_probability:
+            start = rng.randint(max(0, len(out) - 4096), len(out) - 16)
+            out += out[start:start + rng.randint(4, 64)]
+        else:
+            out += bytes(rng.getrandbits(8) for _ in range(rng.randint(1, 8)))
+    return bytes(out[:size])
+
+
+def main():
+    output_dir = sys.argv[1]
+    os.makedirs(output_dir, exist_ok=True)
+    rng = random.Random(1)
+    size = 256 * 1024
+    inputs = {
+        'glyphs_4bpp': glyphs_4bpp(size, rng),
+        'rgb565_image': rgb565_image(size, rng),
+        'repeats_90': repeats(size, rng, 0.9),
+        'repeats_70': repeats(size, rng, 0.7),
+        'repeats_40': repeats(size, rng, 0.4),
+        'random': bytes(rng.getrandbits(8) for _ in range(size)),
+    }
+    for path in sys.argv[2:]:
+        with open(path, 'rb') as f:
+            inputs[os.path.basename(path).replace('.', '_')] = f.read()
+
+    for name, data in inputs.items():
+        with open(os.path.join(output_dir, name + '.raw'), 'wb') as f:
+            f.write(data)
+        with open(os.path.join(output_dir, name + '.zl'), 'wb') as f:
+            f.write(struct.pack('<I', len(data)) + lz4_compress_block(data))
+
+
+if __name__ == '__main__':
+    main()
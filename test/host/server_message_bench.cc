@@ -0,0 +1,82 @@
+/*
+ * Compares LookupServerMessage with the strcmp chain it replaced in
+ * Application's OnIncomingJson handler, over a message mix weighted like a
+ * chat turn: mostly tts and llm, some stt and mcp, a few unknown types.
+ *
+ *   make server_message_bench && ./server_message_bench
+ */
+#include "server_message.h"
+
+#include <chrono>
+#include <cstdio>
+
+#define BENCH_MESSAGES  20000000
+
+// Order of the previous if/else chain
+static ServerMessageType LookupServerMessageChain(const char* name) {
+    if (strcmp(name, "tts") == 0) {
+        return kServerMessageTts;
+    } else if (strcmp(name, "stt") == 0) {
+        return kServerMessageStt;
+    } else if (strcmp(name, "llm") == 0) {
+        return kServerMessageLlm;
+    } else if (strcmp(name, "mcp") == 0) {
+        return kServerMessageMcp;
+    } else if (strcmp(name, "system") == 0) {
+        return kServerMessageSystem;
+    } else if (strcmp(name, "alert") == 0) {
+        return kServerMessageAlert;
+    } else if (strcmp(name, "custom") == 0) {
+        return kServerMessageCustom;
+    }
+    return kServerMessageUnknown;
+}
+
+static const char* const kMix[] = {
+    "tts", "tts", "tts", "tts", "tts", "tts", "tts", "tts",
+    "llm", "llm", "stt", "mcp", "mcp", "system", "hello", "goodbye",
+};
+static constexpr size_t kMixSize = sizeof(kMix) / sizeof(kMix[0]);
+
+template <typename Fn>
+static double MessagesPerSecond(Fn&& lookup, unsigned& checksum) {
+    // Names are copied out of the table so the compiler cannot fold the comparisons
+    static char names[kMixSize][16];
+    for (size_t i = 0; i < kMixSize; i++) {
+        strcpy(names[i], kMix[i]);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_MESSAGES; i++) {
+        checksum += lookup(names[i % kMixSize]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return BENCH_MESSAGES / seconds;
+}
+
+int main() {
+    static const char* const kNames[] = {
+        "tts", "stt", "llm", "mcp", "system", "alert", "custom",
+        "", "t", "ttsx", "tt", "hello", "goodbye", "syste", "Tts", "alerts",
+    };
+    int failures = 0;
+    for (const char* name : kNames) {
+        if (LookupServerMessage(name) != LookupServerMessageChain(name)) {
+            fprintf(stderr, "Lookup of \"%s\" differs from the strcmp chain\n", name);
+            failures++;
+        }
+    }
+
+    unsigned table_checksum = 0, chain_checksum = 0;
+    double table = MessagesPerSecond(LookupServerMessage, table_checksum);
+    double chain = MessagesPerSecond(LookupServerMessageChain, chain_checksum);
+    if (table_checksum != chain_checksum) {
+        fprintf(stderr, "Checksums differ: %u vs %u\n", table_checksum, chain_checksum);
+        failures++;
+    }
+
+    printf("%d lookups over a %zu-message mix, table of %zu slots (%zu bytes)\n",
+        BENCH_MESSAGES, kMixSize, kServerMessageTable.size(), sizeof(kServerMessageTable));
+    printf("%-12s %14.0f msg/s %8.1f ns/msg\n", "hash table", table, 1e9 / table);
+    printf("%-12s %14.0f msg/s %8.1f ns/msg\n", "strcmp chain", chain, 1e9 / chain);
+    return failures == 0 ? 0 : 1;
+}
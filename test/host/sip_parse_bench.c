@@ -0,0 +1,166 @@
+/*
+ * Compares the span-based SIP parser with the osip fallback on the messages
+ * in sip_corpus/: both paths must agree on every field the session layer
+ * reads, then each path is timed and its heap allocations are counted.
+ *
+ *   make sip_parse_bench && ./sip_parse_bench sip_corpus
+ */
+#include "sip/osip_adapter.c"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS    20000
+#define CORPUS_MAX          64
+
+// Heap allocations made by the code under test, counted through ld --wrap
+static long s_heap_allocs;
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size){ s_heap_allocs++; return __real_malloc(size); }
+void *__wrap_calloc(size_t count, size_t size){ s_heap_allocs++; return __real_calloc(count, size); }
+void *__wrap_realloc(void *ptr, size_t size){ s_heap_allocs++; return __real_realloc(ptr, size); }
+
+typedef sip_ret_t (*parse_fn)(const char *raw_msg, size_t msg_len, received_sip_message_ptr *msg_info);
+
+typedef struct {
+    char name[64];
+    char *data;
+    size_t len;
+} corpus_entry_t;
+
+static corpus_entry_t s_corpus[CORPUS_MAX];
+static int s_corpus_count;
+
+static int load_corpus(const char *dir_path){
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        perror(dir_path);
+        return -1;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL && s_corpus_count < CORPUS_MAX) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir_path, ent->d_name);
+        FILE *f = fopen(path, "rb");
+        if (!f) {
+            continue;
+        }
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        corpus_entry_t *entry = &s_corpus[s_corpus_count];
+        entry->data = __real_malloc((size_t)len + 1);
+        entry->len = fread(entry->data, 1, (size_t)len, f);
+        entry->data[entry->len] = '\0';
+        fclose(f);
+        snprintf(entry->name, sizeof(entry->name), "%s", ent->d_name);
+        s_corpus_count++;
+    }
+    closedir(dir);
+    return s_corpus_count > 0 ? 0 : -1;
+}
+
+// Compares the fields the session layer reads, returns the number of mismatches
+static int compare_messages(const char *name, received_sip_message_ptr lite, received_sip_message_ptr osip){
+    int mismatches = 0;
+#define CHECK_STR(field) \
+    if (strcmp(lite->field, osip->field) != 0) { \
+        printf("  %s: " #field " differs\n    lite: %s\n    osip: %s\n", name, lite->field, osip->field); \
+        mismatches++; \
+    }
+#define CHECK_INT(field) \
+    if (lite->field != osip->field) { \
+        printf("  %s: " #field " differs, lite %d, osip %d\n", name, (int)lite->field, (int)osip->field); \
+        mismatches++; \
+    }
+    CHECK_STR(method);
+    CHECK_INT(status_code);
+    CHECK_INT(x_reason_code);
+    CHECK_STR(x_envelope);
+    CHECK_STR(reason_phrase);
+    CHECK_INT(cseq_num);
+    CHECK_STR(call_id);
+    CHECK_STR(from_header);
+    CHECK_STR(to_header);
+    CHECK_STR(via_header);
+    CHECK_STR(call_id_header);
+    CHECK_STR(cseq_header);
+    CHECK_STR(contact_header);
+    CHECK_STR(content_type);
+    CHECK_INT(body_length);
+    if (lite->body_length == osip->body_length &&
+        memcmp(lite->message_body, osip->message_body, lite->body_length) != 0) {
+        printf("  %s: message_body differs\n", name);
+        mismatches++;
+    }
+#undef CHECK_STR
+#undef CHECK_INT
+    return mismatches;
+}
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const char *label, parse_fn parse){
+    long parsed = 0, rejected = 0;
+    size_t bytes = 0;
+    s_heap_allocs = 0;
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int j = 0; j < s_corpus_count; j++) {
+            received_sip_message_ptr message = NULL;
+            if (parse(s_corpus[j].data, s_corpus[j].len, &message) == RET_OK) {
+                parsed++;
+                free(message);
+            } else {
+                rejected++;
+            }
+            bytes += s_corpus[j].len;
+        }
+    }
+    double elapsed = now_seconds() - start;
+    long total = parsed + rejected;
+    printf("%-6s %10.0f msg/s %8.1f MB/s %6.2f heap allocs/msg (%ld parsed, %ld rejected)\n",
+        label, total / elapsed, bytes / elapsed / 1e6, (double)s_heap_allocs / total, parsed, rejected);
+}
+
+int main(int argc, char **argv){
+    const char *corpus_dir = argc > 1 ? argv[1] : "sip_corpus";
+    if (load_corpus(corpus_dir) != 0) {
+        fprintf(stderr, "No messages in %s\n", corpus_dir);
+        return 1;
+    }
+    init_sip();
+
+    int mismatches = 0;
+    printf("Differential check on %d messages\n", s_corpus_count);
+    for (int j = 0; j < s_corpus_count; j++) {
+        received_sip_message_ptr lite = NULL, osip = NULL;
+        sip_ret_t lite_ret = sip_parse_incoming_message_lite(s_corpus[j].data, s_corpus[j].len, &lite);
+        sip_ret_t osip_ret = sip_parse_incoming_message_osip(s_corpus[j].data, s_corpus[j].len, &osip);
+        if (lite_ret != RET_OK) {
+            printf("  %s: lite rejected, osip %s\n", s_corpus[j].name, osip_ret == RET_OK ? "parsed" : "rejected");
+        } else if (osip_ret != RET_OK) {
+            printf("  %s: lite parsed a message osip rejects\n", s_corpus[j].name);
+            mismatches++;
+        } else {
+            mismatches += compare_messages(s_corpus[j].name, lite, osip);
+        }
+        free(lite);
+        free(osip);
+    }
+
+    printf("\n%d iterations over the corpus\n", BENCH_ITERATIONS);
+    bench("lite", sip_parse_incoming_message_lite);
+    bench("osip", sip_parse_incoming_message_osip);
+    return mismatches == 0 ? 0 : 1;
+}
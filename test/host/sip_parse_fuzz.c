@@ -0,0 +1,141 @@
+/*
+ * Differential fuzz target for the span-based SIP parser and the osip
+ * fallback. Any input must be handled without memory errors, and when both
+ * parsers accept it they must agree on the fields that drive the session
+ * state machine. Builds as a libFuzzer target with -DSIP_FUZZ_LIBFUZZER,
+ * otherwise as a standalone driver that mutates the files of sip_corpus/:
+ *
+ *   clang -fsanitize=fuzzer,address -DSIP_FUZZ_LIBFUZZER ... && ./sip_parse_fuzz sip_corpus
+ *   make sip_parse_fuzz && ./sip_parse_fuzz sip_corpus 200000
+ */
+#include "sip/osip_adapter.c"
+
+#include <dirent.h>
+#include <stdio.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size){
+    static int initialized = 0;
+    if (!initialized) {
+        initialized = 1;
+        init_sip();
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    // Exact-size copy so reads past the message are caught by the sanitizer
+    char *raw = malloc(size);
+    memcpy(raw, data, size);
+
+    received_sip_message_ptr lite = NULL, osip = NULL;
+    sip_ret_t lite_ret = sip_parse_incoming_message_lite(raw, size, &lite);
+    sip_ret_t osip_ret = sip_parse_incoming_message_osip(raw, size, &osip);
+    if (lite_ret == RET_OK && osip_ret == RET_OK) {
+        if (strcmp(lite->method, osip->method) != 0 ||
+            lite->status_code != osip->status_code ||
+            lite->cseq_num != osip->cseq_num ||
+            strcmp(lite->call_id, osip->call_id) != 0) {
+            fprintf(stderr, "Parsers disagree: method %s/%s, status %d/%d, cseq %d/%d, call-id %s/%s\n",
+                lite->method, osip->method, lite->status_code, osip->status_code,
+                lite->cseq_num, osip->cseq_num, lite->call_id, osip->call_id);
+            abort();
+        }
+    }
+    free(lite);
+    free(osip);
+    free(raw);
+    return 0;
+}
+
+#ifndef SIP_FUZZ_LIBFUZZER
+
+#define CORPUS_MAX      64
+#define MUTATION_MAX    4096
+
+static uint32_t s_rand_state = 0x12345678;
+
+static uint32_t next_rand(void){
+    s_rand_state ^= s_rand_state << 13;
+    s_rand_state ^= s_rand_state >> 17;
+    s_rand_state ^= s_rand_state << 5;
+    return s_rand_state;
+}
+
+// Byte flips, CR/LF/colon insertion, deletion and truncation, the edits that break header framing
+static size_t mutate(uint8_t *buf, size_t len, size_t cap){
+    static const uint8_t specials[] = {'\r', '\n', ':', ' ', ';', '@', '0', '9', 0};
+    int edits = 1 + next_rand() % 4;
+    for (int i = 0; i < edits && len > 0; i++) {
+        size_t pos = next_rand() % len;
+        switch (next_rand() % 5) {
+        case 0:
+            buf[pos] ^= (uint8_t)(1 << (next_rand() % 8));
+            break;
+        case 1:
+            buf[pos] = specials[next_rand() % sizeof(specials)];
+            break;
+        case 2:
+            if (len < cap) {
+                memmove(buf + pos + 1, buf + pos, len - pos);
+                buf[pos] = specials[next_rand() % sizeof(specials)];
+                len++;
+            }
+            break;
+        case 3:
+            memmove(buf + pos, buf + pos + 1, len - pos - 1);
+            len--;
+            break;
+        default:
+            len = pos + 1;
+            break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char **argv){
+    const char *corpus_dir = argc > 1 ? argv[1] : "sip_corpus";
+    long iterations = argc > 2 ? atol(argv[2]) : 100000;
+
+    static uint8_t corpus[CORPUS_MAX][MUTATION_MAX];
+    static size_t corpus_len[CORPUS_MAX];
+    int count = 0;
+    DIR *dir = opendir(corpus_dir);
+    if (!dir) {
+        perror(corpus_dir);
+        return 1;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL && count < CORPUS_MAX) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", corpus_dir, ent->d_name);
+        FILE *f = fopen(path, "rb");
+        if (!f) {
+            continue;
+        }
+        corpus_len[count] = fread(corpus[count], 1, MUTATION_MAX, f);
+        fclose(f);
+        LLVMFuzzerTestOneInput(corpus[count], corpus_len[count]);
+        count++;
+    }
+    closedir(dir);
+    if (count == 0) {
+        fprintf(stderr, "No messages in %s\n", corpus_dir);
+        return 1;
+    }
+
+    static uint8_t buf[MUTATION_MAX];
+    for (long i = 0; i < iterations; i++) {
+        int index = next_rand() % count;
+        memcpy(buf, corpus[index], corpus_len[index]);
+        size_t len = mutate(buf, corpus_len[index], sizeof(buf));
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+    printf("%ld mutated inputs from %d seeds, no crash or disagreement\n", iterations, count);
+    return 0;
+}
+
+#endif
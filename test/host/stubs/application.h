@@ -0,0 +1,16 @@
+// Host stand-in: the protocols under test need the audio constants, the HTTP
+// pool schedules work on the main task, which on the host runs it in place
+#pragma once
+
+#include <functional>
+
+#define OPUS_FRAME_DURATION_MS 60
+
+class Application {
+public:
+    static Application& GetInstance() {
+        static Application instance;
+        return instance;
+    }
+    void Schedule(std::function<void()>&& callback) { callback(); }
+};
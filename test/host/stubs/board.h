@@ -0,0 +1,37 @@
+// Host board: hands out connections made by the test and remembers the last WebSocket
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <http.h>
+#include <web_socket.h>
+
+class NetworkInterface {
+public:
+    std::unique_ptr<Http> CreateHttp(int connect_id) {
+        return http_factory_ ? http_factory_(connect_id) : nullptr;
+    }
+    std::function<std::unique_ptr<Http>(int connect_id)> http_factory_;
+
+    std::unique_ptr<WebSocket> CreateWebSocket(int) {
+        auto websocket = std::make_unique<WebSocket>();
+        last_websocket_ = websocket.get();
+        return websocket;
+    }
+    WebSocket* last_websocket_ = nullptr;
+};
+
+class Board {
+public:
+    static Board& GetInstance() {
+        static Board instance;
+        return instance;
+    }
+    NetworkInterface* GetNetwork() { return &network_; }
+    std::string GetUuid() { return "host"; }
+
+private:
+    NetworkInterface network_;
+};
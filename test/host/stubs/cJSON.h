@@ -0,0 +1,29 @@
+// Host stand-in for cJSON: enough to compile the protocols, building and parsing do nothing
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+inline cJSON* cJSON_Parse(const char*) { return nullptr; }
+inline cJSON* cJSON_CreateObject() { return nullptr; }
+inline void cJSON_Delete(cJSON*) {}
+inline cJSON* cJSON_GetObjectItem(const cJSON*, const char*) { return nullptr; }
+inline bool cJSON_IsString(const cJSON* item) { return item != nullptr; }
+inline bool cJSON_IsNumber(const cJSON* item) { return item != nullptr; }
+inline bool cJSON_IsObject(const cJSON* item) { return item != nullptr; }
+inline cJSON* cJSON_AddStringToObject(cJSON*, const char*, const char*) { return nullptr; }
+inline cJSON* cJSON_AddNumberToObject(cJSON*, const char*, double) { return nullptr; }
+inline cJSON* cJSON_AddBoolToObject(cJSON*, const char*, bool) { return nullptr; }
+inline bool cJSON_AddItemToObject(cJSON*, const char*, cJSON*) { return true; }
+inline char* cJSON_PrintUnformatted(const cJSON*) { return strdup("{}"); }
+inline void cJSON_free(void* ptr) { free(ptr); }
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+
+inline void* heap_caps_malloc(size_t size, unsigned caps) { return malloc(size); }
+inline void* heap_caps_calloc(size_t count, size_t size, unsigned caps) { return calloc(count, size); }
+inline void heap_caps_free(void* ptr) { free(ptr); }
@@ -0,0 +1,43 @@
+// Host esp_timer: the clock is real, timers only track their state and never fire,
+// no host test runs long enough to reach one
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <esp_err.h>
+
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    bool active;
+};
+typedef struct esp_timer* esp_timer_handle_t;
+
+inline int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    *out = new esp_timer{*args, false};
+    return ESP_OK;
+}
+inline esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) { timer->active = true; return ESP_OK; }
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) { timer->active = true; return ESP_OK; }
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) { timer->active = false; return ESP_OK; }
+inline esp_err_t esp_timer_delete(esp_timer_handle_t timer) { delete timer; return ESP_OK; }
+inline bool esp_timer_is_active(esp_timer_handle_t timer) { return timer->active; }
@@ -0,0 +1,12 @@
+// Host stand-in for the FreeRTOS types used by the code under test
+#pragma once
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define portMAX_DELAY       UINT32_MAX
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
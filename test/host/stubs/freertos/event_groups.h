@@ -0,0 +1,23 @@
+// Host event group: a plain bit mask, nothing runs concurrently so every wait succeeds at once
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef uint32_t EventBits_t;
+typedef EventBits_t* EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate() { return new EventBits_t(0); }
+inline void vEventGroupDelete(EventGroupHandle_t group) { delete group; }
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) { return *group |= bits; }
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t old = *group;
+    *group &= ~bits;
+    return old;
+}
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t) {
+    EventBits_t set = *group | bits;
+    if (clear) {
+        *group &= ~bits;
+    }
+    return set;
+}
@@ -0,0 +1,59 @@
+// Host FreeRTOS queue: fixed-size items copied in and out under a mutex
+#pragma once
+
+#include "FreeRTOS.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct HostQueue {
+    size_t length;
+    size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+typedef HostQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(size_t length, size_t item_size) {
+    return new HostQueue{length, item_size};
+}
+inline void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+// Waits for pred under the queue lock, portMAX_DELAY waits forever
+template <typename Pred>
+inline bool HostQueueWait(std::unique_lock<std::mutex>& lock, QueueHandle_t queue, TickType_t ticks, Pred pred) {
+    if (ticks == portMAX_DELAY) {
+        queue->changed.wait(lock, pred);
+        return true;
+    }
+    return queue->changed.wait_for(lock, std::chrono::milliseconds(ticks), pred);
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!HostQueueWait(lock, queue, ticks, [queue] { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    auto bytes = (const uint8_t*)item;
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!HostQueueWait(lock, queue, ticks, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    if (queue->item_size > 0) {
+        memcpy(item, queue->items.front().data(), queue->item_size);
+    }
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
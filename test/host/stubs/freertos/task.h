@@ -0,0 +1,21 @@
+// Host FreeRTOS tasks run as detached threads. Delays are shortened 1000x,
+// the code under test only uses them for retry back-off
+#pragma once
+
+#include "FreeRTOS.h"
+
+#include <chrono>
+#include <thread>
+
+typedef void (*TaskFunction_t)(void* arg);
+typedef void* TaskHandle_t;
+
+#define pdPASS  pdTRUE
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+    int priority, TaskHandle_t* handle) {
+    std::thread(function, arg).detach();
+    return pdPASS;
+}
+inline void vTaskDelete(TaskHandle_t task) {}
+inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::microseconds(ticks)); }
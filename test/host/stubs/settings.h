@@ -0,0 +1,33 @@
+// Host settings: a process-wide map instead of NVS
+#pragma once
+
+#include <map>
+#include <string>
+
+class Settings {
+public:
+    Settings(const std::string& ns, bool read_write = false) : ns_(ns) {}
+
+    std::string GetString(const std::string& key, const std::string& default_value = "") {
+        auto it = Strings().find(ns_ + "." + key);
+        return it == Strings().end() ? default_value : it->second;
+    }
+    int GetInt(const std::string& key, int default_value = 0) {
+        auto it = Ints().find(ns_ + "." + key);
+        return it == Ints().end() ? default_value : it->second;
+    }
+    void SetString(const std::string& key, const std::string& value) { Strings()[ns_ + "." + key] = value; }
+    void SetInt(const std::string& key, int value) { Ints()[ns_ + "." + key] = value; }
+
+private:
+    std::string ns_;
+
+    static std::map<std::string, std::string>& Strings() {
+        static std::map<std::string, std::string> values;
+        return values;
+    }
+    static std::map<std::string, int>& Ints() {
+        static std::map<std::string, int> values;
+        return values;
+    }
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+class SystemInfo {
+public:
+    static std::string GetMacAddress() { return "00:00:00:00:00:00"; }
+};
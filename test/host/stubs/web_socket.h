@@ -0,0 +1,34 @@
+// Host WebSocket: connects immediately, counts what is sent and lets the test inject received frames
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+class WebSocket {
+public:
+    bool Connect(const char*) { connected_ = true; return true; }
+    bool IsConnected() const { return connected_; }
+    int GetLastError() const { return 0; }
+    void SetHeader(const char*, const char*) {}
+    void OnData(std::function<void(const char* data, size_t len, bool binary)> callback) { on_data_ = callback; }
+    void OnDisconnected(std::function<void()> callback) { on_disconnected_ = callback; }
+
+    bool Send(const std::string& text) { return Send(text.data(), text.size(), false); }
+    bool Send(const void* data, size_t len, bool binary = false, bool fin = true) {
+        sent_frames_++;
+        sent_bytes_ += len;
+        return connected_;
+    }
+
+    // Test hook: deliver a frame as if it came from the server
+    void Receive(const char* data, size_t len, bool binary) { on_data_(data, len, binary); }
+
+    size_t sent_frames_ = 0;
+    size_t sent_bytes_ = 0;
+
+private:
+    bool connected_ = false;
+    std::function<void(const char* data, size_t len, bool binary)> on_data_;
+    std::function<void()> on_disconnected_;
+};